@@ -0,0 +1,612 @@
+/**
+ * @brief Open-loop load generator for UCall servers, built on io_uring.
+ *
+ * Unlike `bench.py`, which sends the next request only after the previous reply,
+ * requests here arrive on a fixed schedule at the target rate, regardless of how fast
+ * the server replies. Latency is measured from the intended arrival time, so a server
+ * stall delays every request scheduled during it, instead of silently pausing the client.
+ * That avoids the "coordinated omission" of closed-loop drivers. The time from the actual
+ * send is also reported, as the "service time".
+ *
+ * Every thread owns an io_uring and a slice of the connections and of the target rate.
+ * Each connection carries one request at a time, so a reply is never delayed by the ones pipelined before it.
+ * Arrivals that find all connections busy wait in a backlog, still accumulating latency.
+ * Results are printed to `stdout` as a single JSON object.
+ *
+ * TLS connections don't verify the server certificate, as this is a benchmark.
+ */
+#include <netdb.h>       // `getaddrinfo`
+#include <netinet/in.h>  // `IPPROTO_TCP`
+#include <netinet/tcp.h> // `TCP_NODELAY`
+#include <poll.h>        // `poll`
+#include <sys/socket.h>  // `send`, `recv`
+#include <time.h>        // `clock_gettime`
+#include <unistd.h>      // `close`
+
+#include <cerrno>  // `errno`
+#include <cstdio>  // `std::printf`
+#include <random>  // `std::exponential_distribution`
+#include <string>  // `std::string`
+#include <thread>  // `std::thread`
+#include <vector>  // `std::vector`
+
+#include <cxxopts.hpp>
+#include <liburing.h>
+#include <picohttpparser.h>
+#include <picotls.h>
+#include <picotls/openssl.h>
+
+#include "containers.hpp"
+#include "histogram.hpp"
+
+using namespace unum::ucall;
+
+static constexpr std::size_t recv_chunk_k = 16 * 1024;
+static constexpr std::size_t max_http_headers_k = 32;
+
+static std::uint64_t now_ns() noexcept {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1'000'000'000ull + ts.tv_nsec;
+}
+
+struct bench_config_t {
+    std::string hostname;
+    int port{};
+    bool use_http{};
+    bool ssl{};
+    std::size_t connections{};
+    std::size_t threads{};
+    double rate{};
+    double duration_seconds{};
+    double warmup_seconds{};
+    double timeout_seconds{};
+    bool poisson{};
+    /// @brief The whole request, including the HTTP headers or the NULL-terminator.
+    std::string request;
+    sockaddr_storage address{};
+    socklen_t address_length{};
+    ptls_context_t ssl_context{};
+};
+
+struct bench_connection_t {
+    int descriptor = -1;
+    bool busy = false;
+    std::uint64_t intended_ns = 0;
+    std::uint64_t sent_ns = 0;
+
+    /// @brief Points either to the shared plain-text request or to `encrypted`.
+    char const* output = nullptr;
+    std::size_t output_length = 0;
+    std::size_t output_sent = 0;
+    array_gt<char> encrypted;
+
+    /// @brief Plain-text reply, accumulated across `recv` calls.
+    array_gt<char> input;
+    ptls_t* tls_context = nullptr;
+    /// @brief Last received chunk, that is ciphertext with TLS.
+    char received[recv_chunk_k];
+
+    void close_socket() noexcept {
+        if (descriptor >= 0)
+            ::close(descriptor);
+        descriptor = -1;
+        if (tls_context)
+            ptls_free(tls_context);
+        tls_context = nullptr;
+        busy = false;
+        input.pop_back(input.size());
+    }
+};
+
+struct bench_worker_t {
+    bench_config_t const* config{};
+    std::size_t connections_count{};
+    double rate{};
+    /// @brief Arrivals scheduled before this moment belong to the warm-up, and aren't counted.
+    std::uint64_t measure_from_ns{};
+
+    histogram_t latency;
+    histogram_t service_time;
+    std::size_t requests{};
+    std::size_t responses{};
+    std::size_t errors{};
+    std::size_t timeouts{};
+    std::size_t reconnects{};
+    std::size_t failed_connections{};
+    std::size_t bytes_sent{};
+    std::size_t bytes_received{};
+};
+
+#pragma region Connections
+
+static int send_all(int descriptor, void const* data, std::size_t length) noexcept {
+    char const* begin = static_cast<char const*>(data);
+    while (length) {
+        ssize_t sent = send(descriptor, begin, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return -1;
+        begin += sent, length -= sent;
+    }
+    return 0;
+}
+
+/**
+ * @brief Blocking TLS 1.3 handshake, done before the measurement starts.
+ */
+static bool handshake(bench_config_t const& config, bench_connection_t& connection) noexcept {
+    connection.tls_context = ptls_new(const_cast<ptls_context_t*>(&config.ssl_context), 0);
+    if (!connection.tls_context)
+        return false;
+    ptls_set_server_name(connection.tls_context, config.hostname.c_str(), 0);
+
+    std::uint8_t small_buffer[ram_page_size_k];
+    ptls_buffer_t outgoing;
+    ptls_buffer_init(&outgoing, small_buffer, sizeof(small_buffer));
+    int result = ptls_handshake(connection.tls_context, &outgoing, nullptr, nullptr, nullptr);
+    while (result == PTLS_ERROR_IN_PROGRESS) {
+        if (send_all(connection.descriptor, outgoing.base, outgoing.off) != 0)
+            break;
+        outgoing.off = 0;
+        ssize_t received = recv(connection.descriptor, connection.received, recv_chunk_k, 0);
+        if (received <= 0)
+            break;
+        std::size_t offset = 0;
+        while (offset != static_cast<std::size_t>(received) && result == PTLS_ERROR_IN_PROGRESS) {
+            std::size_t consumed = received - offset;
+            result =
+                ptls_handshake(connection.tls_context, &outgoing, connection.received + offset, &consumed, nullptr);
+            offset += consumed;
+        }
+    }
+    if (result == 0 && outgoing.off)
+        result = send_all(connection.descriptor, outgoing.base, outgoing.off);
+    ptls_buffer_dispose(&outgoing);
+    return result == 0;
+}
+
+/**
+ * @brief Blocking connection establishment, done before the measurement starts, or after a failure.
+ */
+static bool connect(bench_config_t const& config, bench_connection_t& connection) noexcept {
+    connection.close_socket();
+    int descriptor = socket(config.address.ss_family, SOCK_STREAM, IPPROTO_TCP);
+    if (descriptor < 0)
+        return false;
+    int no_delay = 1;
+    setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    connection.descriptor = descriptor;
+    if (::connect(descriptor, (sockaddr const*)&config.address, config.address_length) != 0 ||
+        (config.ssl && !handshake(config, connection))) {
+        connection.close_socket();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks if the @p input contains a complete reply.
+ * @return Zero if more bytes are needed, one for a successful reply, two for an error reply or a malformed one.
+ */
+static int check_reply(bool use_http, std::string_view input) noexcept {
+    std::string_view body;
+    if (!use_http) {
+        std::size_t terminator = input.find('\0');
+        if (terminator == std::string_view::npos)
+            return 0;
+        body = input.substr(0, terminator);
+        return body.find("\"error\"") == std::string_view::npos ? 1 : 2;
+    }
+
+    int minor_version, status;
+    char const* message;
+    std::size_t message_length;
+    phr_header headers[max_http_headers_k];
+    std::size_t headers_count = max_http_headers_k;
+    int headers_length = phr_parse_response(input.data(), input.size(), &minor_version, &status, &message,
+                                            &message_length, headers, &headers_count, 0);
+    if (headers_length == -2)
+        return 0;
+    if (headers_length < 0)
+        return 2;
+    std::size_t content_length = 0;
+    for (std::size_t i = 0; i != headers_count; ++i)
+        if (headers[i].name_len == 14 && strncasecmp(headers[i].name, "Content-Length", 14) == 0)
+            content_length = std::strtoull(headers[i].value, nullptr, 10);
+    if (input.size() < headers_length + content_length)
+        return 0;
+    body = input.substr(headers_length, content_length);
+    return status == 200 && body.find("\"error\"") == std::string_view::npos ? 1 : 2;
+}
+
+#pragma endregion Connections
+
+#pragma region Event Loop
+
+static void* user_data(std::size_t connection_idx, bool is_recv) noexcept {
+    return reinterpret_cast<void*>(static_cast<std::uintptr_t>((connection_idx << 1) | is_recv));
+}
+
+static void submit_recv(io_uring& uring, bench_connection_t& connection, std::size_t connection_idx) noexcept {
+    io_uring_sqe* uring_sqe = io_uring_get_sqe(&uring);
+    io_uring_prep_recv(uring_sqe, connection.descriptor, connection.received, recv_chunk_k, 0);
+    io_uring_sqe_set_data(uring_sqe, user_data(connection_idx, true));
+}
+
+/**
+ * @brief Submits the unsent part of the request, linked with a `recv` for the reply.
+ * If the `send` is short, the linked `recv` is cancelled and this is called again.
+ */
+static void submit_exchange(io_uring& uring, bench_connection_t& connection, std::size_t connection_idx) noexcept {
+    io_uring_sqe* uring_sqe = io_uring_get_sqe(&uring);
+    io_uring_prep_send(uring_sqe, connection.descriptor, connection.output + connection.output_sent,
+                       connection.output_length - connection.output_sent, MSG_NOSIGNAL);
+    io_uring_sqe_set_data(uring_sqe, user_data(connection_idx, false));
+    io_uring_sqe_set_flags(uring_sqe, IOSQE_IO_LINK);
+    submit_recv(uring, connection, connection_idx);
+}
+
+/**
+ * @brief Starts sending the request, that was meant to arrive at @p intended_ns, over an idle connection.
+ */
+static bool start_request(bench_worker_t& worker, io_uring& uring, bench_connection_t& connection,
+                          std::size_t connection_idx, std::uint64_t intended_ns) noexcept {
+    bench_config_t const& config = *worker.config;
+    connection.busy = true;
+    connection.intended_ns = intended_ns;
+    connection.sent_ns = now_ns();
+    connection.output_sent = 0;
+    connection.input.pop_back(connection.input.size());
+    if (!connection.tls_context) {
+        connection.output = config.request.data();
+        connection.output_length = config.request.size();
+        submit_exchange(uring, connection, connection_idx);
+        return true;
+    }
+
+    // Every TLS record is bound to a sequence number, so the request has to be encrypted every time.
+    std::uint8_t small_buffer[ram_page_size_k];
+    ptls_buffer_t encrypted;
+    ptls_buffer_init(&encrypted, small_buffer, sizeof(small_buffer));
+    connection.encrypted.pop_back(connection.encrypted.size());
+    bool encrypted_ok = ptls_send(connection.tls_context, &encrypted, config.request.data(), config.request.size()) ==
+                            0 &&
+                        connection.encrypted.append_n((char const*)encrypted.base, encrypted.off);
+    ptls_buffer_dispose(&encrypted);
+    if (!encrypted_ok)
+        return false;
+    connection.output = connection.encrypted.data();
+    connection.output_length = connection.encrypted.size();
+    submit_exchange(uring, connection, connection_idx);
+    return true;
+}
+
+/**
+ * @brief Handles the completion of a `send` or `recv`.
+ * @return -1 if the connection has failed, 1 if the reply is complete, or 0 if the exchange continues.
+ */
+static int on_completion(bench_worker_t& worker, io_uring& uring, bench_connection_t& connection,
+                         std::size_t connection_idx, bool is_recv, int result, int& reply_status) noexcept {
+    // A `recv` cancelled after a short `send` is resubmitted together with the rest of the request.
+    if (result == -ECANCELED)
+        return 0;
+    if (result <= 0)
+        return -1;
+
+    bool measured = connection.intended_ns >= worker.measure_from_ns;
+    if (!is_recv) {
+        worker.bytes_sent += measured ? result : 0;
+        connection.output_sent += result;
+        if (connection.output_sent != connection.output_length)
+            submit_exchange(uring, connection, connection_idx);
+        return 0;
+    }
+
+    worker.bytes_received += measured ? result : 0;
+    if (connection.tls_context) {
+        std::uint8_t small_buffer[ram_page_size_k];
+        ptls_buffer_t decrypted;
+        ptls_buffer_init(&decrypted, small_buffer, sizeof(small_buffer));
+        std::size_t offset = 0;
+        int tls_result = 0;
+        while (offset != static_cast<std::size_t>(result) && tls_result == 0) {
+            std::size_t consumed = result - offset;
+            tls_result = ptls_receive(connection.tls_context, &decrypted, connection.received + offset, &consumed);
+            offset += consumed;
+        }
+        bool appended = tls_result == 0 && connection.input.append_n((char const*)decrypted.base, decrypted.off);
+        ptls_buffer_dispose(&decrypted);
+        if (!appended)
+            return -1;
+    } else if (!connection.input.append_n(connection.received, result))
+        return -1;
+
+    reply_status = check_reply(worker.config->use_http, {connection.input.data(), connection.input.size()});
+    if (reply_status)
+        return 1;
+    submit_recv(uring, connection, connection_idx);
+    return 0;
+}
+
+/**
+ * @brief Generates arrivals on the worker's share of connections until the duration expires,
+ * then waits for the requests in flight, up to the timeout.
+ */
+static void run_worker(bench_worker_t& worker) noexcept {
+    bench_config_t const& config = *worker.config;
+    buffer_gt<bench_connection_t> connections;
+    if (!connections.resize(worker.connections_count))
+        return;
+
+    io_uring uring;
+    if (io_uring_queue_init(static_cast<unsigned>(worker.connections_count * 2 + 16), &uring, 0) < 0) {
+        worker.failed_connections = worker.connections_count;
+        return;
+    }
+
+    // Idle connections are kept in a stack, and the arrivals, waiting for one, in a FIFO queue.
+    array_gt<std::size_t> idle;
+    array_gt<std::uint64_t> backlog;
+    std::size_t backlog_head = 0;
+    if (!idle.reserve(worker.connections_count))
+        return;
+    for (std::size_t i = 0; i != worker.connections_count; ++i)
+        if (connect(config, connections[i]))
+            idle.push_back_reserved(i);
+        else
+            worker.failed_connections++;
+
+    std::mt19937_64 generator(std::random_device{}());
+    std::exponential_distribution<double> poisson_intervals(worker.rate / 1e9);
+    double uniform_interval_ns = 1e9 / worker.rate;
+    double schedule_offset_ns = 0;
+
+    std::uint64_t const start_ns = now_ns();
+    std::uint64_t const measure_from_ns = start_ns + static_cast<std::uint64_t>(config.warmup_seconds * 1e9);
+    worker.measure_from_ns = measure_from_ns;
+    std::uint64_t const stop_ns = measure_from_ns + static_cast<std::uint64_t>(config.duration_seconds * 1e9);
+    std::uint64_t const drain_until_ns = stop_ns + static_cast<std::uint64_t>(config.timeout_seconds * 1e9);
+    std::uint64_t next_arrival_ns = start_ns;
+    std::size_t in_flight = 0;
+
+    auto complete = [&](std::size_t connection_idx, int reply_status) noexcept {
+        bench_connection_t& connection = connections[connection_idx];
+        std::uint64_t finished_ns = now_ns();
+        in_flight--;
+        if (connection.intended_ns >= measure_from_ns) {
+            if (reply_status == 1) {
+                worker.responses++;
+                worker.latency.record(finished_ns - connection.intended_ns);
+                worker.service_time.record(finished_ns - connection.sent_ns);
+            } else
+                worker.errors++;
+        }
+        if (reply_status < 0) {
+            worker.reconnects++;
+            if (!connect(config, connection))
+                return;
+        }
+        connection.busy = false;
+        idle.push_back_reserved(connection_idx);
+    };
+
+    while (true) {
+        std::uint64_t now = now_ns();
+
+        // Schedule all the arrivals, that are due, regardless of the replies.
+        for (; next_arrival_ns <= now && next_arrival_ns < stop_ns;) {
+            if (!backlog.append_n(&next_arrival_ns, 1))
+                break;
+            worker.requests += next_arrival_ns >= measure_from_ns;
+            schedule_offset_ns += config.poisson ? poisson_intervals(generator) : uniform_interval_ns;
+            next_arrival_ns = start_ns + static_cast<std::uint64_t>(schedule_offset_ns);
+        }
+
+        // Dispatch the oldest waiting arrivals onto idle connections.
+        while (backlog_head != backlog.size() && idle.size()) {
+            std::size_t connection_idx = idle[idle.size() - 1];
+            idle.pop_back();
+            in_flight++;
+            if (!start_request(worker, uring, connections[connection_idx], connection_idx, backlog[backlog_head++]))
+                complete(connection_idx, -1);
+        }
+        if (backlog_head == backlog.size())
+            backlog.pop_back(backlog.size()), backlog_head = 0;
+
+        bool scheduling = next_arrival_ns < stop_ns;
+        if (!scheduling && !in_flight && backlog_head == backlog.size())
+            break;
+        if (!scheduling && now >= drain_until_ns)
+            break;
+
+        // Sleep until the next arrival is due, or any exchange progresses.
+        std::uint64_t wake_up_ns = scheduling ? next_arrival_ns : drain_until_ns;
+        std::uint64_t sleep_ns = wake_up_ns > now ? wake_up_ns - now : 0;
+        __kernel_timespec timeout;
+        timeout.tv_sec = static_cast<long long>(sleep_ns / 1'000'000'000);
+        timeout.tv_nsec = static_cast<long long>(sleep_ns % 1'000'000'000);
+        io_uring_submit(&uring);
+        io_uring_cqe* uring_cqe = nullptr;
+        if (io_uring_wait_cqe_timeout(&uring, &uring_cqe, &timeout) < 0)
+            continue;
+
+        while (io_uring_peek_cqe(&uring, &uring_cqe) == 0 && uring_cqe) {
+            auto data = reinterpret_cast<std::uintptr_t>(io_uring_cqe_get_data(uring_cqe));
+            int result = uring_cqe->res;
+            io_uring_cqe_seen(&uring, uring_cqe);
+            std::size_t connection_idx = data >> 1;
+            bench_connection_t& connection = connections[connection_idx];
+            if (!connection.busy)
+                continue;
+            int reply_status = 0;
+            int progress = on_completion(worker, uring, connection, connection_idx, data & 1, result, reply_status);
+            if (progress < 0)
+                complete(connection_idx, -1);
+            else if (progress > 0)
+                complete(connection_idx, reply_status);
+        }
+    }
+
+    // Whatever is still waiting or in flight, has missed the deadline.
+    for (std::size_t i = backlog_head; i != backlog.size(); ++i)
+        worker.timeouts += backlog[i] >= measure_from_ns;
+    for (bench_connection_t& connection : connections) {
+        if (connection.busy && connection.intended_ns >= measure_from_ns)
+            worker.timeouts++;
+        connection.close_socket();
+    }
+    io_uring_queue_exit(&uring);
+}
+
+#pragma endregion Event Loop
+
+#pragma region Reporting
+
+static void print_histogram(char const* name, histogram_t const& histogram, bool last) {
+    std::printf("  \"%s\": {\"count\": %zu, \"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+                "\"p99\": %.3f, \"p99.9\": %.3f, \"p99.99\": %.3f, \"max\": %.3f}%s\n",
+                name, static_cast<std::size_t>(histogram.count()), histogram.min() / 1e3, histogram.mean() / 1e3,
+                histogram.percentile(50) / 1e3, histogram.percentile(90) / 1e3, histogram.percentile(99) / 1e3,
+                histogram.percentile(99.9) / 1e3, histogram.percentile(99.99) / 1e3, histogram.max() / 1e3,
+                last ? "" : ",");
+}
+
+#pragma endregion Reporting
+
+int main(int argc, char** argv) {
+
+    cxxopts::Options options("UCall Bench", "Open-loop load generator, reporting latency percentiles as JSON");
+    options.add_options()                                                                                             //
+        ("h,help", "Print usage")                                                                                     //
+        ("host", "Server hostname or IP", cxxopts::value<std::string>()->default_value("127.0.0.1"))                  //
+        ("p,port", "Server port", cxxopts::value<int>()->default_value("8545"))                                       //
+        ("protocol", "jsonrpc_tcp, jsonrpc_http, rest", cxxopts::value<std::string>()->default_value("jsonrpc_http")) //
+        ("ssl", "Use TLS 1.3", cxxopts::value<bool>()->default_value("false"))                                        //
+        ("c,connections", "Total connections", cxxopts::value<std::size_t>()->default_value("64"))                    //
+        ("j,threads", "Threads, each with an io_uring", cxxopts::value<std::size_t>()->default_value("1"))            //
+        ("r,rate", "Target requests per second", cxxopts::value<double>()->default_value("10000"))                    //
+        ("d,duration", "Seconds to measure", cxxopts::value<double>()->default_value("10"))                           //
+        ("warmup", "Seconds before measuring", cxxopts::value<double>()->default_value("1"))                          //
+        ("timeout", "Seconds to wait for late replies", cxxopts::value<double>()->default_value("2"))                 //
+        ("arrivals", "uniform or poisson", cxxopts::value<std::string>()->default_value("uniform"))                   //
+        ("http-method", "Method of REST requests", cxxopts::value<std::string>()->default_value("GET"))               //
+        ("path", "Path of REST requests", cxxopts::value<std::string>()->default_value("/validate_session/21"))       //
+        ("body", "Request body, `validate_session` by default", cxxopts::value<std::string>())                        //
+        ;
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    bench_config_t config;
+    config.hostname = result["host"].as<std::string>();
+    config.port = result["port"].as<int>();
+    config.ssl = result["ssl"].as<bool>();
+    config.threads = (std::max)(result["threads"].as<std::size_t>(), std::size_t(1));
+    config.connections = (std::max)(result["connections"].as<std::size_t>(), config.threads);
+    config.rate = result["rate"].as<double>();
+    config.duration_seconds = result["duration"].as<double>();
+    config.warmup_seconds = result["warmup"].as<double>();
+    config.timeout_seconds = result["timeout"].as<double>();
+    config.poisson = result["arrivals"].as<std::string>() == "poisson";
+    if (config.rate <= 0 || config.duration_seconds <= 0) {
+        std::fprintf(stderr, "Rate and duration must be positive\n");
+        return 1;
+    }
+
+    // Frame the request once, as it is the same for every exchange.
+    std::string protocol = result["protocol"].as<std::string>();
+    bool is_rest = protocol == "rest";
+    bool is_tcp = protocol == "jsonrpc_tcp";
+    if (!is_rest && !is_tcp && protocol != "jsonrpc_http") {
+        std::fprintf(stderr, "Unknown protocol: %s\n", protocol.c_str());
+        return 1;
+    }
+    constexpr char const* jsonrpc_body_k =
+        R"({"jsonrpc":"2.0","method":"validate_session","params":{"user_id":55,"session_id":21},"id":0})";
+    constexpr char const* rest_body_k = R"({"user_id":55})";
+    std::string body = result.count("body") ? result["body"].as<std::string>() : is_rest ? rest_body_k : jsonrpc_body_k;
+    config.use_http = !is_tcp;
+    if (is_tcp)
+        config.request = body + '\0';
+    else {
+        std::string request_line = is_rest ? result["http-method"].as<std::string>() + " " +
+                                                 result["path"].as<std::string>()
+                                           : std::string("POST /");
+        config.request = request_line + " HTTP/1.1\r\nHost: " + config.hostname + ":" + std::to_string(config.port) +
+                         "\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) +
+                         "\r\n\r\n" + body;
+    }
+
+    addrinfo hints{};
+    addrinfo* resolved = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    std::string port = std::to_string(config.port);
+    if (getaddrinfo(config.hostname.c_str(), port.c_str(), &hints, &resolved) != 0 || !resolved) {
+        std::fprintf(stderr, "Failed to resolve: %s\n", config.hostname.c_str());
+        return 1;
+    }
+    std::memcpy(&config.address, resolved->ai_addr, resolved->ai_addrlen);
+    config.address_length = resolved->ai_addrlen;
+    freeaddrinfo(resolved);
+
+    if (config.ssl) {
+        config.ssl_context.random_bytes = ptls_openssl_random_bytes;
+        config.ssl_context.get_time = &ptls_get_time;
+        config.ssl_context.key_exchanges = ptls_openssl_key_exchanges;
+        config.ssl_context.cipher_suites = ptls_openssl_cipher_suites;
+    }
+
+    // Split the connections and the rate evenly between the threads.
+    buffer_gt<bench_worker_t> workers;
+    if (!workers.resize(config.threads)) {
+        std::fprintf(stderr, "Failed to allocate workers\n");
+        return 1;
+    }
+    for (std::size_t i = 0; i != config.threads; ++i) {
+        workers[i].config = &config;
+        workers[i].connections_count = config.connections / config.threads + (i < config.connections % config.threads);
+        workers[i].rate = config.rate / config.threads;
+    }
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < config.threads; ++i)
+        threads.emplace_back(&run_worker, std::ref(workers[i]));
+    run_worker(workers[0]);
+    for (auto& thread : threads)
+        thread.join();
+
+    bench_worker_t& total = workers[0];
+    for (std::size_t i = 1; i != config.threads; ++i) {
+        bench_worker_t& worker = workers[i];
+        total.latency.merge(worker.latency);
+        total.service_time.merge(worker.service_time);
+        total.requests += worker.requests;
+        total.responses += worker.responses;
+        total.errors += worker.errors;
+        total.timeouts += worker.timeouts;
+        total.reconnects += worker.reconnects;
+        total.failed_connections += worker.failed_connections;
+        total.bytes_sent += worker.bytes_sent;
+        total.bytes_received += worker.bytes_received;
+    }
+
+    std::printf("{\n");
+    std::printf("  \"protocol\": \"%s\",\n  \"ssl\": %s,\n", protocol.c_str(), config.ssl ? "true" : "false");
+    std::printf("  \"connections\": %zu,\n  \"threads\": %zu,\n", config.connections, config.threads);
+    std::printf("  \"arrivals\": \"%s\",\n", config.poisson ? "poisson" : "uniform");
+    std::printf("  \"duration_seconds\": %.3f,\n", config.duration_seconds);
+    std::printf("  \"target_rate\": %.1f,\n", config.rate);
+    std::printf("  \"achieved_rate\": %.1f,\n", total.responses / config.duration_seconds);
+    std::printf("  \"requests\": %zu,\n  \"responses\": %zu,\n", total.requests, total.responses);
+    std::printf("  \"errors\": %zu,\n  \"timeouts\": %zu,\n", total.errors, total.timeouts);
+    std::printf("  \"reconnects\": %zu,\n  \"failed_connections\": %zu,\n", total.reconnects, total.failed_connections);
+    std::printf("  \"bytes_sent\": %zu,\n  \"bytes_received\": %zu,\n", total.bytes_sent, total.bytes_received);
+    print_histogram("latency_micro_seconds", total.latency, false);
+    print_histogram("service_time_micro_seconds", total.service_time, true);
+    std::printf("}\n");
+    return total.failed_connections == config.connections ? 1 : 0;
+}
@@ -0,0 +1,274 @@
+/**
+ * @brief Measures how fast a UCall server completes TLS 1.3 handshakes.
+ *
+ * Every thread opens a connection, completes the handshake, and closes it, in a closed loop.
+ * With `--resume`, every thread first completes an untimed handshake and waits for a session ticket,
+ * that is offered in the measured ones, so the server may skip the certificate exchange. Handshakes,
+ * where the server has actually accepted the ticket, are reported as "resumed". If the server hasn't
+ * issued a ticket, resumption is reported as unsupported, and full handshakes are measured.
+ * Results are printed to `stdout` as a single JSON object, like `ucall_bench` does.
+ */
+#include <netdb.h>       // `getaddrinfo`
+#include <netinet/in.h>  // `IPPROTO_TCP`
+#include <netinet/tcp.h> // `TCP_NODELAY`
+#include <poll.h>        // `poll`
+#include <sys/socket.h>  // `send`, `recv`
+#include <time.h>        // `clock_gettime`
+#include <unistd.h>      // `close`
+
+#include <algorithm> // `std::max`
+#include <cerrno>    // `errno`
+#include <cstddef>   // `offsetof`
+#include <cstdio>    // `std::printf`
+#include <cstring>   // `std::memcpy`
+#include <iostream>  // `std::cout`
+#include <string>    // `std::string`
+#include <thread>    // `std::thread`
+#include <vector>    // `std::vector`
+
+#include <cxxopts.hpp>
+#include <picotls.h>
+#include <picotls/openssl.h>
+
+#include "containers.hpp"
+#include "histogram.hpp"
+
+using namespace unum::ucall;
+
+static constexpr std::size_t recv_chunk_k = 16 * 1024;
+/// @brief How long to wait for a session ticket after the untimed first handshake.
+static constexpr int ticket_wait_milliseconds_k = 100;
+
+static std::uint64_t now_ns() noexcept {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1'000'000'000ull + ts.tv_nsec;
+}
+
+struct handshake_config_t {
+    std::string hostname;
+    sockaddr_storage address{};
+    socklen_t address_length{};
+    double duration_seconds{};
+    bool resume{};
+};
+
+/**
+ * @brief Per-thread TLS context, remembering the last session ticket the server has issued.
+ */
+struct handshake_worker_t {
+    handshake_config_t const* config{};
+    ptls_context_t ssl_context{};
+    ptls_save_ticket_t save_ticket{};
+    std::vector<std::uint8_t> ticket;
+
+    histogram_t latency;
+    std::size_t handshakes{};
+    std::size_t resumed{};
+    std::size_t failures{};
+    bool ticket_received{};
+
+    static int on_ticket(ptls_save_ticket_t* self, ptls_t*, ptls_iovec_t input) {
+        handshake_worker_t* worker = reinterpret_cast<handshake_worker_t*>(reinterpret_cast<char*>(self) -
+                                                                           offsetof(handshake_worker_t, save_ticket));
+        worker->ticket.assign(input.base, input.base + input.len);
+        return 0;
+    }
+};
+
+static int send_all(int descriptor, void const* data, std::size_t length) noexcept {
+    char const* begin = static_cast<char const*>(data);
+    while (length) {
+        ssize_t sent = send(descriptor, begin, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return -1;
+        begin += sent, length -= sent;
+    }
+    return 0;
+}
+
+/**
+ * @brief Connects and completes a blocking TLS 1.3 handshake.
+ * With @p wait_for_ticket, briefly waits for the server to issue a session ticket.
+ */
+static bool handshake_once(handshake_worker_t& worker, bool& resumed, bool wait_for_ticket = false) noexcept {
+    handshake_config_t const& config = *worker.config;
+    int descriptor = socket(config.address.ss_family, SOCK_STREAM, IPPROTO_TCP);
+    if (descriptor < 0)
+        return false;
+    int no_delay = 1;
+    setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    if (connect(descriptor, (sockaddr const*)&config.address, config.address_length) != 0) {
+        close(descriptor);
+        return false;
+    }
+
+    ptls_t* tls = ptls_new(&worker.ssl_context, 0);
+    if (!tls) {
+        close(descriptor);
+        return false;
+    }
+    ptls_set_server_name(tls, config.hostname.c_str(), 0);
+
+    ptls_handshake_properties_t properties{};
+    if (config.resume && !worker.ticket.empty())
+        properties.client.session_ticket = ptls_iovec_t{worker.ticket.data(), worker.ticket.size()};
+
+    std::uint8_t small_buffer[ram_page_size_k];
+    char received[recv_chunk_k];
+    ptls_buffer_t outgoing;
+    ptls_buffer_init(&outgoing, small_buffer, sizeof(small_buffer));
+    int result = ptls_handshake(tls, &outgoing, nullptr, nullptr, &properties);
+    while (result == PTLS_ERROR_IN_PROGRESS) {
+        if (send_all(descriptor, outgoing.base, outgoing.off) != 0)
+            break;
+        outgoing.off = 0;
+        ssize_t length = recv(descriptor, received, recv_chunk_k, 0);
+        if (length <= 0)
+            break;
+        std::size_t offset = 0;
+        while (offset != static_cast<std::size_t>(length) && result == PTLS_ERROR_IN_PROGRESS) {
+            std::size_t consumed = length - offset;
+            result = ptls_handshake(tls, &outgoing, received + offset, &consumed, &properties);
+            offset += consumed;
+        }
+        // Tickets arrive after the handshake, possibly in the same packet.
+        if (result == 0 && offset != static_cast<std::size_t>(length)) {
+            std::size_t consumed = length - offset;
+            ptls_buffer_t ignored;
+            ptls_buffer_init(&ignored, small_buffer, sizeof(small_buffer));
+            ptls_receive(tls, &ignored, received + offset, &consumed);
+            ptls_buffer_dispose(&ignored);
+        }
+    }
+    if (result == 0 && outgoing.off)
+        result = send_all(descriptor, outgoing.base, outgoing.off);
+    ptls_buffer_dispose(&outgoing);
+
+    if (result == 0 && wait_for_ticket && worker.ticket.empty()) {
+        pollfd descriptor_poll{descriptor, POLLIN, 0};
+        ssize_t length = 0;
+        if (poll(&descriptor_poll, 1, ticket_wait_milliseconds_k) > 0 &&
+            (length = recv(descriptor, received, recv_chunk_k, 0)) > 0) {
+            std::size_t consumed = static_cast<std::size_t>(length);
+            ptls_buffer_t ignored;
+            ptls_buffer_init(&ignored, small_buffer, sizeof(small_buffer));
+            ptls_receive(tls, &ignored, received, &consumed);
+            ptls_buffer_dispose(&ignored);
+        }
+    }
+
+    resumed = result == 0 && ptls_is_psk_handshake(tls);
+    ptls_free(tls);
+    close(descriptor);
+    return result == 0;
+}
+
+static void run_worker(handshake_worker_t& worker) noexcept {
+    // The ticket is awaited once, outside of the measured loop.
+    if (worker.config->resume) {
+        bool resumed = false;
+        handshake_once(worker, resumed, true);
+        worker.ticket_received = !worker.ticket.empty();
+    }
+
+    std::uint64_t deadline = now_ns() + static_cast<std::uint64_t>(worker.config->duration_seconds * 1e9);
+    while (now_ns() < deadline) {
+        bool resumed = false;
+        std::uint64_t started = now_ns();
+        if (!handshake_once(worker, resumed)) {
+            worker.failures++;
+            continue;
+        }
+        worker.latency.record(now_ns() - started);
+        worker.handshakes++;
+        worker.resumed += resumed;
+    }
+}
+
+int main(int argc, char** argv) {
+
+    cxxopts::Options options("ucall_bench_handshake", "TLS handshake rate of UCall servers");
+    options.add_options()                                                                                       //
+        ("h,help", "Print usage")                                                                               //
+        ("host", "Server hostname or IP", cxxopts::value<std::string>()->default_value("127.0.0.1"))            //
+        ("p,port", "Server port", cxxopts::value<int>()->default_value("8545"))                                 //
+        ("j,threads", "Threads, each handshaking in a loop", cxxopts::value<std::size_t>()->default_value("1")) //
+        ("d,duration", "Seconds to measure", cxxopts::value<double>()->default_value("10"))                     //
+        ("resume", "Offer session tickets after the first handshake", cxxopts::value<bool>()->default_value("false"));
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    handshake_config_t config;
+    config.hostname = result["host"].as<std::string>();
+    config.duration_seconds = result["duration"].as<double>();
+    config.resume = result["resume"].as<bool>();
+    std::size_t threads_count = (std::max)(result["threads"].as<std::size_t>(), std::size_t(1));
+
+    addrinfo hints{};
+    addrinfo* resolved = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    std::string port = std::to_string(result["port"].as<int>());
+    if (getaddrinfo(config.hostname.c_str(), port.c_str(), &hints, &resolved) != 0 || !resolved) {
+        std::fprintf(stderr, "Failed to resolve: %s\n", config.hostname.c_str());
+        return 1;
+    }
+    std::memcpy(&config.address, resolved->ai_addr, resolved->ai_addrlen);
+    config.address_length = resolved->ai_addrlen;
+    freeaddrinfo(resolved);
+
+    // The server certificate isn't verified, as this is a benchmark.
+    std::vector<handshake_worker_t> workers(threads_count);
+    for (handshake_worker_t& worker : workers) {
+        worker.config = &config;
+        worker.ssl_context.random_bytes = ptls_openssl_random_bytes;
+        worker.ssl_context.get_time = &ptls_get_time;
+        worker.ssl_context.key_exchanges = ptls_openssl_key_exchanges;
+        worker.ssl_context.cipher_suites = ptls_openssl_cipher_suites;
+        worker.save_ticket.cb = &handshake_worker_t::on_ticket;
+        if (config.resume)
+            worker.ssl_context.save_ticket = &worker.save_ticket;
+    }
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < threads_count; ++i)
+        threads.emplace_back(&run_worker, std::ref(workers[i]));
+    run_worker(workers[0]);
+    for (auto& thread : threads)
+        thread.join();
+
+    handshake_worker_t& total = workers[0];
+    bool resumption_supported = config.resume;
+    for (handshake_worker_t const& worker : workers)
+        resumption_supported &= worker.ticket_received;
+    if (config.resume && !resumption_supported)
+        std::fprintf(stderr, "The server hasn't issued session tickets, measuring full handshakes\n");
+    for (std::size_t i = 1; i != threads_count; ++i) {
+        total.latency.merge(workers[i].latency);
+        total.handshakes += workers[i].handshakes;
+        total.resumed += workers[i].resumed;
+        total.failures += workers[i].failures;
+    }
+
+    histogram_t const& latency = total.latency;
+    std::printf("{\n");
+    std::printf("  \"resume\": %s,\n  \"threads\": %zu,\n", config.resume ? "true" : "false", threads_count);
+    if (config.resume)
+        std::printf("  \"resumption\": \"%s\",\n", resumption_supported ? "supported" : "unsupported");
+    std::printf("  \"duration_seconds\": %.3f,\n", config.duration_seconds);
+    std::printf("  \"handshakes\": %zu,\n  \"resumed\": %zu,\n", total.handshakes, total.resumed);
+    std::printf("  \"failures\": %zu,\n", total.failures);
+    std::printf("  \"handshakes_per_second\": %.1f,\n", total.handshakes / config.duration_seconds);
+    std::printf("  \"latency_micro_seconds\": {\"count\": %zu, \"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, "
+                "\"p90\": %.3f, \"p99\": %.3f, \"p99.9\": %.3f, \"max\": %.3f}\n",
+                static_cast<std::size_t>(latency.count()), latency.min() / 1e3, latency.mean() / 1e3,
+                latency.percentile(50) / 1e3, latency.percentile(90) / 1e3, latency.percentile(99) / 1e3,
+                latency.percentile(99.9) / 1e3, latency.max() / 1e3);
+    std::printf("}\n");
+    return total.handshakes ? 0 : 1;
+}
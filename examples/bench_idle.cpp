@@ -0,0 +1,339 @@
+/**
+ * @brief Measures the memory footprint of idle keep-alive connections on a running UCall server.
+ *
+ * Opens many connections, exchanging a single request over each of them, like a keep-alive
+ * client between calls, and leaves them idle. Along the way, samples the resident memory
+ * of the server process and the kernel memory of TCP sockets, and reports the growth per connection.
+ * Loopback offers only ~28K ephemeral ports per source address, so the connections to a `127.x.x.x`
+ * server are spread across `127.0.0.2`, `127.0.0.3` and so on, allowing millions of them.
+ *
+ * Kernel numbers are system-wide and, on loopback, cover both ends of every connection.
+ * Servers close connections idle for longer than 10 seconds, so keep `--hold` shorter.
+ * Raise `ulimit -n` for both processes, and the `--connections` limit of the server.
+ */
+#include <arpa/inet.h>    // `inet_pton`
+#include <netinet/in.h>   // `sockaddr_in`
+#include <sys/epoll.h>    // `epoll_create1`
+#include <sys/resource.h> // `setrlimit`
+#include <sys/socket.h>   // `socket`, `connect`
+#include <time.h>         // `clock_gettime`
+#include <unistd.h>       // `close`, `sysconf`
+
+#include <algorithm> // `std::max`
+#include <cerrno>    // `errno`
+#include <cstdio>    // `std::printf`
+#include <cstring>   // `std::strstr`
+#include <string>    // `std::string`
+#include <vector>    // `std::vector`
+
+#include <cxxopts.hpp>
+
+static constexpr std::size_t ports_per_source_k = 25'000;
+static constexpr int max_events_k = 1024;
+
+static double now_seconds() noexcept {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+enum class idle_stage_t : std::uint8_t { unused_k, connecting_k, awaiting_reply_k, idle_k };
+
+struct memory_sample_t {
+    std::size_t connections{};
+    double elapsed_seconds{};
+    std::size_t server_rss_bytes{};
+    std::size_t kernel_tcp_bytes{};
+    std::size_t kernel_slab_bytes{};
+};
+
+/// @brief Finds a line starting with @p prefix in a `/proc` file, and parses the number after @p key in it.
+static std::size_t read_proc_number(char const* path, char const* prefix, char const* key) noexcept {
+    FILE* file = std::fopen(path, "r");
+    if (!file)
+        return 0;
+    char line[512];
+    std::size_t value = 0;
+    while (std::fgets(line, sizeof(line), file)) {
+        if (std::strncmp(line, prefix, std::strlen(prefix)) != 0)
+            continue;
+        if (char const* found = std::strstr(line, key))
+            value = std::strtoull(found + std::strlen(key), nullptr, 10);
+        break;
+    }
+    std::fclose(file);
+    return value;
+}
+
+static memory_sample_t sample_memory(char const* status_path, std::size_t connections, double elapsed) noexcept {
+    static std::size_t const page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    memory_sample_t sample;
+    sample.connections = connections;
+    sample.elapsed_seconds = elapsed;
+    sample.server_rss_bytes = read_proc_number(status_path, "VmRSS:", "VmRSS:") * 1024;
+    sample.kernel_tcp_bytes = read_proc_number("/proc/net/sockstat", "TCP:", " mem ") * page_size;
+    sample.kernel_slab_bytes = read_proc_number("/proc/meminfo", "Slab:", "Slab:") * 1024;
+    return sample;
+}
+
+static void print_sample(memory_sample_t const& sample, char const* suffix) {
+    std::printf("{\"connections\": %zu, \"elapsed_seconds\": %.3f, \"server_rss_bytes\": %zu, "
+                "\"kernel_tcp_bytes\": %zu, \"kernel_slab_bytes\": %zu}%s\n",
+                sample.connections, sample.elapsed_seconds, sample.server_rss_bytes, sample.kernel_tcp_bytes,
+                sample.kernel_slab_bytes, suffix);
+}
+
+static double per_connection(std::size_t after, std::size_t before, std::size_t connections) noexcept {
+    return connections ? (double(after) - double(before)) / connections : 0;
+}
+
+struct idle_bench_t {
+    int epoll = -1;
+    std::string request;
+    sockaddr_in server_address{};
+    bool spread_sources{};
+    /// @brief Stage of every connection, addressed by its file descriptor.
+    std::vector<idle_stage_t> stages;
+
+    std::size_t opened{};
+    std::size_t in_flight{};
+    std::size_t idle{};
+    std::size_t closed{};
+    std::size_t failed{};
+    int last_error{};
+
+    /// @brief Starts a non-blocking connection, returning false if no more descriptors can be opened.
+    bool open_next() noexcept {
+        int descriptor = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (descriptor < 0 || static_cast<std::size_t>(descriptor) >= stages.size()) {
+            last_error = descriptor < 0 ? errno : EMFILE;
+            if (descriptor >= 0)
+                ::close(descriptor);
+            return false;
+        }
+
+        if (spread_sources) {
+            // Pick the port on `connect`, so that ports are reused across source addresses.
+            int enabled = 1;
+            setsockopt(descriptor, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &enabled, sizeof(enabled));
+            sockaddr_in source{};
+            source.sin_family = AF_INET;
+            source.sin_addr.s_addr = htonl(0x7F000002u + static_cast<std::uint32_t>(opened / ports_per_source_k));
+            if (bind(descriptor, reinterpret_cast<sockaddr*>(&source), sizeof(source)) < 0) {
+                fail(descriptor, errno);
+                return true;
+            }
+        }
+
+        int result = connect(descriptor, reinterpret_cast<sockaddr*>(&server_address), sizeof(server_address));
+        if (result < 0 && errno != EINPROGRESS) {
+            fail(descriptor, errno);
+            return true;
+        }
+
+        epoll_event event{};
+        event.events = EPOLLOUT | EPOLLRDHUP;
+        event.data.fd = descriptor;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, descriptor, &event);
+        stages[descriptor] = idle_stage_t::connecting_k;
+        ++opened, ++in_flight;
+        return true;
+    }
+
+    void fail(int descriptor, int error) noexcept {
+        last_error = error;
+        ++opened, ++failed;
+        ::close(descriptor);
+    }
+
+    void drop(int descriptor, int error) noexcept {
+        idle_stage_t& stage = stages[descriptor];
+        if (stage == idle_stage_t::idle_k)
+            --idle, ++closed;
+        else
+            --in_flight, ++failed, last_error = error;
+        stage = idle_stage_t::unused_k;
+        epoll_ctl(epoll, EPOLL_CTL_DEL, descriptor, nullptr);
+        ::close(descriptor);
+    }
+
+    void on_event(epoll_event const& event) noexcept {
+        int descriptor = event.data.fd;
+        idle_stage_t stage = stages[descriptor];
+        if (event.events & (EPOLLERR | EPOLLHUP))
+            return drop(descriptor, ECONNRESET);
+
+        if (stage == idle_stage_t::connecting_k) {
+            int error = 0;
+            socklen_t error_length = sizeof(error);
+            getsockopt(descriptor, SOL_SOCKET, SO_ERROR, &error, &error_length);
+            if (error)
+                return drop(descriptor, error);
+            // Requests are tiny, so they always fit into the empty socket buffer.
+            if (send(descriptor, request.data(), request.size(), MSG_NOSIGNAL) != ssize_t(request.size()))
+                return drop(descriptor, errno);
+            epoll_event next{};
+            next.events = EPOLLIN | EPOLLRDHUP;
+            next.data.fd = descriptor;
+            epoll_ctl(epoll, EPOLL_CTL_MOD, descriptor, &next);
+            stages[descriptor] = idle_stage_t::awaiting_reply_k;
+            return;
+        }
+
+        // Drain the reply, or whatever else arrives later.
+        char buffer[4096];
+        ssize_t received = recv(descriptor, buffer, sizeof(buffer), 0);
+        if (received == 0 || (received < 0 && errno != EAGAIN))
+            return drop(descriptor, received ? errno : ECONNRESET);
+        if (stage == idle_stage_t::awaiting_reply_k && received > 0) {
+            stages[descriptor] = idle_stage_t::idle_k;
+            --in_flight, ++idle;
+        }
+    }
+
+    void poll(int timeout_milliseconds) noexcept {
+        epoll_event events[max_events_k];
+        int count = epoll_wait(epoll, events, max_events_k, timeout_milliseconds);
+        for (int i = 0; i < count; ++i)
+            on_event(events[i]);
+    }
+};
+
+int main(int argc, char** argv) {
+
+    cxxopts::Options options("ucall_bench_idle", "Memory footprint of idle UCall connections");
+    options.add_options()                                                                                             //
+        ("h,help", "Print usage")                                                                                     //
+        ("host", "Server IPv4 address", cxxopts::value<std::string>()->default_value("127.0.0.1"))                    //
+        ("p,port", "Server port", cxxopts::value<int>()->default_value("8545"))                                       //
+        ("pid", "Server process to sample", cxxopts::value<int>())                                                    //
+        ("protocol", "jsonrpc_tcp, jsonrpc_http, rest", cxxopts::value<std::string>()->default_value("jsonrpc_http")) //
+        ("c,connections", "Idle connections to open", cxxopts::value<std::size_t>()->default_value("10000"))         //
+        ("checkpoints", "Memory samples while opening", cxxopts::value<std::size_t>()->default_value("10"))           //
+        ("concurrency", "Connections being opened at once", cxxopts::value<std::size_t>()->default_value("1024"))     //
+        ("hold", "Seconds to stay idle before the last sample", cxxopts::value<double>()->default_value("2"))         //
+        ("timeout", "Seconds without progress to give up", cxxopts::value<double>()->default_value("10"))             //
+        ;
+    auto result = options.parse(argc, argv);
+    if (result.count("help") || !result.count("pid")) {
+        std::cout << options.help() << std::endl;
+        return result.count("help") ? 0 : 1;
+    }
+
+    int pid = result["pid"].as<int>();
+    std::string status_path = "/proc/" + std::to_string(pid) + "/status";
+    std::size_t target = result["connections"].as<std::size_t>();
+    std::size_t checkpoints = (std::max)(result["checkpoints"].as<std::size_t>(), std::size_t(1));
+    std::size_t concurrency = (std::max)(result["concurrency"].as<std::size_t>(), std::size_t(1));
+    double hold_seconds = result["hold"].as<double>();
+    double timeout_seconds = result["timeout"].as<double>();
+
+    idle_bench_t bench;
+    std::string const& host = result["host"].as<std::string>();
+    bench.server_address.sin_family = AF_INET;
+    bench.server_address.sin_port = htons(static_cast<std::uint16_t>(result["port"].as<int>()));
+    if (inet_pton(AF_INET, host.c_str(), &bench.server_address.sin_addr) != 1) {
+        std::fprintf(stderr, "Not an IPv4 address: %s\n", host.c_str());
+        return 1;
+    }
+    bench.spread_sources = (ntohl(bench.server_address.sin_addr.s_addr) >> 24) == 127;
+
+    // Same requests as `ucall_bench` sends by default.
+    std::string const& protocol = result["protocol"].as<std::string>();
+    std::string jsonrpc_body =
+        R"({"jsonrpc":"2.0","method":"validate_session","params":{"user_id":55,"session_id":21},"id":0})";
+    std::string rest_body = R"({"user_id":55})";
+    if (protocol == "jsonrpc_tcp")
+        bench.request = jsonrpc_body + '\0';
+    else if (protocol == "jsonrpc_http" || protocol == "rest") {
+        std::string const& body = protocol == "rest" ? rest_body : jsonrpc_body;
+        bench.request = std::string(protocol == "rest" ? "GET /validate_session/21" : "POST /") +
+                        " HTTP/1.1\r\nHost: " + host + "\r\nContent-Type: application/json\r\nContent-Length: " +
+                        std::to_string(body.size()) + "\r\n\r\n" + body;
+    } else {
+        std::fprintf(stderr, "Unknown protocol: %s\n", protocol.c_str());
+        return 1;
+    }
+
+    // Every connection needs a descriptor, so raise the soft limit as far as allowed.
+    rlimit descriptors_limit{};
+    getrlimit(RLIMIT_NOFILE, &descriptors_limit);
+    descriptors_limit.rlim_cur = descriptors_limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &descriptors_limit);
+    if (descriptors_limit.rlim_cur < target + 64) {
+        target = descriptors_limit.rlim_cur > 64 ? descriptors_limit.rlim_cur - 64 : 0;
+        std::fprintf(stderr, "Descriptors limit allows only %zu connections, raise `ulimit -n`\n", target);
+    }
+    bench.stages.resize(target + 64);
+    bench.epoll = epoll_create1(0);
+
+    std::vector<memory_sample_t> samples;
+    double start = now_seconds();
+    memory_sample_t baseline = sample_memory(status_path.c_str(), 0, 0);
+    if (!baseline.server_rss_bytes) {
+        std::fprintf(stderr, "Can't read the memory usage of process %i\n", pid);
+        return 1;
+    }
+
+    // Open the connections, keeping only a limited number of them in the middle of the first exchange.
+    std::size_t checkpoint_step = (std::max)(target / checkpoints, std::size_t(1));
+    std::size_t next_checkpoint = checkpoint_step;
+    double last_progress = start;
+    std::size_t last_settled = 0;
+    while (bench.idle + bench.closed + bench.failed < bench.opened || bench.opened < target) {
+        while (bench.opened < target && bench.in_flight < concurrency)
+            if (!bench.open_next()) {
+                target = bench.opened;
+                break;
+            }
+        bench.poll(100);
+
+        double now = now_seconds();
+        std::size_t settled = bench.idle + bench.closed + bench.failed;
+        if (settled != last_settled)
+            last_settled = settled, last_progress = now;
+        else if (now - last_progress > timeout_seconds) {
+            std::fprintf(stderr, "No progress in %.1f seconds, stopping at %zu connections\n", timeout_seconds,
+                         bench.idle);
+            break;
+        }
+        if (bench.idle >= next_checkpoint && bench.idle < target) {
+            samples.push_back(sample_memory(status_path.c_str(), bench.idle, now - start));
+            next_checkpoint += checkpoint_step;
+        }
+    }
+
+    // Let the server settle, noticing the connections it closes meanwhile.
+    double hold_until = now_seconds() + hold_seconds;
+    for (double now = now_seconds(); now < hold_until; now = now_seconds())
+        bench.poll(static_cast<int>((hold_until - now) * 1000) + 1);
+    memory_sample_t final_sample = sample_memory(status_path.c_str(), bench.idle, now_seconds() - start);
+    samples.push_back(final_sample);
+
+    std::printf("{\n");
+    std::printf("  \"protocol\": \"%s\",\n  \"target_connections\": %zu,\n", protocol.c_str(),
+                result["connections"].as<std::size_t>());
+    std::printf("  \"opened\": %zu,\n  \"idle\": %zu,\n", bench.opened, bench.idle);
+    std::printf("  \"closed_by_server\": %zu,\n  \"failed\": %zu,\n", bench.closed, bench.failed);
+    if (bench.last_error)
+        std::printf("  \"last_error\": \"%s\",\n", std::strerror(bench.last_error));
+    std::printf("  \"source_addresses\": %zu,\n",
+                bench.spread_sources ? (bench.opened + ports_per_source_k - 1) / ports_per_source_k : 1);
+    std::printf("  \"marginal_rss_bytes_per_connection\": %.1f,\n",
+                per_connection(final_sample.server_rss_bytes, baseline.server_rss_bytes, bench.idle));
+    std::printf("  \"total_rss_bytes_per_connection\": %.1f,\n",
+                per_connection(final_sample.server_rss_bytes, 0, bench.idle));
+    std::printf("  \"kernel_tcp_bytes_per_connection\": %.1f,\n",
+                per_connection(final_sample.kernel_tcp_bytes, baseline.kernel_tcp_bytes, bench.idle));
+    std::printf("  \"kernel_slab_bytes_per_connection\": %.1f,\n",
+                per_connection(final_sample.kernel_slab_bytes, baseline.kernel_slab_bytes, bench.idle));
+    std::printf("  \"baseline\": ");
+    print_sample(baseline, ",");
+    std::printf("  \"samples\": [\n");
+    for (std::size_t i = 0; i != samples.size(); ++i) {
+        std::printf("    ");
+        print_sample(samples[i], i + 1 == samples.size() ? "" : ",");
+    }
+    std::printf("  ]\n}\n");
+    return bench.idle ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+"""
+Compares the memory footprint of idle connections across UCall backends.
+
+Every backend's example server is launched with room for `connections` clients,
+and `ucall_bench_idle` opens that many keep-alive connections to it, sampling
+the server's RSS and the kernel socket memory. The results are saved into one JSON report.
+Both processes need a descriptor per connection, so the hard `ulimit -n` must allow it.
+
+    python examples/bench_idle.py --build_dir=./build_release/build/bin --connections=1000000
+"""
+import os
+import sys
+import json
+import time
+import platform
+import resource
+import subprocess
+from typing import Sequence
+
+import fire
+
+from bench_matrix import BACKENDS, current_commit, wait_for_port
+
+
+def raise_descriptors_limit():
+    _, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+    resource.setrlimit(resource.RLIMIT_NOFILE, (hard, hard))
+
+
+def main(
+    build_dir: str = './build_release/build/bin',
+    *,
+    backends: Sequence[str] = BACKENDS,
+    connections: int = 100_000,
+    protocol: str = 'jsonrpc_http',
+    hold: float = 2,
+    port: int = 8545,
+    output: str = 'bench_idle.json',
+):
+    bench_path = os.path.join(build_dir, 'ucall_bench_idle')
+    if not os.path.exists(bench_path):
+        sys.exit(f'Missing {bench_path}, configure with -DUCALL_BUILD_BENCHMARKS=1')
+
+    report = {
+        'commit': current_commit(),
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+        'host': {'system': platform.platform(), 'cpus': os.cpu_count()},
+        'results': [],
+    }
+
+    for backend in backends:
+        server_path = os.path.join(build_dir, f'ucall_example_login_{backend}')
+        if not os.path.exists(server_path):
+            print(f'Skipping {backend}, missing {server_path}', file=sys.stderr)
+            continue
+
+        print(f'Running {backend} with {connections:,} connections', file=sys.stderr)
+        cell = {'backend': backend}
+        server = subprocess.Popen(
+            [server_path, f'--port={port}', f'--connections={connections + 1024}',
+             f'--protocol={protocol}', '--silent'],
+            stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, preexec_fn=raise_descriptors_limit)
+        try:
+            if not wait_for_port(port):
+                cell['error'] = 'Server did not start'
+            else:
+                result = subprocess.run(
+                    [bench_path, f'--port={port}', f'--pid={server.pid}', f'--protocol={protocol}',
+                     f'--connections={connections}', f'--hold={hold}'],
+                    capture_output=True, text=True)
+                try:
+                    cell.update(json.loads(result.stdout))
+                except json.JSONDecodeError:
+                    cell['error'] = result.stderr.strip() or f'Exit code {result.returncode}'
+        finally:
+            server.kill()
+            server.wait()
+        report['results'].append(cell)
+
+        if 'error' not in cell:
+            print(
+                f'- {cell["idle"]:,} idle connections, '
+                f'{cell["marginal_rss_bytes_per_connection"]:,.0f} bytes of RSS each on top of '
+                f'{cell["baseline"]["server_rss_bytes"] / 2**20:,.1f} MiB preallocated, '
+                f'{cell["kernel_slab_bytes_per_connection"]:,.0f} bytes of kernel slabs', file=sys.stderr)
+
+    with open(output, 'w') as file:
+        json.dump(report, file, indent=2)
+    print(f'Saved {len(report["results"])} results to {output}', file=sys.stderr)
+
+
+if __name__ == '__main__':
+    fire.Fire(main)
@@ -0,0 +1,171 @@
+"""
+Compares UCall backends on loopback.
+
+Every backend's example server is launched in turn and driven by the open-loop `ucall_bench`
+across a matrix of protocols, connections, threads and payload sizes.
+All the results land in a single JSON report, tagged with the current commit.
+Pass an older report as `baseline` to print the cells that got slower since.
+
+    python examples/bench_matrix.py --build_dir=./build_release/build/bin --output=after.json --baseline=before.json
+"""
+import os
+import sys
+import json
+import time
+import socket
+import platform
+import itertools
+import subprocess
+from typing import Optional, Sequence
+
+import fire
+
+
+BACKENDS = ('posix', 'epoll', 'uring')
+PROTOCOLS = ('jsonrpc_http', 'jsonrpc_tcp', 'rest')
+
+# Each protocol is served by one of the examples, answering the `validate_session` call.
+SERVERS = {
+    'jsonrpc_http': ('ucall_example_login_{}', ['--protocol=jsonrpc_http']),
+    'jsonrpc_tcp': ('ucall_example_login_{}', ['--protocol=jsonrpc_tcp']),
+    'rest': ('ucall_example_rest_{}', []),
+}
+
+
+def make_body(protocol: str, payload: int) -> str:
+    """Pads the default request of `ucall_bench` with an ignored parameter, to reach `payload` bytes."""
+    if protocol == 'rest':
+        prefix, suffix = '{"user_id":55,"padding":"', '"}'
+    else:
+        prefix = '{"jsonrpc":"2.0","method":"validate_session","params":{"user_id":55,"session_id":21,"padding":"'
+        suffix = '"},"id":0}'
+    return prefix + 'x' * max(payload - len(prefix) - len(suffix), 0) + suffix
+
+
+def wait_for_port(port: int, seconds: float = 5) -> bool:
+    deadline = time.monotonic() + seconds
+    while time.monotonic() < deadline:
+        try:
+            with socket.create_connection(('127.0.0.1', port), timeout=0.1):
+                return True
+        except OSError:
+            time.sleep(0.05)
+    return False
+
+
+def current_commit() -> str:
+    try:
+        return subprocess.run(
+            ['git', 'rev-parse', '--short', 'HEAD'],
+            capture_output=True, text=True,
+            cwd=os.path.dirname(os.path.abspath(__file__))).stdout.strip()
+    except OSError:
+        return ''
+
+
+def cell_key(cell: dict) -> tuple:
+    return tuple(cell[k] for k in ('backend', 'protocol', 'connections', 'threads', 'payload', 'target_rate'))
+
+
+def compare(report: dict, baseline: dict, tolerance: float):
+    """Prints the cells, where the throughput dropped or the tail latency grew by more than `tolerance`."""
+    previous = {cell_key(cell): cell for cell in baseline['results']}
+    regressions = 0
+    for cell in report['results']:
+        old = previous.get(cell_key(cell))
+        if old is None or 'error' in cell or 'error' in old:
+            continue
+        rate, old_rate = cell['achieved_rate'], old['achieved_rate']
+        p99, old_p99 = cell['latency_micro_seconds']['p99'], old['latency_micro_seconds']['p99']
+        if rate < old_rate * (1 - tolerance) or p99 > old_p99 * (1 + tolerance):
+            regressions += 1
+            print(
+                f'Regression in {"/".join(map(str, cell_key(cell)))}: '
+                f'{old_rate:,.0f} -> {rate:,.0f} requests/s, p99 {old_p99:,.1f} -> {p99:,.1f} us',
+                file=sys.stderr)
+    print(f'{regressions} regressions against {baseline.get("commit") or "baseline"}', file=sys.stderr)
+
+
+def main(
+    build_dir: str = './build_release/build/bin',
+    *,
+    backends: Sequence[str] = BACKENDS,
+    protocols: Sequence[str] = PROTOCOLS,
+    connections: Sequence[int] = (16, 256),
+    threads: Sequence[int] = (1, 4),
+    payloads: Sequence[int] = (64, 4096),
+    rate: float = 100_000,
+    duration: float = 3,
+    warmup: float = 1,
+    port: int = 8545,
+    output: str = 'bench_matrix.json',
+    baseline: Optional[str] = None,
+    tolerance: float = 0.1,
+):
+    bench_path = os.path.join(build_dir, 'ucall_bench')
+    if not os.path.exists(bench_path):
+        sys.exit(f'Missing {bench_path}, configure with -DUCALL_BUILD_BENCHMARKS=1')
+
+    report = {
+        'commit': current_commit(),
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+        'host': {'system': platform.platform(), 'cpus': os.cpu_count()},
+        'settings': {'rate': rate, 'duration': duration, 'warmup': warmup},
+        'results': [],
+    }
+
+    missing = set()
+    for backend, protocol, threads_count, connections_count, payload in itertools.product(
+            backends, protocols, threads, connections, payloads):
+        server_name, server_args = SERVERS[protocol]
+        server_path = os.path.join(build_dir, server_name.format(backend))
+        if not os.path.exists(server_path):
+            if server_path not in missing:
+                print(f'Skipping {backend}/{protocol}, missing {server_path}', file=sys.stderr)
+            missing.add(server_path)
+            continue
+
+        cell = {
+            'backend': backend,
+            'protocol': protocol,
+            'connections': connections_count,
+            'threads': threads_count,
+            'payload': payload,
+            'target_rate': float(rate),
+        }
+        print(f'Running {"/".join(map(str, cell_key(cell)))}', file=sys.stderr)
+
+        # A fresh server for every cell, so that one run can't leave the next with stale connections.
+        server = subprocess.Popen(
+            [server_path, f'--port={port}', f'--threads={threads_count}', '--silent'] + server_args,
+            stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        try:
+            if not wait_for_port(port):
+                cell['error'] = 'Server did not start'
+            else:
+                result = subprocess.run(
+                    [bench_path, f'--port={port}', f'--protocol={protocol}',
+                     f'--connections={connections_count}', f'--threads={threads_count}',
+                     f'--rate={rate}', f'--duration={duration}', f'--warmup={warmup}',
+                     f'--body={make_body(protocol, payload)}'],
+                    capture_output=True, text=True)
+                try:
+                    cell.update(json.loads(result.stdout))
+                except json.JSONDecodeError:
+                    cell['error'] = result.stderr.strip() or f'Exit code {result.returncode}'
+        finally:
+            server.kill()
+            server.wait()
+        report['results'].append(cell)
+
+    with open(output, 'w') as file:
+        json.dump(report, file, indent=2)
+    print(f'Saved {len(report["results"])} results to {output}', file=sys.stderr)
+
+    if baseline:
+        with open(baseline) as file:
+            compare(report, json.load(file), tolerance)
+
+
+if __name__ == '__main__':
+    fire.Fire(main)
@@ -0,0 +1,106 @@
+"""
+Measures the cost of TLS 1.3 on every UCall backend.
+
+Every backend's login example is launched with the certificates from `examples/login/certs`,
+and `ucall_bench_handshake` counts the full and the resumed handshakes it completes per second.
+Then `ucall_bench` drives it with small and large requests over TLS, and the same requests
+in plaintext against a second instance, so that the overhead of encryption is in one report.
+
+    python examples/bench_tls.py --build_dir=./build_release/build/bin
+"""
+import os
+import sys
+import json
+import time
+import platform
+import subprocess
+from typing import Sequence
+
+import fire
+
+from bench_matrix import BACKENDS, current_commit, make_body, wait_for_port
+
+CERTS = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'login', 'certs')
+
+
+def run_json(args: Sequence[str]) -> dict:
+    result = subprocess.run(args, capture_output=True, text=True)
+    try:
+        return json.loads(result.stdout)
+    except json.JSONDecodeError:
+        return {'error': result.stderr.strip() or f'Exit code {result.returncode}'}
+
+
+def main(
+    build_dir: str = './build_release/build/bin',
+    *,
+    backends: Sequence[str] = BACKENDS,
+    payloads: Sequence[int] = (64, 16384),
+    connections: int = 64,
+    threads: int = 1,
+    handshake_threads: int = 4,
+    rate: float = 50_000,
+    duration: float = 3,
+    warmup: float = 1,
+    port: int = 8545,
+    output: str = 'bench_tls.json',
+):
+    bench_path = os.path.join(build_dir, 'ucall_bench')
+    handshake_path = os.path.join(build_dir, 'ucall_bench_handshake')
+    for path in (bench_path, handshake_path):
+        if not os.path.exists(path):
+            sys.exit(f'Missing {path}, configure with -DUCALL_BUILD_BENCHMARKS=1')
+
+    report = {
+        'commit': current_commit(),
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+        'host': {'system': platform.platform(), 'cpus': os.cpu_count()},
+        'settings': {'rate': rate, 'duration': duration, 'warmup': warmup, 'connections': connections},
+        'results': [],
+    }
+
+    for backend in backends:
+        server_path = os.path.join(build_dir, f'ucall_example_login_{backend}')
+        if not os.path.exists(server_path):
+            print(f'Skipping {backend}, missing {server_path}', file=sys.stderr)
+            continue
+
+        for ssl in (True, False):
+            server_args = [server_path, f'--port={port}', f'--threads={threads}', '--silent']
+            if ssl:
+                server_args += ['--ssl', f'--certs={CERTS}']
+            server = subprocess.Popen(server_args, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            try:
+                if not wait_for_port(port):
+                    report['results'].append({'backend': backend, 'ssl': ssl, 'error': 'Server did not start'})
+                    continue
+
+                if ssl:
+                    for resume in (False, True):
+                        print(f'Running {backend}/handshake{"/resumed" if resume else ""}', file=sys.stderr)
+                        cell = {'backend': backend, 'test': 'handshake'}
+                        cell.update(run_json(
+                            [handshake_path, f'--port={port}', f'--threads={handshake_threads}',
+                             f'--duration={duration}'] + (['--resume'] if resume else [])))
+                        report['results'].append(cell)
+
+                for payload in payloads:
+                    print(f'Running {backend}/{"tls" if ssl else "plain"}/{payload}', file=sys.stderr)
+                    cell = {'backend': backend, 'test': 'requests', 'payload': payload}
+                    cell.update(run_json(
+                        [bench_path, f'--port={port}', '--protocol=jsonrpc_http',
+                         f'--connections={connections}', f'--threads={threads}', f'--rate={rate}',
+                         f'--duration={duration}', f'--warmup={warmup}',
+                         f'--body={make_body("jsonrpc_http", payload)}'] + (['--ssl'] if ssl else [])))
+                    report['results'].append(cell)
+            finally:
+                server.kill()
+                server.wait()
+
+    with open(output, 'w') as file:
+        json.dump(report, file, indent=2)
+    print(f'Saved {len(report["results"])} results to {output}', file=sys.stderr)
+
+
+if __name__ == '__main__':
+    fire.Fire(main)
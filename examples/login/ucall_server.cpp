@@ -2,7 +2,9 @@
  * @brief Example of a web server built with UCall in C++.
  */
 #include <charconv> // `std::to_chars`
+#include <csignal>  // `SIGUSR2`
 #include <cstdio>   // `std::fprintf`
+#include <fcntl.h>  // `open`
 #include <thread>
 #include <vector>
 
@@ -30,7 +32,24 @@ int main(int argc, char** argv) {
         ("nic", "Networking Interface Internal IP to use", cxxopts::value<std::string>()->default_value("127.0.0.1")) //
         ("p,port", "On which port to server JSON-RPC", cxxopts::value<int>()->default_value("8545"))                  //
         ("j,threads", "How many threads to run", cxxopts::value<int>()->default_value("1"))                           //
+        ("c,connections", "Max concurrent connections", cxxopts::value<int>()->default_value("1024"))                 //
         ("s,silent", "Silence statistics output", cxxopts::value<bool>()->default_value("false"))                     //
+        ("protocol", "jsonrpc_http or jsonrpc_tcp", cxxopts::value<std::string>()->default_value("jsonrpc_http"))     //
+        ("ssl", "Serve over TLS 1.3", cxxopts::value<bool>()->default_value("false"))                                 //
+        ("buffer", "Bytes of pre-allocated buffers per connection", cxxopts::value<std::uint32_t>())                  //
+        ("adaptive", "Keep heap buffers sized by recent messages", cxxopts::value<bool>()->default_value("false"))    //
+        ("certs", "Directory with main.key, srv.crt and cas.pem",                                                     //
+         cxxopts::value<std::string>()->default_value("./examples/login/certs"))                                      //
+        ("capture", "Record the requests into a file for `ucall_replay`", cxxopts::value<std::string>())              //
+        ("metrics", "Serve OpenMetrics on this path, like /metrics", cxxopts::value<std::string>())                   //
+        ("access", "Append NDJSON access logs to this file", cxxopts::value<std::string>())                           //
+        ("slow", "Log the state transitions of requests slower than this, in us",                                     //
+         cxxopts::value<std::uint32_t>())                                                                             //
+        ("perf", "Count hardware events around every N-th callback", cxxopts::value<std::uint32_t>())                 //
+        ("tcp_info", "Sample TCP_INFO of served connections every N us",                                              //
+         cxxopts::value<std::uint32_t>())                                                                             //
+        ("traces", "Append NDJSON spans of sampled traceparents to this file",                                        //
+         cxxopts::value<std::string>())                                                                               //
         ;
     auto result = options.parse(argc, argv);
     if (result.count("help")) {
@@ -43,16 +62,52 @@ int main(int argc, char** argv) {
     config.hostname = result["nic"].as<std::string>().c_str();
     config.port = result["port"].as<int>();
     config.max_threads = result["threads"].as<int>();
-    config.max_concurrent_connections = 1024;
+    config.max_concurrent_connections = result["connections"].as<int>();
     config.queue_depth = 4096 * config.max_threads;
     config.max_lifetime_exchanges = UINT32_MAX;
-    config.logs_file_descriptor = result["silent"].as<bool>() ? -1 : fileno(stdin);
+    if (result.count("buffer"))
+        config.connection_buffer_bytes = result["buffer"].as<std::uint32_t>();
+    config.adaptive_connection_buffers = result["adaptive"].as<bool>();
+    config.logs_file_descriptor = result["silent"].as<bool>() ? -1 : fileno(stdout);
     config.logs_format = "human";
-    config.protocol = protocol_type_t::jsonrpc_http_k;
-    // config.ssl_private_key_path = "./examples/login/certs/main.key";
-    // const char* crts[] = {"./examples/login/certs/srv.crt", "./examples/login/certs/cas.pem"};
-    // config.ssl_certificates_paths = crts;
-    // config.ssl_certificates_count = 2;
+    config.flight_dump_signal = SIGUSR2;
+    if (result.count("slow"))
+        config.slow_request_micro_seconds = result["slow"].as<std::uint32_t>();
+    config.slow_request_prefix_bytes = 64;
+    if (result.count("perf"))
+        config.perf_sampling_rate = result["perf"].as<std::uint32_t>();
+    if (result.count("tcp_info"))
+        config.tcp_info_period_micro_seconds = result["tcp_info"].as<std::uint32_t>();
+    std::string const& protocol = result["protocol"].as<std::string>();
+    if (protocol == "jsonrpc_http")
+        config.protocol = protocol_type_t::jsonrpc_http_k;
+    else if (protocol == "jsonrpc_tcp")
+        config.protocol = protocol_type_t::jsonrpc_tcp_k;
+    else {
+        std::printf("Unknown protocol: %s\n", protocol.c_str());
+        return -1;
+    }
+    std::string const& certs = result["certs"].as<std::string>();
+    std::string key_path = certs + "/main.key";
+    std::string crt_paths[] = {certs + "/srv.crt", certs + "/cas.pem"};
+    const char* crts[] = {crt_paths[0].c_str(), crt_paths[1].c_str()};
+    std::string capture_path = result.count("capture") ? result["capture"].as<std::string>() : std::string();
+    if (!capture_path.empty())
+        config.capture_path = capture_path.c_str();
+    std::string metrics_path = result.count("metrics") ? result["metrics"].as<std::string>() : std::string();
+    if (!metrics_path.empty())
+        config.metrics_path = metrics_path.c_str();
+    std::string access_path = result.count("access") ? result["access"].as<std::string>() : std::string();
+    if (!access_path.empty())
+        config.access_log_file_descriptor = open(access_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    std::string traces_path = result.count("traces") ? result["traces"].as<std::string>() : std::string();
+    if (!traces_path.empty())
+        config.trace_export_file_descriptor = open(traces_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (result["ssl"].as<bool>()) {
+        config.ssl_private_key_path = key_path.c_str();
+        config.ssl_certificates_paths = crts;
+        config.ssl_certificates_count = 2;
+    }
 
     ucall_init(&config, &server);
     if (!server) {
@@ -63,6 +118,25 @@ int main(int argc, char** argv) {
     std::printf("Initialized server: %s:%i\n", config.hostname, config.port);
     std::printf("- %zu threads\n", static_cast<std::size_t>(config.max_threads));
     std::printf("- %zu max concurrent connections\n", static_cast<std::size_t>(config.max_concurrent_connections));
+    std::printf("- %u bytes of buffers per connection%s\n", config.connection_buffer_bytes * 2u,
+                config.adaptive_connection_buffers ? ", adapting to the recent requests" : "");
+    if (config.ssl_certificates_count)
+        std::printf("- TLS with certificates from %s\n", certs.c_str());
+    if (config.capture_path)
+        std::printf("- capturing requests into %s\n", config.capture_path);
+    if (config.metrics_path)
+        std::printf("- serving metrics on %s\n", config.metrics_path);
+    if (config.access_log_file_descriptor > 0)
+        std::printf("- logging every request into %s\n", access_path.c_str());
+    if (config.slow_request_micro_seconds)
+        std::printf("- logging requests slower than %u us\n", config.slow_request_micro_seconds);
+    std::printf("- SIGUSR2 dumps the flight recorder\n");
+    if (config.perf_sampling_rate)
+        std::printf("- counting hardware events of every %u-th call\n", config.perf_sampling_rate);
+    if (config.tcp_info_period_micro_seconds)
+        std::printf("- sampling TCP_INFO every %u us per thread\n", config.tcp_info_period_micro_seconds);
+    if (config.trace_export_file_descriptor > 0)
+        std::printf("- exporting spans of sampled traces into %s\n", traces_path.c_str());
     if (result["silent"].as<bool>())
         std::printf("- silent\n");
 
@@ -1,3 +1,4 @@
+import asyncio
 import random
 
 from ucall.posix import Server
@@ -18,6 +19,12 @@ def validate_session(user_id: int, session_id: int):
     return (user_id ^ session_id) % 23 == 0
 
 
+@server
+async def validate_session_async(user_id: int, session_id: int, delay: float):
+    await asyncio.sleep(delay)
+    return (user_id ^ session_id) % 23 == 0
+
+
 @server
 def echo(data: bytes):
     return data
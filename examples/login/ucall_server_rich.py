@@ -31,5 +31,25 @@ def validate_all_sessions(user_ids: np.ndarray, session_ids: np.ndarray) -> bool
     return np.mod(np.logical_xor(user_ids, session_ids), 23)
 
 
+@server
+def transpose(matrix: np.ndarray) -> np.ndarray:
+    return matrix.T
+
+
+retained_matrices = []
+
+
+@server
+def retain_matrix(matrix: np.ndarray) -> int:
+    # Tensors own their decoded scalars, so they stay valid past the call.
+    retained_matrices.append(matrix)
+    return matrix.size
+
+
+@server
+def last_retained_sum() -> float:
+    return float(retained_matrices[-1].sum())
+
+
 if __name__ == "__main__":
     server.run()
@@ -0,0 +1,402 @@
+/**
+ * @brief Micro-benchmarks for the hot path of UCall servers, one component at a time.
+ *
+ * Every benchmark is parametrized by the payload size, from a tiny request fitting
+ * into the embedded buffers, to ones spilling into dynamic memory.
+ * The network engine is replaced with a no-op one, so `engine_t::raise_request`
+ * and the reply formatting run exactly as in the backends, just without system calls.
+ *
+ * The native client is measured against a loopback peer answering with a canned reply.
+ *
+ * Compare the runs of two commits with `compare.py` from Google Benchmark.
+ * To replay real traffic, point `UCALL_CAPTURE` to a file recorded by a server with `capture_path`.
+ */
+#include <arpa/inet.h>  // `htonl`
+#include <netinet/in.h> // `sockaddr_in`
+#include <sys/socket.h> // `accept`, `recv`, `send`
+#include <unistd.h>     // `write`
+
+#include <chrono>   // `std::chrono::steady_clock`
+#include <cstdlib>  // `std::getenv`
+#include <fstream>  // `std::ifstream`
+#include <iterator> // `std::istreambuf_iterator`
+#include <memory>   // `std::unique_ptr`
+#include <string>   // `std::string`
+#include <thread>   // `std::thread`
+#include <vector>   // `std::vector`
+
+#include <benchmark/benchmark.h>
+
+#include "ucall/client.h"
+
+#include "backend_core.hpp"
+#include "capture.hpp"
+
+namespace bm = benchmark;
+using namespace unum::ucall;
+
+static constexpr std::size_t payload_min_k = 64;
+static constexpr std::size_t payload_max_k = 64 * 1024;
+static constexpr std::size_t tls_record_size_k = 16 * 1024;
+
+#pragma region No-op Network Engine
+
+int network_engine_t::try_accept(descriptor_t, connection_t&) noexcept { return -1; }
+void network_engine_t::set_stats_heartbeat(connection_t&) noexcept {}
+void network_engine_t::send_packet(connection_t&, void*, std::size_t, std::size_t) noexcept {}
+void network_engine_t::recv_packet(connection_t&, void*, std::size_t, std::size_t) noexcept {}
+void network_engine_t::close_connection_gracefully(connection_t&) noexcept {}
+void network_engine_t::interrupt() noexcept {}
+bool network_engine_t::is_canceled(ssize_t, connection_t const&) noexcept { return false; }
+bool network_engine_t::is_corrupted(ssize_t, connection_t const&) noexcept { return false; }
+template <size_t max_count_ak> std::size_t network_engine_t::pop_completed_events(completed_event_t*) noexcept {
+    return 0;
+}
+
+#pragma endregion
+
+#pragma region Payloads
+
+static std::string make_jsonrpc(std::size_t payload_size) {
+    return R"({"jsonrpc":"2.0","method":"echo","params":{"text":")" + std::string(payload_size, 'x') +
+           R"("},"id":42})";
+}
+
+static std::string make_http(std::string const& body) {
+    return "POST / HTTP/1.1\r\n"
+           "Host: localhost:8545\r\n"
+           "User-Agent: ucall_microbench\r\n"
+           "Accept: */*\r\n"
+           "Content-Type: application/json\r\n"
+           "Content-Length: " +
+           std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+/// @brief Copies the packet with the padding SIMDJSON expects past the end of the input.
+static std::vector<char> make_padded(std::string const& packet) {
+    std::vector<char> padded(packet.size() + sj::SIMDJSON_PADDING);
+    std::memcpy(padded.data(), packet.data(), packet.size());
+    return padded;
+}
+
+#pragma endregion
+
+/**
+ * @brief A server with a single connection, that has just received a full request.
+ * Replays it as many times as needed, without touching the network.
+ */
+struct connection_fixture_t {
+    std::unique_ptr<server_t> server = std::make_unique<server_t>();
+    std::unique_ptr<connection_t> connection = std::make_unique<connection_t>();
+    std::vector<char> input;
+    std::vector<char> output = std::vector<char>(ram_page_size_k);
+    std::string reply;
+
+    connection_fixture_t(protocol_type_t protocol, std::string const& packet, std::size_t reply_size) {
+        input = make_padded(packet);
+        reply = '"' + std::string(reply_size, 'y') + '"';
+
+        server->protocol_type = protocol;
+        (void)server->engine.callbacks.reserve(16);
+        // Make the dispatch skip a few methods, as real servers have more than one.
+        static char const* other_methods_k[] = {"login", "logout", "sum", "validate_session", "ping"};
+        for (char const* name : other_methods_k)
+            server->engine.try_add_callback({{name, std::strlen(name)}, &echo, post_k, &reply});
+        server->engine.try_add_callback({{"echo", 4}, &echo, post_k, &reply});
+
+        connection->protocol.reset_protocol(protocol);
+        mount(input, packet.size());
+    }
+
+    /// @brief Replaces the received request with another one, already padded.
+    void mount(std::vector<char>& padded, std::size_t size) noexcept {
+        connection->stage = stage_t::expecting_reception_k;
+        connection->pipes.mount(padded.data(), output.data(), output.size(), false);
+        connection->pipes.absorb_input(size);
+    }
+
+    void raise() noexcept {
+        automata_t automata{*server, *connection};
+        connection->protocol.reset();
+        connection->pipes.release_outputs();
+        server->engine.raise_request(*connection, &automata);
+    }
+
+    static void echo(ucall_call_t call, ucall_callback_tag_t tag) {
+        ucall_str_t text{};
+        size_t text_len{};
+        if (!ucall_param_named_str(call, "text", 4, &text, &text_len))
+            return ucall_call_reply_error_invalid_params(call);
+        std::string const& reply = *reinterpret_cast<std::string const*>(tag);
+        ucall_call_reply_content(call, reply.data(), reply.size());
+    }
+};
+
+static void http_parse_headers(bm::State& state) {
+    std::string packet = make_http(make_jsonrpc(state.range(0)));
+    std::vector<char> padded = make_padded(packet);
+    http_protocol_t protocol;
+    for (auto _ : state) {
+        protocol.reset();
+        bm::DoNotOptimize(protocol.parse_headers({padded.data(), packet.size()}));
+    }
+    // Only the headers are parsed, so the body size should barely matter.
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void jsonrpc_parse_content(bm::State& state) {
+    std::string packet = make_jsonrpc(state.range(0)) + protocol_tcp_t::tcp_termination_symbol_k;
+    std::vector<char> padded = make_padded(packet);
+    auto protocol = std::make_unique<protocol_jsonrpc_t<protocol_tcp_t>>();
+    for (auto _ : state) {
+        protocol->parse_headers({padded.data(), packet.size()});
+        bm::DoNotOptimize(protocol->parse_content());
+    }
+    state.SetBytesProcessed(state.iterations() * packet.size());
+}
+
+static void jsonrpc_set_to(bm::State& state) {
+    std::string packet = make_jsonrpc(state.range(0)) + protocol_tcp_t::tcp_termination_symbol_k;
+    std::vector<char> padded = make_padded(packet);
+    auto protocol = std::make_unique<protocol_jsonrpc_t<protocol_tcp_t>>();
+    protocol->parse_headers({padded.data(), packet.size()});
+    if (protocol->parse_content())
+        return state.SkipWithError("Failed to parse the request");
+
+    sjd::element doc = std::get<sjd::element>(protocol->elements);
+    for (auto _ : state)
+        bm::DoNotOptimize(protocol->set_to(doc));
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void engine_raise_request(bm::State& state) {
+    std::size_t payload_size = state.range(0);
+    std::string packet = make_http(make_jsonrpc(payload_size));
+    connection_fixture_t fixture(protocol_type_t::jsonrpc_http_k, packet, payload_size);
+    for (auto _ : state) {
+        fixture.raise();
+        bm::DoNotOptimize(fixture.connection->pipes.output_span().data());
+    }
+    state.SetBytesProcessed(state.iterations() * packet.size());
+}
+
+static void pipes_append_outputs(bm::State& state) {
+    std::string chunk(state.range(0), 'x');
+    std::vector<char> input(ram_page_size_k), output(ram_page_size_k);
+    exchange_pipes_t pipes;
+    pipes.mount(input.data(), output.data(), output.size(), false);
+    for (auto _ : state) {
+        pipes.release_outputs();
+        // Replies are printed in pieces, like the JSON-RPC envelope around the content.
+        pipes.append_outputs({R"({"jsonrpc":"2.0","id":)", 22});
+        pipes.append_outputs({"42", 2});
+        pipes.append_outputs({R"(,"result":)", 10});
+        bm::DoNotOptimize(pipes.append_outputs(chunk));
+        pipes.append_outputs({"},", 2});
+    }
+    state.SetBytesProcessed(state.iterations() * chunk.size());
+}
+
+static void reply_error(bm::State& state) {
+    std::string note(state.range(0), 'e');
+    std::string packet = make_http(make_jsonrpc(8));
+    connection_fixture_t fixture(protocol_type_t::jsonrpc_http_k, packet, 8);
+    // Parse the request once, so that the error is addressed to its ID.
+    fixture.raise();
+    automata_t automata{*fixture.server, *fixture.connection};
+    for (auto _ : state) {
+        fixture.connection->pipes.release_outputs();
+        ucall_call_reply_error(&automata, -32602, note.data(), note.size());
+    }
+    state.SetBytesProcessed(state.iterations() * note.size());
+}
+
+/**
+ * @brief Seals and opens TLS 1.3 records with the same AEAD, that the handshake would negotiate,
+ * splitting the payload into records of the maximum size, just like `ptls_send`.
+ */
+static void tls_encrypt_decrypt(bm::State& state) {
+    ptls_cipher_suite_t* suite = &ptls_openssl_aes128gcmsha256;
+    std::uint8_t secret[PTLS_MAX_DIGEST_SIZE]{};
+    ptls_openssl_random_bytes(secret, suite->hash->digest_size);
+    ptls_aead_context_t* encryptor = ptls_aead_new(suite->aead, suite->hash, 1, secret, "tls13 ");
+    ptls_aead_context_t* decryptor = ptls_aead_new(suite->aead, suite->hash, 0, secret, "tls13 ");
+    if (!encryptor || !decryptor)
+        return state.SkipWithError("Failed to initialize the AEAD");
+
+    std::size_t payload_size = state.range(0);
+    std::vector<std::uint8_t> plain(payload_size, 'x');
+    std::vector<std::uint8_t> sealed(tls_record_size_k + suite->aead->tag_size);
+    std::vector<std::uint8_t> opened(tls_record_size_k);
+    std::uint64_t sequence = 0;
+    for (auto _ : state) {
+        for (std::size_t offset = 0; offset < payload_size; offset += tls_record_size_k, ++sequence) {
+            std::size_t record_size = (std::min)(payload_size - offset, tls_record_size_k);
+            std::size_t sealed_size = record_size + suite->aead->tag_size;
+            std::uint8_t header[5] = {23, 3, 3, std::uint8_t(sealed_size >> 8), std::uint8_t(sealed_size)};
+            ptls_aead_encrypt(encryptor, sealed.data(), plain.data() + offset, record_size, sequence, header, 5);
+            std::size_t opened_size =
+                ptls_aead_decrypt(decryptor, opened.data(), sealed.data(), sealed_size, sequence, header, 5);
+            if (opened_size != record_size)
+                return state.SkipWithError("Failed to decrypt a record");
+        }
+        bm::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * payload_size);
+
+    ptls_aead_free(encryptor);
+    ptls_aead_free(decryptor);
+}
+
+/**
+ * @brief Replays every request of a capture through `engine_t::raise_request`, in the recorded order.
+ * Methods other than the ones of the fixture are answered with errors, still parsing every request.
+ */
+static void engine_replay_capture(bm::State& state) {
+    char const* path = std::getenv("UCALL_CAPTURE");
+    if (!path)
+        return state.SkipWithError("Set UCALL_CAPTURE to replay a capture");
+    std::ifstream stream(path, std::ios::binary);
+    std::string file{std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+
+    capture_header_t header{};
+    std::vector<std::vector<char>> requests;
+    std::vector<std::size_t> sizes;
+    std::size_t total_bytes = 0;
+    bool is_valid = for_each_captured(file, header, [&](capture_record_t const&, std::string_view bytes) {
+        requests.push_back(make_padded(std::string(bytes)));
+        sizes.push_back(bytes.size());
+        total_bytes += bytes.size();
+    });
+    if (!is_valid || requests.empty())
+        return state.SkipWithError("Not a valid capture");
+
+    connection_fixture_t fixture(static_cast<protocol_type_t>(header.protocol), std::string(), 8);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i != requests.size(); ++i) {
+            fixture.mount(requests[i], sizes[i]);
+            fixture.raise();
+        }
+        bm::DoNotOptimize(fixture.connection->pipes.output_span().data());
+    }
+    state.SetItemsProcessed(state.iterations() * requests.size());
+    state.SetBytesProcessed(state.iterations() * total_bytes);
+}
+
+/**
+ * @brief Cost of a hot-path timestamp, taken a few times for every request.
+ * Compare with `clock_steady_now`, that the cycle clock falls back to, if it isn't calibrated.
+ */
+static void clock_cycle_now(bm::State& state) {
+    cycle_clock_t::calibrate();
+    if (!cycle_clock_t::is_calibrated())
+        return state.SkipWithError("No invariant cycle counter");
+    for (auto _ : state)
+        bm::DoNotOptimize(cycle_clock_t::now_ns());
+}
+
+static void clock_steady_now(bm::State& state) {
+    for (auto _ : state)
+        bm::DoNotOptimize(std::chrono::steady_clock::now());
+}
+
+/**
+ * @brief Loopback JSON-RPC over TCP server, answering every request with the same reply,
+ * without parsing it. Serves one connection at a time.
+ */
+struct canned_peer_t {
+    /// @brief Reply, followed by the terminator, that is a part of the literal.
+    static constexpr char reply_k[] = R"({"jsonrpc":"2.0","id":0,"result":null})";
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    std::uint16_t port{};
+    std::thread thread;
+
+    canned_peer_t() {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t address_length = sizeof(address);
+        if (bind(listener, (sockaddr*)&address, address_length) != 0 || listen(listener, 4) != 0 ||
+            getsockname(listener, (sockaddr*)&address, &address_length) != 0)
+            return;
+        port = ntohs(address.sin_port);
+        thread = std::thread([this] { serve(); });
+    }
+
+    ~canned_peer_t() {
+        shutdown(listener, SHUT_RDWR);
+        if (thread.joinable())
+            thread.join();
+        close(listener);
+    }
+
+    void serve() noexcept {
+        std::vector<char> input(64 * 1024), output;
+        int connection;
+        while ((connection = accept(listener, nullptr, nullptr)) >= 0) {
+            ssize_t received;
+            while ((received = recv(connection, input.data(), input.size(), 0)) > 0) {
+                // Every terminator closes a request, and they arrive in order.
+                output.clear();
+                for (ssize_t i = 0; i != received; ++i)
+                    if (input[i] == protocol_tcp_t::tcp_termination_symbol_k)
+                        output.insert(output.end(), reply_k, reply_k + sizeof(reply_k));
+                if (!output.empty() && send(connection, output.data(), output.size(), MSG_NOSIGNAL) < 0)
+                    break;
+            }
+            close(connection);
+        }
+    }
+};
+
+/**
+ * @brief Time per call through `ucall_client_call_many`, with one connection and the given pipeline depth.
+ * The peer does next to nothing, so this is an upper bound of the client-side overhead,
+ * that still includes the system calls of both sides, amortized over the pipelined calls.
+ */
+static void client_call_many(bm::State& state) {
+    canned_peer_t peer;
+    if (!peer.port)
+        return state.SkipWithError("Can't listen on loopback");
+
+    ucall_client_config_t config{};
+    config.port = peer.port;
+    config.protocol = jsonrpc_tcp_k;
+    config.max_connections = 1;
+    config.pipeline_depth = static_cast<std::uint32_t>(state.range(0));
+    ucall_client_t client{};
+    ucall_client_init(&config, &client);
+    if (!client)
+        return state.SkipWithError("Can't initialize the client");
+
+    constexpr std::size_t calls_k = 256;
+    std::string request = R"({"jsonrpc":"2.0","method":"ping","id":0})";
+    std::vector<ucall_str_t> requests(calls_k, request.c_str());
+    std::vector<std::size_t> lengths(calls_k, request.size());
+    std::size_t failures = 0;
+    auto on_reply = [](void* failures, size_t, int error, ucall_str_t, size_t) {
+        *reinterpret_cast<std::size_t*>(failures) += error != 0;
+    };
+    for (auto _ : state)
+        ucall_client_call_many(client, requests.data(), lengths.data(), calls_k, 0, on_reply, &failures);
+    ucall_client_free(client);
+
+    if (failures)
+        return state.SkipWithError("Some calls have failed");
+    state.SetItemsProcessed(state.iterations() * calls_k);
+}
+
+BENCHMARK(http_parse_headers)->RangeMultiplier(8)->Range(payload_min_k, payload_max_k);
+BENCHMARK(jsonrpc_parse_content)->RangeMultiplier(8)->Range(payload_min_k, payload_max_k);
+BENCHMARK(jsonrpc_set_to)->RangeMultiplier(8)->Range(payload_min_k, payload_max_k);
+BENCHMARK(engine_raise_request)->RangeMultiplier(8)->Range(payload_min_k, payload_max_k);
+BENCHMARK(pipes_append_outputs)->RangeMultiplier(8)->Range(payload_min_k, payload_max_k);
+BENCHMARK(reply_error)->RangeMultiplier(8)->Range(payload_min_k, payload_max_k);
+BENCHMARK(tls_encrypt_decrypt)->RangeMultiplier(8)->Range(payload_min_k, payload_max_k);
+BENCHMARK(engine_replay_capture);
+BENCHMARK(clock_cycle_now);
+BENCHMARK(clock_steady_now);
+BENCHMARK(client_call_many)->RangeMultiplier(4)->Range(1, 64)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,358 @@
+/**
+ * @brief Replays a traffic capture, recorded by a UCall server with `capture_path`, against a server.
+ *
+ * Every captured connection is reopened when its first request is due, and its requests
+ * are sent in the original order, each one no earlier than its original arrival time,
+ * scaled by `--speed`, and no earlier than the reply to the previous one. That is also how
+ * the server has answered them, as it captures and answers pipelined requests one at a time.
+ * With `--speed=0` the time gaps are dropped, and every connection sends back-to-back.
+ *
+ * Latencies are measured from the moment each request was due, not from when it was sent,
+ * so that a slow server can't hide its queueing delays.
+ */
+#include <netdb.h>       // `getaddrinfo`
+#include <netinet/in.h>  // `IPPROTO_TCP`
+#include <netinet/tcp.h> // `TCP_NODELAY`
+#include <strings.h>     // `strncasecmp`
+#include <sys/epoll.h>   // `epoll_create1`
+#include <sys/socket.h>  // `send`, `recv`
+#include <time.h>        // `clock_gettime`
+#include <unistd.h>      // `close`
+
+#include <algorithm> // `std::stable_sort`
+#include <cerrno>    // `errno`
+#include <cstdio>    // `std::printf`
+#include <fstream>   // `std::ifstream`
+#include <iostream>  // `std::cout`
+#include <iterator>  // `std::istreambuf_iterator`
+#include <queue>     // `std::priority_queue`
+#include <string>    // `std::string`
+#include <thread>    // `std::thread`
+#include <vector>    // `std::vector`
+
+#include <cxxopts.hpp>
+#include <picohttpparser.h>
+
+#include "capture.hpp"
+#include "histogram.hpp"
+
+using namespace unum::ucall;
+
+static constexpr std::size_t recv_chunk_k = 16 * 1024;
+static constexpr std::size_t max_http_headers_k = 32;
+static constexpr int max_events_k = 256;
+
+static std::uint64_t now_ns() noexcept {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1'000'000'000ull + ts.tv_nsec;
+}
+
+struct replay_config_t {
+    sockaddr_storage address{};
+    socklen_t address_length{};
+    bool use_http{};
+    /// @brief Multiplier for the playback speed, or zero to ignore the original timing.
+    double speed{};
+    double timeout_seconds{};
+};
+
+struct captured_request_t {
+    std::uint64_t timestamp_ns{};
+    std::string_view bytes;
+};
+
+struct replay_connection_t {
+    std::vector<captured_request_t> requests;
+    std::size_t next_request{};
+    int descriptor{-1};
+    std::uint64_t due_ns{};
+    std::string received;
+};
+
+struct replay_worker_t {
+    replay_config_t const* config{};
+    std::vector<replay_connection_t> connections;
+    std::uint64_t first_timestamp_ns{};
+
+    histogram_t latency;
+    std::size_t requests{};
+    std::size_t replies{};
+    std::size_t failures{};
+};
+
+static int send_all(int descriptor, void const* data, std::size_t length) noexcept {
+    char const* begin = static_cast<char const*>(data);
+    while (length) {
+        ssize_t sent = send(descriptor, begin, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return -1;
+        begin += sent, length -= sent;
+    }
+    return 0;
+}
+
+/**
+ * @brief Checks if the @p input starts with a complete reply.
+ * @return The length of the reply, zero if more bytes are needed, or -1 if it's malformed.
+ */
+static ssize_t reply_length(bool use_http, std::string_view input) noexcept {
+    if (!use_http) {
+        std::size_t terminator = input.find('\0');
+        return terminator == std::string_view::npos ? 0 : static_cast<ssize_t>(terminator + 1);
+    }
+
+    int minor_version, status;
+    char const* message;
+    std::size_t message_length;
+    phr_header headers[max_http_headers_k];
+    std::size_t headers_count = max_http_headers_k;
+    int headers_length = phr_parse_response(input.data(), input.size(), &minor_version, &status, &message,
+                                            &message_length, headers, &headers_count, 0);
+    if (headers_length == -2)
+        return 0;
+    if (headers_length < 0)
+        return -1;
+    std::size_t content_length = 0;
+    for (std::size_t i = 0; i != headers_count; ++i)
+        if (headers[i].name_len == 14 && strncasecmp(headers[i].name, "Content-Length", 14) == 0)
+            content_length = std::strtoull(headers[i].value, nullptr, 10);
+    if (input.size() < headers_length + content_length)
+        return 0;
+    return static_cast<ssize_t>(headers_length + content_length);
+}
+
+static void close_connection(replay_worker_t& worker, replay_connection_t& connection) noexcept {
+    if (connection.descriptor >= 0)
+        close(connection.descriptor);
+    connection.descriptor = -1;
+    worker.failures += connection.requests.size() - connection.next_request;
+    connection.next_request = connection.requests.size();
+}
+
+static void run_worker(replay_worker_t& worker) noexcept {
+    replay_config_t const& config = *worker.config;
+    int epoll_descriptor = epoll_create1(0);
+    if (epoll_descriptor < 0)
+        return;
+
+    // Connections are kept in a min-heap by the time their next request is due.
+    using due_t = std::pair<std::uint64_t, std::uint32_t>;
+    std::priority_queue<due_t, std::vector<due_t>, std::greater<due_t>> schedule;
+    std::uint64_t start_ns = now_ns();
+    auto due_of = [&](captured_request_t const& request) noexcept {
+        if (config.speed <= 0)
+            return start_ns;
+        return start_ns + static_cast<std::uint64_t>((request.timestamp_ns - worker.first_timestamp_ns) / config.speed);
+    };
+    for (std::size_t i = 0; i != worker.connections.size(); ++i) {
+        replay_connection_t& connection = worker.connections[i];
+        connection.due_ns = due_of(connection.requests.front());
+        schedule.emplace(connection.due_ns, static_cast<std::uint32_t>(i));
+    }
+
+    std::size_t awaiting = 0;
+    std::uint64_t last_progress_ns = start_ns;
+    epoll_event events[max_events_k];
+    char chunk[recv_chunk_k];
+    while (!schedule.empty() || awaiting) {
+        std::uint64_t now = now_ns();
+        while (!schedule.empty() && schedule.top().first <= now) {
+            replay_connection_t& connection = worker.connections[schedule.top().second];
+            std::uint32_t connection_idx = schedule.top().second;
+            schedule.pop();
+
+            if (connection.descriptor < 0) {
+                int descriptor = socket(config.address.ss_family, SOCK_STREAM, IPPROTO_TCP);
+                int no_delay = 1;
+                setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+                connection.descriptor = descriptor;
+                epoll_event event{};
+                event.events = EPOLLIN | EPOLLRDHUP;
+                event.data.u32 = connection_idx;
+                if (descriptor < 0 ||
+                    ::connect(descriptor, (sockaddr const*)&config.address, config.address_length) != 0 ||
+                    epoll_ctl(epoll_descriptor, EPOLL_CTL_ADD, descriptor, &event) != 0) {
+                    close_connection(worker, connection);
+                    continue;
+                }
+            }
+
+            std::string_view request = connection.requests[connection.next_request].bytes;
+            if (send_all(connection.descriptor, request.data(), request.size()) != 0) {
+                close_connection(worker, connection);
+                continue;
+            }
+            worker.requests++;
+            awaiting++;
+        }
+
+        // Rounding down, so that we spin for the last millisecond, instead of sending late.
+        int timeout_ms = 100;
+        if (!schedule.empty())
+            timeout_ms = static_cast<int>((std::min<std::uint64_t>)( //
+                ((std::max)(schedule.top().first, now) - now) / 1'000'000, timeout_ms));
+        int count = epoll_wait(epoll_descriptor, events, max_events_k, timeout_ms);
+        now = now_ns();
+        if (count <= 0) {
+            if (schedule.empty() && now - last_progress_ns > config.timeout_seconds * 1e9)
+                break;
+            continue;
+        }
+
+        for (int i = 0; i != count; ++i) {
+            replay_connection_t& connection = worker.connections[events[i].data.u32];
+            ssize_t length = connection.descriptor < 0 ? 0 : recv(connection.descriptor, chunk, recv_chunk_k, 0);
+            if (length <= 0) {
+                if (length < 0 && errno == EINTR)
+                    continue;
+                awaiting -= connection.descriptor >= 0;
+                close_connection(worker, connection);
+                continue;
+            }
+
+            connection.received.append(chunk, length);
+            ssize_t complete = reply_length(config.use_http, connection.received);
+            if (complete == 0)
+                continue;
+            awaiting--;
+            if (complete < 0) {
+                close_connection(worker, connection);
+                continue;
+            }
+
+            connection.received.erase(0, complete);
+            worker.latency.record(now - connection.due_ns);
+            worker.replies++;
+            last_progress_ns = now;
+            if (++connection.next_request == connection.requests.size()) {
+                close(connection.descriptor);
+                connection.descriptor = -1;
+                continue;
+            }
+            connection.due_ns = (std::max)(due_of(connection.requests[connection.next_request]), now);
+            schedule.emplace(connection.due_ns, std::uint32_t(events[i].data.u32));
+        }
+    }
+
+    for (replay_connection_t& connection : worker.connections)
+        close_connection(worker, connection);
+    close(epoll_descriptor);
+}
+
+int main(int argc, char** argv) {
+
+    cxxopts::Options options("ucall_replay", "Replays a traffic capture against a UCall server");
+    options.add_options()                                                                                             //
+        ("h,help", "Print usage")                                                                                     //
+        ("capture", "Path to the capture file", cxxopts::value<std::string>())                                        //
+        ("host", "Server hostname or IP", cxxopts::value<std::string>()->default_value("127.0.0.1"))                  //
+        ("p,port", "Server port", cxxopts::value<int>()->default_value("8545"))                                       //
+        ("j,threads", "Threads, sharing the captured connections", cxxopts::value<std::size_t>()->default_value("1")) //
+        ("speed", "Playback speed, 0 for as fast as possible", cxxopts::value<double>()->default_value("1"))          //
+        ("timeout", "Seconds to wait for late replies", cxxopts::value<double>()->default_value("2"))                 //
+        ;
+    auto result = options.parse(argc, argv);
+    if (result.count("help") || !result.count("capture")) {
+        std::cout << options.help() << std::endl;
+        return result.count("help") ? 0 : 1;
+    }
+
+    std::string const& capture_path = result["capture"].as<std::string>();
+    std::ifstream capture_stream(capture_path, std::ios::binary);
+    std::string capture{std::istreambuf_iterator<char>(capture_stream), std::istreambuf_iterator<char>()};
+
+    // Group the requests by connection.
+    capture_header_t header{};
+    std::vector<replay_connection_t> connections;
+    std::vector<std::uint32_t> connection_offsets;
+    std::uint64_t first_timestamp_ns = UINT64_MAX, last_timestamp_ns = 0;
+    std::size_t requests_count = 0;
+    bool is_valid = for_each_captured(capture, header, [&](capture_record_t const& record, std::string_view bytes) {
+        if (record.connection_id >= connection_offsets.size())
+            connection_offsets.resize(record.connection_id + 1, UINT32_MAX);
+        std::uint32_t& offset = connection_offsets[record.connection_id];
+        if (offset == UINT32_MAX) {
+            offset = static_cast<std::uint32_t>(connections.size());
+            connections.emplace_back();
+        }
+        connections[offset].requests.push_back({record.timestamp_ns, bytes});
+        first_timestamp_ns = (std::min)(first_timestamp_ns, record.timestamp_ns);
+        last_timestamp_ns = (std::max)(last_timestamp_ns, record.timestamp_ns);
+        requests_count++;
+    });
+    if (!is_valid || !requests_count) {
+        std::fprintf(stderr, "Not a valid capture: %s\n", capture_path.c_str());
+        return 1;
+    }
+
+    // Records are only ordered within the server thread that captured them.
+    for (replay_connection_t& connection : connections)
+        std::stable_sort(connection.requests.begin(), connection.requests.end(),
+                         [](captured_request_t const& a, captured_request_t const& b) noexcept {
+                             return a.timestamp_ns < b.timestamp_ns;
+                         });
+
+    replay_config_t config;
+    config.use_http = header.protocol != jsonrpc_tcp_k && header.protocol != tcp_k;
+    config.speed = result["speed"].as<double>();
+    config.timeout_seconds = result["timeout"].as<double>();
+    std::string hostname = result["host"].as<std::string>();
+    std::string port = std::to_string(result["port"].as<int>());
+    addrinfo hints{};
+    addrinfo* resolved = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(hostname.c_str(), port.c_str(), &hints, &resolved) != 0 || !resolved) {
+        std::fprintf(stderr, "Failed to resolve: %s\n", hostname.c_str());
+        return 1;
+    }
+    std::memcpy(&config.address, resolved->ai_addr, resolved->ai_addrlen);
+    config.address_length = resolved->ai_addrlen;
+    freeaddrinfo(resolved);
+
+    // Connections are dealt to threads round-robin, each keeping all of its requests.
+    std::size_t threads_count = (std::max)(result["threads"].as<std::size_t>(), std::size_t(1));
+    std::vector<replay_worker_t> workers(threads_count);
+    for (std::size_t i = 0; i != connections.size(); ++i)
+        workers[i % threads_count].connections.push_back(std::move(connections[i]));
+    for (replay_worker_t& worker : workers)
+        worker.config = &config, worker.first_timestamp_ns = first_timestamp_ns;
+
+    std::uint64_t started_ns = now_ns();
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < threads_count; ++i)
+        threads.emplace_back(&run_worker, std::ref(workers[i]));
+    run_worker(workers[0]);
+    for (auto& thread : threads)
+        thread.join();
+    double elapsed_seconds = (now_ns() - started_ns) / 1e9;
+
+    replay_worker_t& total = workers[0];
+    for (std::size_t i = 1; i != threads_count; ++i) {
+        total.latency.merge(workers[i].latency);
+        total.requests += workers[i].requests;
+        total.replies += workers[i].replies;
+        total.failures += workers[i].failures;
+    }
+
+    histogram_t const& latency = total.latency;
+    std::printf("{\n");
+    std::printf("  \"capture\": \"%s\",\n  \"speed\": %.3f,\n", capture_path.c_str(), config.speed);
+    std::printf("  \"connections\": %zu,\n  \"threads\": %zu,\n", connections.size(), threads_count);
+    std::printf("  \"captured_requests\": %zu,\n", requests_count);
+    std::printf("  \"captured_seconds\": %.3f,\n", (last_timestamp_ns - first_timestamp_ns) / 1e9);
+    std::printf("  \"elapsed_seconds\": %.3f,\n", elapsed_seconds);
+    std::printf("  \"achieved_rate\": %.1f,\n", total.replies / elapsed_seconds);
+    std::printf("  \"requests\": %zu,\n  \"replies\": %zu,\n", total.requests, total.replies);
+    std::printf("  \"failures\": %zu,\n", total.failures);
+    std::printf("  \"latency_micro_seconds\": {\"count\": %zu, \"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, "
+                "\"p90\": %.3f, \"p99\": %.3f, \"p99.9\": %.3f, \"max\": %.3f}\n",
+                static_cast<std::size_t>(latency.count()), latency.min() / 1e3, latency.mean() / 1e3,
+                latency.percentile(50) / 1e3, latency.percentile(90) / 1e3, latency.percentile(99) / 1e3,
+                latency.percentile(99.9) / 1e3, latency.max() / 1e3);
+    std::printf("}\n");
+    return total.failures ? 1 : 0;
+}
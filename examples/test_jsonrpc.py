@@ -1,9 +1,17 @@
+import asyncio
+import http.client
+import json
 import random
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
 
 import requests
 import numpy as np
 from PIL import Image
-from ucall.client import Client, ClientTLS
+from ucall.client import AsyncExecutorClientPool, Client, ClientPool, ClientTLS
+from ucall.posix import Server
+from ucall.server import Protocol
 from login.jsonrpc_client import CaseHTTP, CaseHTTPBatches, CaseTCP, CaseTLS
 
 
@@ -30,6 +38,229 @@ def shuffled_n_identities(class_, count_clients: int = 3, count_cycles: int = 10
             client.recv()
 
 
+def test_coroutines_overlap():
+    client = ClientGeneric()
+    count_calls, delay = 16, 0.2
+
+    def call(identity: int):
+        return client(
+            {
+                "method": "validate_session_async",
+                "params": {"user_id": identity, "session_id": identity * 23, "delay": delay},
+                "jsonrpc": "2.0",
+                "id": identity,
+            }
+        )
+
+    start = time.perf_counter()
+    with ThreadPoolExecutor(count_calls) as pool:
+        responses = list(pool.map(call, range(count_calls)))
+    elapsed = time.perf_counter() - start
+
+    for identity, response in enumerate(responses):
+        assert response["id"] == identity
+        assert response["result"] == ((identity ^ (identity * 23)) % 23 == 0)
+    assert elapsed < count_calls * delay / 2
+
+
+def test_stats_from_another_thread():
+    server = Server(port=8546, protocol=Protocol.JSONRPC_HTTP)
+
+    @server.post()
+    def add(a: int, b: int):
+        return a + b
+
+    count_calls = 16
+    with ThreadPoolExecutor(1) as pool:
+        running = pool.submit(server.run, -1, 3)
+        client = ClientGeneric(port=8546)
+        for identity in range(count_calls):
+            response = client(
+                {
+                    "method": "add",
+                    "params": {"a": identity, "b": 1},
+                    "jsonrpc": "2.0",
+                    "id": identity,
+                }
+            )
+            assert response["result"] == identity + 1
+
+        # Requests are accounted once their replies are sent, which may be after they arrive.
+        deadline = time.perf_counter() + 1
+        stats = server.stats
+        while stats["methods"]["add"]["request"]["count"] < count_calls and time.perf_counter() < deadline:
+            stats = server.stats
+        assert running.result() is None
+
+    assert stats["methods"]["add"]["callback"]["count"] == count_calls
+    assert stats["methods"]["add"]["request"]["count"] == count_calls
+    assert stats["connections_accepted"] >= 1
+    assert stats["bytes_received"] > 0 and stats["bytes_sent"] > 0
+
+    # Reading the stats doesn't reset them, and exhausted cycles return control to the caller.
+    assert server.stats["methods"]["add"]["callback"]["count"] == count_calls
+    assert server.run(8) is None
+
+
+def test_metrics():
+    server = Server(port=8547, protocol=Protocol.JSONRPC_HTTP, metrics_path="/metrics")
+
+    @server.post()
+    def add(a: int, b: int):
+        return a + b
+
+    # Every method exports two histograms, so the scrape outgrows the pre-allocated buffer.
+    for identity in range(32):
+        server.post(f"noop_{identity}")(lambda: None)
+
+    call = json.dumps({"method": "add", "params": {"a": 2, "b": 3}, "jsonrpc": "2.0", "id": 0})
+    with ThreadPoolExecutor(1) as pool:
+        running = pool.submit(server.run, -1, 2)
+        connection = http.client.HTTPConnection("127.0.0.1", 8547)
+        connection.request("POST", "/", call, {"Content-Type": "application/json"})
+        assert json.loads(connection.getresponse().read())["result"] == 5
+        connection.request("GET", "/metrics")
+        scrape = connection.getresponse()
+        content_type, text = scrape.getheader("Content-Type"), scrape.read().decode()
+        # The scrape is consumed, and the connection keeps serving calls.
+        connection.request("POST", "/", call, {"Content-Type": "application/json"})
+        assert json.loads(connection.getresponse().read())["result"] == 5
+        connection.close()
+        assert running.result() is None
+
+    assert scrape.status == 200
+    assert content_type.startswith("application/openmetrics-text")
+    assert len(text) > 4096 and text.endswith("# EOF\n")
+    assert 'ucall_method_callback_seconds_count{method="add"} 1\n' in text
+    assert 'ucall_method_callback_seconds_count{method="noop_31"} 0\n' in text
+
+
+def served_over_http(server: Server, port: int, calls: list) -> list:
+    """
+    Runs the `server` for a couple of seconds, sending it `(method, params)` calls over a single connection.
+    Calls may have a third member, with additional HTTP headers.
+    """
+    results = []
+    with ThreadPoolExecutor(1) as pool:
+        running = pool.submit(server.run, -1, 2)
+        connection = http.client.HTTPConnection("127.0.0.1", port)
+        for identity, (method, params, *headers) in enumerate(calls):
+            call = json.dumps({"method": method, "params": params, "jsonrpc": "2.0", "id": identity})
+            connection.request("POST", "/", call, {"Content-Type": "application/json", **dict(*headers)})
+            results.append(json.loads(connection.getresponse().read()).get("result"))
+        connection.close()
+        assert running.result() is None
+    return results
+
+
+def test_slow_requests_log():
+    with tempfile.TemporaryFile("w+") as log:
+        server = Server(port=8550, quiet=True, logs_file_descriptor=log.fileno(), logs_format="json",
+                        slow_request_micro_seconds=10_000, slow_request_prefix_bytes=4)
+
+        @server.post()
+        def add(a: int, b: int):
+            return a + b
+
+        @server.post()
+        def nap(seconds: float):
+            time.sleep(seconds)
+            return seconds
+
+        calls = [("add", {"a": 2, "b": 3}), ("nap", {"seconds": 0.05}), ("add", {"a": 4, "b": 5})]
+        assert served_over_http(server, 8550, calls) == [5, 0.05, 9]
+        # Destroying the server stops its writer, once everything queued is printed.
+        del server
+        log.seek(0)
+        entries = [json.loads(line)["slow_request"] for line in log if '"slow_request"' in line]
+
+    assert len(entries) == 1
+    assert entries[0]["method"] == "nap" and entries[0]["prefix"] == "POST"
+    assert entries[0]["total_ns"] >= 50_000_000 and entries[0]["callback_ns"] >= 50_000_000
+
+
+def test_access_log():
+    with tempfile.TemporaryFile("w+") as log:
+        server = Server(port=8551, quiet=True, access_log_file_descriptor=log.fileno())
+
+        @server.post()
+        def add(a: int, b: int):
+            return a + b
+
+        calls = [("add", {"a": 2, "b": 3}), ("subtract", {"a": 2, "b": 3}), ("add", {"a": 4, "b": 5})]
+        assert served_over_http(server, 8551, calls) == [5, None, 9]
+        del server
+        log.seek(0)
+        entries = [json.loads(line) for line in log]
+
+    # Only the names of registered methods are logged, as the request buffers are reused.
+    assert [entry["method"] for entry in entries] == ["add", "", "add"]
+    assert [entry["status"] for entry in entries] == [0, -32601, 0]
+    assert all(entry["client"].startswith("127.0.0.1:") for entry in entries)
+    assert all(entry["request_bytes"] > 0 and entry["reply_bytes"] > 0 for entry in entries)
+    assert all(entry["latency_ns"] > 0 for entry in entries)
+
+
+def test_trace_export():
+    with tempfile.TemporaryFile("w+") as log:
+        server = Server(port=8552, quiet=True, trace_export_file_descriptor=log.fileno())
+
+        @server.post()
+        def add(a: int, b: int):
+            return a + b
+
+        parent, trace_ids = "00f067aa0ba902b7", [f"{identity:032x}" for identity in range(1, 9)]
+        traceparents = [
+            f"00-{trace_ids[0]}-{parent}-01",  # Sampled
+            f"00-{trace_ids[1]}-{parent}-00",  # Not sampled
+            f"ff-{trace_ids[2]}-{parent}-01",  # Forbidden version
+            f"00-{trace_ids[3]}-{parent}-01-future",  # Fields can only be appended by future versions
+            f"cc-{trace_ids[4]}-{parent}-01-future",  # Future versions are parsed as version 00
+            f"00-{'0' * 32}-{parent}-01",  # All-zero trace ID
+            f"00-{trace_ids[6]}-{'0' * 16}-01",  # All-zero parent span ID
+            f"00-{trace_ids[7][:-1]}x-{parent}-01",  # Not hexadecimal
+        ]
+        calls = [("add", {"a": 2, "b": 3}, {"traceparent": traceparent}) for traceparent in traceparents]
+        assert served_over_http(server, 8552, calls) == [5] * len(calls)
+        del server
+        log.seek(0)
+        spans = [json.loads(line) for line in log]
+
+    assert [span["trace_id"] for span in spans] == [trace_ids[0], trace_ids[4]]
+    for span in spans:
+        assert span["parent_span_id"] == parent and span["name"] == "add" and span["status"] == 0
+        assert len(span["span_id"]) == 16 and span["span_id"] not in ("0" * 16, parent)
+        assert span["start_unix_ns"] <= span["end_unix_ns"]
+    assert spans[0]["span_id"] != spans[1]["span_id"]
+
+
+def test_adaptive_connection_buffers():
+    text = "x" * 20_000
+
+    def heap_allocations(port: int, **settings) -> tuple:
+        """Serves the same large call 8 times over one connection, counting the allocations of its buffers."""
+        server = Server(port=port, quiet=True, **settings)
+
+        @server.post()
+        def echo(text: str):
+            return text
+
+        assert served_over_http(server, port, [("echo", {"text": text})] * 8) == [text] * 8
+        stats = server.stats
+        return stats["input_buffers"]["count"], stats["output_buffers"]["count"]
+
+    fixed = heap_allocations(8553)
+    adaptive = heap_allocations(8554, adaptive_connection_buffers=True)
+    large = heap_allocations(8555, connection_buffer_bytes=32 * 1024)
+
+    # Every request and reply spills out of the default page, into a buffer allocated anew.
+    assert fixed[0] >= 8 and fixed[1] >= 8
+    # Adaptive buffers are kept between the requests of a connection.
+    assert 1 <= adaptive[0] < 8 and 1 <= adaptive[1] < 8
+    # Messages fitting the pre-allocated buffers never touch the heap.
+    assert large == (0, 0)
+
+
 def test_shuffled_tcp():
     for connections in range(1, 10):
         shuffled_n_identities(CaseTCP, count_clients=connections)
@@ -97,6 +328,53 @@ def test_normal_positional_tls():
     assert response.json == True
 
 
+def test_native_pool():
+    client = ClientPool(connections=4)
+    assert client.validate_session(user_id=2, session_id=2) == True
+    assert client.call('validate_session', [2, 3]) == False
+
+    calls = [('validate_session', {'user_id': i, 'session_id': i * 23}) for i in range(256)]
+    expected = [(i ^ (i * 23)) % 23 == 0 for i in range(256)]
+    assert client.call_many(calls) == expected
+    assert client.batch(calls[:16]) == expected[:16]
+
+    results = client.call_many([('sumsum', [2, 2]), calls[1]], return_exceptions=True)
+    assert isinstance(results[0], RuntimeError) and results[0].args[0]['code'] == -32601
+    assert results[1] == expected[1]
+
+
+def test_native_pool_async():
+    client = AsyncExecutorClientPool(connections=4)
+
+    async def gather():
+        singles = [client.validate_session(user_id=i, session_id=i * 23) for i in range(16)]
+        return await asyncio.gather(*singles, client.call_many([('validate_session', [1, 23])]))
+
+    *results, many = asyncio.run(gather())
+    assert results == [(i ^ (i * 23)) % 23 == 0 for i in range(16)]
+    assert many == [(1 ^ 23) % 23 == 0]
+
+
+def test_native_pool_pipelined():
+    # A single connection, so that the server receives many requests in every packet.
+    for port, protocol, use_http in [(8548, Protocol.JSONRPC_HTTP, True), (8549, Protocol.JSONRPC_TCP, False)]:
+        server = Server(port=port, protocol=protocol)
+
+        @server.post()
+        def add(a: int, b: int):
+            return a + b
+
+        with ThreadPoolExecutor(1) as pool:
+            running = pool.submit(server.run, -1, 2)
+            client = ClientPool(port=port, use_http=use_http, connections=1, pipeline_depth=64)
+            calls = [('add', {'a': i, 'b': 1}) for i in range(1024)]
+            assert client.call_many(calls) == [i + 1 for i in range(1024)]
+            assert running.result() is None
+
+        assert server.stats["connections_accepted"] == 1
+        assert server.stats["methods"]["add"]["request"]["count"] == 1024
+
+
 def test_notification():
     client = ClientGeneric()
     response = client(
@@ -189,6 +467,38 @@ def test_numpy():
     assert np.array_equal(response.numpy, res)
 
 
+def test_numpy_dtypes():
+    client = Client()
+    for dtype in (np.bool_, np.uint8, np.int16, np.int64, np.float16, np.float32, np.float64, np.longdouble):
+        matrix = (np.random.rand(3, 7) * 100).astype(dtype)
+        response = client.transpose(matrix=matrix)
+        response.raise_for_status()
+        result = response.numpy
+        assert result.dtype == matrix.dtype
+        assert np.array_equal(result, matrix.T)
+
+
+def test_numpy_retained():
+    client = Client()
+    matrix = np.arange(12, dtype=np.float32).reshape(3, 4)
+    response = client.retain_matrix(matrix=matrix)
+    assert response.json == matrix.size
+
+    # The following requests reuse the receive buffer, but not the retained scalars.
+    response = client.transpose(matrix=np.full_like(matrix, -1))
+    assert np.array_equal(response.numpy, np.full_like(matrix.T, -1))
+    assert client.last_retained_sum().json == matrix.sum()
+
+
+def test_native_pool_numpy():
+    client = ClientPool()
+    matrix = np.arange(12, dtype=np.float32).reshape(3, 4)
+    result = client.transpose(matrix=matrix)
+    assert isinstance(result, np.ndarray) and not result.flags.writeable
+    assert result.dtype == matrix.dtype and np.array_equal(result, matrix.T)
+    assert client.call_many([('transpose', {'matrix': matrix})])[0].shape == (4, 3)
+
+
 def test_pillow():
     img = Image.open("examples/login/original.jpg")
     res = img.rotate(45)
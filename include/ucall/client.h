@@ -0,0 +1,132 @@
+/**
+ * @file client.h
+ * @addtogroup C
+ *
+ * @brief Binary Interface for UCall clients.
+ *
+ * ## Basic Usage
+ *
+ * - `ucall_client_init()` - to configure a pool of connections to one server,
+ * - `ucall_client_call()` - to exchange a single JSON-RPC request,
+ * - `ucall_client_call_many()` - to pipeline many requests across pooled connections,
+ * - `ucall_client_batch()` - to pack many requests into a single JSON-RPC batch,
+ * - `ucall_client_free()` - to close all connections.
+ *
+ * Requests are passed as serialized JSON-RPC objects, without the transport framing.
+ * Replies are passed into a callback as soon as they arrive, pointing straight into
+ * the receiving buffers of the connection, so nothing is allocated per call,
+ * once the connection buffers have warmed up.
+ *
+ * A single client can be shared by any number of threads. Every exchange locks one or more
+ * idle connections from the pool, reconnecting transparently if the server has closed them.
+ */
+
+#pragma once
+
+#include "ucall.h" // `ucall_str_t`, `protocol_type_t`
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void* ucall_client_t;
+
+/**
+ * @brief Receives a reply to one of the submitted requests.
+ *
+ * @param user_data The pointer passed into the exchange function.
+ * @param request_idx Index of the request within the submitted array.
+ * @param error Zero, if the reply has arrived, or an `errno` code, like `ETIMEDOUT`,
+ * `ECONNREFUSED`, `ECONNRESET` or `EPROTO`, if the request has failed.
+ * @param reply The JSON-RPC reply object, or batch array, without the transport framing.
+ * Only valid until the callback returns.
+ */
+typedef void (*ucall_client_reply_t)(void* user_data, size_t request_idx, int error, ucall_str_t reply,
+                                     size_t reply_length);
+
+/**
+ * @brief Configuration parameters for `ucall_client_init()`.
+ */
+typedef struct ucall_client_config_t {
+    char const* hostname;
+    uint16_t port;
+
+    /// @brief Either `jsonrpc_tcp_k` or `jsonrpc_http_k`.
+    protocol_type_t protocol;
+
+    /// @brief Number of pooled connections, defaults to 4.
+    uint32_t max_connections;
+    /// @brief Max requests in flight per connection, defaults to 16.
+    /// UCall servers answer pipelined requests in order, but set it to 1 for servers that don't.
+    uint32_t pipeline_depth;
+    /// @brief Deadline of every exchange, unless overridden, defaults to 10 seconds.
+    uint32_t timeout_micro_seconds;
+
+    /// @brief Encrypts all the connections with TLS 1.3.
+    bool ssl;
+    /// @brief Skips the verification of the server certificate, for self-signed certificates.
+    bool ssl_allow_self_signed;
+    /// @brief Optional PEM file with trusted certificate authorities, instead of the system ones.
+    char const* ssl_certificate_authorities_path;
+} ucall_client_config_t;
+
+/**
+ * @param config Input and output argument, that will be updated to export set configuration.
+ * @param client Output variable, which, on success, will be an initialized client.
+ * Connections are established lazily, on the first call.
+ * Don't forget to free its memory with `ucall_client_free()` at the end.
+ */
+void ucall_client_init(ucall_client_config_t* config, ucall_client_t* client);
+
+void ucall_client_free(ucall_client_t);
+
+/**
+ * @brief Sends a single request and blocks until the reply arrives or the deadline expires.
+ *
+ * @param request Serialized JSON-RPC object, or batch array. Must be valid until the function returns.
+ * @param request_length Length of the @p request, or zero for NULL-terminated strings.
+ * @param timeout_micro_seconds Deadline for this call, or zero for the configured default.
+ * @param callback Called exactly once, with `request_idx` set to zero.
+ */
+void ucall_client_call(             //
+    ucall_client_t client,          //
+    ucall_str_t request,            //
+    size_t request_length,          //
+    uint32_t timeout_micro_seconds, //
+    ucall_client_reply_t callback,  //
+    void* user_data);
+
+/**
+ * @brief Spreads many requests across the idle pooled connections, keeping up to
+ * `pipeline_depth` requests in flight on each of them, and blocks until all replies arrive.
+ *
+ * @param callback Called exactly once per request, in the order in which the replies arrive.
+ */
+void ucall_client_call_many(        //
+    ucall_client_t client,          //
+    ucall_str_t const* requests,    //
+    size_t const* requests_lengths, //
+    size_t requests_count,          //
+    uint32_t timeout_micro_seconds, //
+    ucall_client_reply_t callback,  //
+    void* user_data);
+
+/**
+ * @brief Joins many serialized JSON-RPC objects into a single batch array,
+ * sending it with one round-trip. The server may reorder the replies in the batch,
+ * so match them by "id".
+ *
+ * @param callback Called exactly once, with the whole array of replies.
+ */
+void ucall_client_batch(            //
+    ucall_client_t client,          //
+    ucall_str_t const* requests,    //
+    size_t const* requests_lengths, //
+    size_t requests_count,          //
+    uint32_t timeout_micro_seconds, //
+    ucall_client_reply_t callback,  //
+    void* user_data);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
@@ -41,6 +41,7 @@ extern "C" {
 typedef void* ucall_server_t;
 typedef void* ucall_call_t;
 typedef void* ucall_callback_tag_t;
+typedef void* ucall_deferred_t;
 typedef char const* ucall_str_t;
 
 typedef void (*ucall_callback_t)(ucall_call_t, ucall_callback_tag_t);
@@ -99,6 +100,53 @@ typedef struct ucall_config_t {
     char const** ssl_certificates_paths;
     /// @brief Certificates count.
     size_t ssl_certificates_count;
+
+    /// @brief Optional path of a binary log, where every complete request is recorded
+    /// with its arrival time and connection ID, to be replayed later with `ucall_replay`.
+    char const* capture_path;
+
+    /// @brief Optional path, like "/metrics", answering HTTP `GET` requests on the main port
+    /// with the server's counters, gauges and latency histograms in the OpenMetrics text format.
+    char const* metrics_path;
+
+    /// @brief Requests slower than this, from arrival to the last byte of the reply, are logged with their
+    /// method, client, sizes, time spent in every stage, and recent state transitions of their connection.
+    /// Entries are printed by a separate thread, and dropped if it falls behind. Zero disables it.
+    uint32_t slow_request_micro_seconds;
+    /// @brief How many first bytes of every slow request to include into its log entry, up to 256.
+    uint32_t slow_request_prefix_bytes;
+
+    /// @brief Optional file descriptor for the access log, with one NDJSON line per request: its method,
+    /// error code, latency, sizes and client. Lines are printed in batches by a separate thread,
+    /// and dropped if it falls behind. Zero or negative disables it.
+    int32_t access_log_file_descriptor;
+    /// @brief Optional signal, like `SIGUSR2`, dumping the flight recorder of every thread into the logs.
+    /// Signal handlers are process-global: `ucall_init` replaces the previous one, which `ucall_free` restores,
+    /// so only one server per process should use it. Not supported on Windows.
+    int32_t flight_dump_signal;
+
+    /// @brief Every how many calls of each thread to count CPU cycles, instructions, cache and branch misses
+    /// of the callback with `perf_event_open`, reported with the latencies in the logs. Zero disables it.
+    uint32_t perf_sampling_rate;
+
+    /// @brief At most how often every thread reads `TCP_INFO` of a connection, that has just been served,
+    /// reporting the RTT, congestion window, retransmits and send backlog in the logs. Zero disables it.
+    uint32_t tcp_info_period_micro_seconds;
+
+    /// @brief Optional file descriptor, like a connected UDP socket of a collector, receiving one NDJSON span
+    /// per request sampled by its W3C "traceparent", with the time spent in every stage. Spans are exported
+    /// in batches by a separate thread, and dropped if it falls behind. Zero or negative disables tracing.
+    int32_t trace_export_file_descriptor;
+
+    /// @brief How often to print the statistics into `logs_file_descriptor`. Defaults to 5 seconds.
+    uint32_t logs_period_milli_seconds;
+
+    /// @brief Size of the pre-allocated input and output buffers of every connection, and the most bytes received
+    /// at once, rounded up to whole memory pages. Larger messages spill into heap memory. Defaults to 4 KB.
+    uint32_t connection_buffer_bytes;
+    /// @brief Keeps the heap buffers of every connection between its requests, sized by a decaying maximum of its
+    /// recent request and reply sizes, instead of allocating them anew for every message that doesn't fit.
+    bool adaptive_connection_buffers;
 } ucall_config_t;
 
 /**
@@ -147,6 +195,91 @@ void ucall_take_call(ucall_server_t server, uint16_t thread_idx);
  */
 void ucall_take_calls(ucall_server_t server, uint16_t thread_idx);
 
+/**
+ * @brief Prints the last state transitions of connections on every thread, with their timestamps,
+ * completion results and connection IDs, one per line. Can be called from any thread.
+ *
+ * @param file_descriptor Where to print, like `STDERR_FILENO`.
+ */
+void ucall_dump_flight_recorder(ucall_server_t server, int32_t file_descriptor);
+
+/**
+ * @brief Reads the monotonic clock, that the server uses for its own timestamps, in nanoseconds.
+ * Scales the CPU cycle counter, costing a few dozen cycles, so it's cheap enough to measure latencies
+ * inside of callbacks. Calibrated by `ucall_init()`, or by the first call, which then blocks for ~10 ms.
+ * Only differences between its readings are meaningful.
+ */
+uint64_t ucall_now_ns(void);
+
+/// @brief Latencies of a method since the server has started, in nanoseconds, with ~3% precision.
+typedef struct ucall_latency_t {
+    uint64_t count;
+    /// @brief Exact sum of all the latencies, to derive the mean.
+    uint64_t sum_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+} ucall_latency_t;
+
+typedef struct ucall_method_stats_t {
+    /// @brief Name of the method, owned by the server and not NULL-terminated.
+    ucall_str_t name;
+    size_t name_length;
+    /// @brief Time spent in the user callback.
+    ucall_latency_t callback;
+    /// @brief Time from the arrival of the request, to the last byte of its reply being sent.
+    ucall_latency_t request;
+} ucall_method_stats_t;
+
+/// @brief Heap allocations of the buffers of connections, outgrowing their pre-allocated memory.
+typedef struct ucall_allocations_t {
+    /// @brief Every `malloc` and `realloc`, since the server has started.
+    uint64_t count;
+    /// @brief Requests that had to allocate at least once.
+    uint64_t requests;
+    /// @brief High-water mark of a single buffer, in bytes, or in bytes of JSON for parsers.
+    uint64_t peak_bytes;
+} ucall_allocations_t;
+
+typedef struct ucall_stats_t {
+    /// @brief Counters since the server has started.
+    uint64_t connections_accepted;
+    uint64_t connections_closed;
+    uint64_t bytes_received;
+    uint64_t bytes_sent;
+    uint64_t packets_received;
+    uint64_t packets_sent;
+
+    /// @brief Gauges at the time of the call.
+    uint64_t connections_active;
+    uint64_t connections_capacity;
+    uint64_t deferred_replies_pending;
+
+    /// @brief Requests and replies spilling out of the embedded pages, and growths of the JSON parsers.
+    ucall_allocations_t input_buffers;
+    ucall_allocations_t output_buffers;
+    ucall_allocations_t parsers;
+
+    /// @brief Optional input array, filled with up to `methods_capacity` methods by `ucall_get_stats()`.
+    ucall_method_stats_t* methods;
+    size_t methods_capacity;
+    /// @brief Output number of tracked methods, which may exceed `methods_capacity`.
+    size_t methods_count;
+} ucall_stats_t;
+
+/**
+ * @brief Reads the counters, gauges and latency histograms of the server, without resetting
+ * them and without affecting the logs. Can be called from any thread, without blocking the
+ * polling ones. Every value is read atomically, but concurrently served requests may be
+ * reflected in some of them and not yet in others.
+ *
+ * @param stats Output argument. Set its `methods` and `methods_capacity` to also receive the
+ * latencies of every method, or leave them zeroed to only get the server-wide values.
+ */
+void ucall_get_stats(ucall_server_t server, ucall_stats_t* stats);
+
 bool ucall_param_named_bool(  //
     ucall_call_t call,        //
     ucall_str_t param_name,   //
@@ -184,6 +317,24 @@ bool ucall_get_request_header(ucall_call_t call,         //
 bool ucall_get_request_body(ucall_call_t call, //
                             ucall_str_t* output, size_t* output_length);
 
+/// @brief W3C trace context of a call, with the ID of the span the server has opened for it.
+typedef struct ucall_trace_context_t {
+    uint8_t trace_id[16];
+    /// @brief Span of the caller, that the server span is a child of.
+    uint8_t parent_span_id[8];
+    /// @brief Span of the server, to pass as the parent to the downstream calls of the callback.
+    uint8_t span_id[8];
+    /// @brief Trace flags, where the lowest bit marks the sampled traces.
+    uint8_t flags;
+} ucall_trace_context_t;
+
+/**
+ * @brief Fetches the trace context of the current call, propagated by the client in a "traceparent"
+ * HTTP header or JSON-RPC member, to continue the trace in the downstream calls of the callback.
+ * @return False if tracing is disabled, or the call has no valid context.
+ */
+bool ucall_get_trace_context(ucall_call_t call, ucall_trace_context_t* output);
+
 /**
  * @param call Encapsulates the context and the arguments of the current request.
  * @param json_reply The response to send, which must be a valid JSON string.
@@ -198,6 +349,33 @@ void ucall_call_reply_content(ucall_call_t call, ucall_str_t json_reply, size_t
  */
 void ucall_call_reply_error(ucall_call_t call, int error_code, ucall_str_t error_message, size_t error_message_length);
 
+/**
+ * @brief Postpones the reply to the current call, so that the callback can return before the result
+ * is ready. The connection pauses until the reply is submitted from any thread with
+ * `ucall_deferred_reply_content()` or `ucall_deferred_reply_error()`, while other connections
+ * continue being served. All the parameters must be fetched before the callback returns.
+ *
+ * @param call Encapsulates the context and the arguments of the current request.
+ * @return NULL if the call can't be deferred, like the ones in JSON-RPC batches.
+ */
+ucall_deferred_t ucall_call_defer(ucall_call_t call);
+
+/**
+ * @param deferred The handle returned by `ucall_call_defer()`, invalidated by this call.
+ * @param json_reply The response to send, which must be a valid JSON string.
+ * @param json_reply_length An option length of `::json_reply`.
+ */
+void ucall_deferred_reply_content(ucall_server_t server, ucall_deferred_t deferred, ucall_str_t json_reply,
+                                  size_t json_reply_length);
+
+/**
+ * @param deferred The handle returned by `ucall_call_defer()`, invalidated by this call.
+ * @param error_message An optional string.
+ * @param error_message_length An option length of `::error_message`.
+ */
+void ucall_deferred_reply_error(ucall_server_t server, ucall_deferred_t deferred, int error_code,
+                                ucall_str_t error_message, size_t error_message_length);
+
 void ucall_call_reply_error_invalid_params(ucall_call_t);
 void ucall_call_reply_error_out_of_memory(ucall_call_t);
 void ucall_call_reply_error_unknown(ucall_call_t);
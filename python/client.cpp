@@ -0,0 +1,610 @@
+/**
+ * @file client.cpp
+ * @brief Native JSON-RPC client for Python, exposed as `ucall.client_native`.
+ *
+ * Serializes requests straight from Python objects, reusing `py_to_json.h` of the server bindings,
+ * and parses replies with SIMDJSON, decoding tensors into arrays. The networking is done by the C client
+ * library from `ucall/client.h` with the GIL released, so many Python threads, or an `asyncio` executor,
+ * can share one `Pool`.
+ */
+#include <cerrno> // `errno`
+
+#include <simdjson.h>
+
+#include "ucall/client.h"
+
+#include "containers.hpp"
+#include "py_to_json.h"
+
+namespace sj = simdjson;
+namespace sjd = sj::dom;
+using namespace unum::ucall;
+
+/**
+ * @brief Serialized request and the location of its reply in the exchange arenas.
+ * @param error Zero, once the reply has arrived, or the `errno` that interrupted the exchange.
+ */
+struct pending_call_t {
+    std::size_t request_offset{};
+    std::size_t request_length{};
+    std::size_t reply_offset{};
+    std::size_t reply_length{};
+    int error{};
+};
+
+/**
+ * @brief State of a single call to `Pool.call`, `Pool.call_many` or `Pool.batch`.
+ * Is filled with the GIL held, and exchanged with the server with the GIL released.
+ */
+struct exchange_t {
+    array_gt<char> requests;
+    array_gt<char> replies;
+    array_gt<pending_call_t> calls;
+};
+
+struct py_pool_t {
+    PyObject_HEAD
+    ucall_client_config_t config;
+    ucall_client_t client;
+};
+
+#pragma region Serialization
+
+/**
+ * @brief Appends a JSON-RPC request object to @p body.
+ * @return False with a Python exception set.
+ */
+static bool print_request(array_gt<char>& body, PyObject* method, PyObject* params, std::size_t id) {
+    if (!PyUnicode_Check(method)) {
+        PyErr_SetString(PyExc_TypeError, "Method name must be a string");
+        return false;
+    }
+    if (params == Py_None)
+        params = NULL;
+    if (params && !PyList_Check(params) && !PyTuple_Check(params) && !PyDict_Check(params)) {
+        PyErr_SetString(PyExc_TypeError, "Parameters must be a list, a tuple or a dictionary");
+        return false;
+    }
+
+    Py_ssize_t method_size = calculate_size_as_str(method);
+    Py_ssize_t params_size = params ? calculate_size_as_str(params) : 0;
+    if (method_size < 0 || params_size < 0) {
+        if (!PyErr_Occurred())
+            PyErr_SetString(PyExc_TypeError, "Parameters can't be serialized to JSON");
+        return false;
+    }
+
+    constexpr std::string_view prefix_k = R"({"jsonrpc":"2.0","method":)";
+    constexpr std::string_view params_k = R"(,"params":)";
+    constexpr std::string_view id_k = R"(,"id":)";
+    // One more byte for the terminating NULL, that `sprintf` appends to the last scalar.
+    std::size_t upper_bound = prefix_k.size() + method_size + params_k.size() + params_size + id_k.size() +
+                              max_integer_length_k + 2;
+    char* const begin = body.extend(upper_bound);
+    if (!begin) {
+        PyErr_NoMemory();
+        return false;
+    }
+
+    char* tail = begin;
+    std::size_t length = 0;
+    std::memcpy(tail, prefix_k.data(), prefix_k.size()), tail += prefix_k.size();
+    to_string(method, tail, &length), tail += length;
+    if (params) {
+        std::memcpy(tail, params_k.data(), params_k.size()), tail += params_k.size();
+        if (to_string(params, tail, &length) != 0) {
+            body.pop_back(upper_bound);
+            if (!PyErr_Occurred())
+                PyErr_SetString(PyExc_TypeError, "Parameters can't be serialized to JSON");
+            return false;
+        }
+        tail += length;
+    }
+    std::memcpy(tail, id_k.data(), id_k.size()), tail += id_k.size();
+    tail += std::snprintf(tail, max_integer_length_k, "%zu", id);
+    *tail++ = '}';
+    body.pop_back(upper_bound - (tail - begin));
+    return true;
+}
+
+/**
+ * @brief Serializes a request into the `requests` arena of @p exchange and registers a pending call.
+ * @return False with a Python exception set.
+ */
+static bool add_request(exchange_t& exchange, PyObject* method, PyObject* params, std::size_t id) {
+    std::size_t request_offset = exchange.requests.size();
+    pending_call_t* call = exchange.calls.extend(1);
+    if (!call) {
+        PyErr_NoMemory();
+        return false;
+    }
+    if (!print_request(exchange.requests, method, params, id)) {
+        exchange.calls.pop_back();
+        return false;
+    }
+    *call = pending_call_t{};
+    call->request_offset = request_offset;
+    call->request_length = exchange.requests.size() - request_offset;
+    return true;
+}
+
+/**
+ * @brief Unpacks a `(method, params)` tuple or a bare method name.
+ * @return Borrowed references, or false with a Python exception set.
+ */
+static bool unpack_call(PyObject* call, PyObject** method, PyObject** params) {
+    if (PyUnicode_Check(call)) {
+        *method = call, *params = NULL;
+        return true;
+    }
+    if (PyTuple_Check(call) && (PyTuple_GET_SIZE(call) == 1 || PyTuple_GET_SIZE(call) == 2)) {
+        *method = PyTuple_GET_ITEM(call, 0);
+        *params = PyTuple_GET_SIZE(call) == 2 ? PyTuple_GET_ITEM(call, 1) : NULL;
+        return true;
+    }
+    PyErr_SetString(PyExc_TypeError, "Each call must be a method name or a `(method, params)` tuple");
+    return false;
+}
+
+#pragma endregion Serialization
+
+#pragma region Networking
+
+/**
+ * @brief Copies a reply out of the connection buffers into the `replies` arena.
+ */
+static void on_reply(void* user_data, size_t request_idx, int error, ucall_str_t reply, size_t reply_length) {
+    exchange_t& exchange = *reinterpret_cast<exchange_t*>(user_data);
+    pending_call_t& call = exchange.calls[request_idx];
+    call.error = error;
+    call.reply_offset = exchange.replies.size();
+    call.reply_length = reply_length;
+    if (!error && !exchange.replies.append_n(reply, reply_length))
+        call.error = ENOMEM;
+}
+
+/**
+ * @brief Releases the GIL and exchanges all the requests of @p exchange,
+ * either one by one, pipelined across the pool, or as a single JSON-RPC batch.
+ */
+static bool pool_exchange(py_pool_t* pool, exchange_t& exchange, bool as_batch) {
+    std::size_t count = exchange.calls.size();
+    buffer_gt<ucall_str_t> requests;
+    buffer_gt<std::size_t> requests_lengths;
+    if (!requests.resize(count) || !requests_lengths.resize(count)) {
+        PyErr_NoMemory();
+        return false;
+    }
+    for (std::size_t i = 0; i != count; ++i) {
+        requests[i] = exchange.requests.data() + exchange.calls[i].request_offset;
+        requests_lengths[i] = exchange.calls[i].request_length;
+    }
+
+    Py_BEGIN_ALLOW_THREADS;
+    if (as_batch)
+        ucall_client_batch(pool->client, requests.data(), requests_lengths.data(), count, 0, &on_reply, &exchange);
+    else
+        ucall_client_call_many(pool->client, requests.data(), requests_lengths.data(), count, 0, &on_reply, &exchange);
+    Py_END_ALLOW_THREADS;
+    return true;
+}
+
+#pragma endregion Networking
+
+#pragma region Parsing
+
+/// @brief `numpy.asarray`, once imported, to wrap the decoded tensors without copies.
+static PyObject* numpy_asarray = NULL;
+static bool numpy_imported = false;
+
+/**
+ * @brief Decodes a tensor, packed by `ucall.tensor.pack_tensor`, into a read-only NumPy array, that owns
+ * the decoded bytes, just like the ones passed to the server callbacks. Without NumPy, it's a `memoryview`.
+ * @return New reference, or NULL with a Python exception set.
+ */
+static PyObject* tensor_to_py(std::string_view base64) {
+    if (!numpy_imported) {
+        numpy_imported = true;
+        PyObject* numpy = PyImport_ImportModule("numpy");
+        if (numpy)
+            numpy_asarray = PyObject_GetAttrString(numpy, "asarray"), Py_DECREF(numpy);
+        if (!numpy_asarray)
+            PyErr_Clear();
+    }
+
+    tensor_buffer_t* buffer = tensor_buffer_decode(base64.data(), base64.size());
+    if (!buffer || tensor_buffer_reshape(buffer) != 0) {
+        Py_XDECREF(buffer);
+        return NULL;
+    }
+    PyObject* array = numpy_asarray ? PyObject_CallFunctionObjArgs(numpy_asarray, (PyObject*)buffer, NULL)
+                                    : PyMemoryView_FromObject((PyObject*)buffer);
+    Py_DECREF(buffer);
+    return array;
+}
+
+/**
+ * @brief Converts a parsed JSON element into native Python objects.
+ * @return New reference, or NULL with a Python exception set.
+ */
+static PyObject* element_to_py(sjd::element const& element) {
+    switch (element.type()) {
+    case sjd::element_type::ARRAY: {
+        sjd::array array = element.get_array().value_unsafe();
+        PyObject* list = PyList_New(array.size());
+        if (!list)
+            return NULL;
+        Py_ssize_t i = 0;
+        for (sjd::element item : array) {
+            PyObject* item_py = element_to_py(item);
+            if (!item_py) {
+                Py_DECREF(list);
+                return NULL;
+            }
+            PyList_SET_ITEM(list, i++, item_py);
+        }
+        return list;
+    }
+    case sjd::element_type::OBJECT: {
+        PyObject* dict = PyDict_New();
+        if (!dict)
+            return NULL;
+        sjd::object object = element.get_object().value_unsafe();
+        for (sjd::key_value_pair field : object) {
+            PyObject* key = PyUnicode_FromStringAndSize(field.key.data(), field.key.size());
+            PyObject* value = key ? element_to_py(field.value) : NULL;
+            int failed = !value || PyDict_SetItem(dict, key, value) != 0;
+            Py_XDECREF(key);
+            Py_XDECREF(value);
+            if (failed) {
+                Py_DECREF(dict);
+                return NULL;
+            }
+        }
+        return dict;
+    }
+    case sjd::element_type::STRING: {
+        std::string_view string = element.get_string().value_unsafe();
+        if (tensor_is_encoded(string.data(), string.size()))
+            return tensor_to_py(string);
+        return PyUnicode_FromStringAndSize(string.data(), string.size());
+    }
+    case sjd::element_type::INT64: return PyLong_FromLongLong(element.get_int64().value_unsafe());
+    case sjd::element_type::UINT64: return PyLong_FromUnsignedLongLong(element.get_uint64().value_unsafe());
+    case sjd::element_type::DOUBLE: return PyFloat_FromDouble(element.get_double().value_unsafe());
+    case sjd::element_type::BOOL: return PyBool_FromLong(element.get_bool().value_unsafe());
+    case sjd::element_type::NULL_VALUE: Py_RETURN_NONE;
+    }
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief Creates, but doesn't raise, an exception for a failed call.
+ * Transport failures map to `OSError` subclasses, like `TimeoutError` or `ConnectionResetError`,
+ * and JSON-RPC errors to `RuntimeError`, just like in the pure-Python `ucall.client`.
+ */
+static PyObject* make_transport_error(int error) {
+    return PyObject_CallFunction(PyExc_OSError, "is", error, std::strerror(error));
+}
+
+static PyObject* make_reply_error(sjd::element const& reply) {
+    sjd::element error;
+    if (reply.at_key("error").get(error) != sj::SUCCESS)
+        return PyObject_CallFunction(PyExc_ValueError, "s", "Reply has neither `result` nor `error`");
+    PyObject* error_py = element_to_py(error);
+    if (!error_py)
+        return NULL;
+    PyObject* exception = PyObject_CallFunctionObjArgs(PyExc_RuntimeError, error_py, NULL);
+    Py_DECREF(error_py);
+    return exception;
+}
+
+/**
+ * @brief Converts a single JSON-RPC reply object into its `result`, or an exception instance.
+ * @param[out] is_exception Set, if the returned object is an exception instance.
+ * @return New reference, or NULL with a Python exception set.
+ */
+static PyObject* reply_to_py(sjd::element const& reply, bool* is_exception) {
+    sjd::element result;
+    if (reply.at_key("result").get(result) == sj::SUCCESS) {
+        *is_exception = false;
+        return element_to_py(result);
+    }
+    *is_exception = true;
+    return make_reply_error(reply);
+}
+
+/**
+ * @brief Raises @p exception, or returns it, if @p return_exceptions is set.
+ * Steals the reference.
+ */
+static PyObject* raise_or_return(PyObject* exception, bool return_exceptions) {
+    if (!exception || return_exceptions)
+        return exception;
+    PyErr_SetObject((PyObject*)Py_TYPE(exception), exception);
+    Py_DECREF(exception);
+    return NULL;
+}
+
+/**
+ * @brief Converting the parsed replies may run arbitrary Python code, like the garbage collector,
+ * that can hand the GIL to another thread using the same pool. So every thread parses into its own DOM.
+ */
+static sjd::parser& thread_parser() noexcept {
+    thread_local sjd::parser parser;
+    return parser;
+}
+
+/**
+ * @brief Parses the reply of the @p call, that may be a single object or a batch.
+ * @return Borrowed parsed element, valid until the next call on this thread, or false with a Python exception set.
+ */
+static bool parse_reply(exchange_t const& exchange, pending_call_t const& call, sjd::element& reply,
+                        bool return_exceptions, PyObject** exception) {
+    *exception = NULL;
+    if (call.error) {
+        *exception = raise_or_return(make_transport_error(call.error), return_exceptions);
+        return false;
+    }
+    if (thread_parser().parse(exchange.replies.data() + call.reply_offset, call.reply_length).get(reply) !=
+        sj::SUCCESS) {
+        *exception = raise_or_return(PyObject_CallFunction(PyExc_ValueError, "s", "Received malformed JSON"),
+                                     return_exceptions);
+        return false;
+    }
+    return true;
+}
+
+#pragma endregion Parsing
+
+#pragma region Python Interface
+
+static PyObject* pool_call(py_pool_t* self, PyObject* args, PyObject* keywords) {
+    static char const* keywords_list[] = {"method", "params", NULL};
+    PyObject* method = NULL;
+    PyObject* params = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, keywords, "O|O", (char**)keywords_list, &method, &params))
+        return NULL;
+
+    exchange_t exchange;
+    if (!add_request(exchange, method, params, 0) || !pool_exchange(self, exchange, false))
+        return NULL;
+
+    sjd::element reply;
+    PyObject* exception;
+    if (!parse_reply(exchange, exchange.calls[0], reply, false, &exception))
+        return NULL;
+    bool is_exception = false;
+    PyObject* result = reply_to_py(reply, &is_exception);
+    return is_exception ? raise_or_return(result, false) : result;
+}
+
+static PyObject* pool_call_many(py_pool_t* self, PyObject* args, PyObject* keywords) {
+    static char const* keywords_list[] = {"calls", "return_exceptions", NULL};
+    PyObject* calls = NULL;
+    int return_exceptions = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, keywords, "O|p", (char**)keywords_list, &calls, &return_exceptions))
+        return NULL;
+
+    PyObject* calls_fast = PySequence_Fast(calls, "Expecting a sequence of calls");
+    if (!calls_fast)
+        return NULL;
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(calls_fast);
+    exchange_t exchange;
+    for (Py_ssize_t i = 0; i != count; ++i) {
+        PyObject *method, *params;
+        if (!unpack_call(PySequence_Fast_GET_ITEM(calls_fast, i), &method, &params) ||
+            !add_request(exchange, method, params, i)) {
+            Py_DECREF(calls_fast);
+            return NULL;
+        }
+    }
+    Py_DECREF(calls_fast);
+    if (!pool_exchange(self, exchange, false))
+        return NULL;
+
+    PyObject* results = PyList_New(count);
+    if (!results)
+        return NULL;
+    for (Py_ssize_t i = 0; i != count; ++i) {
+        sjd::element reply;
+        PyObject* result;
+        if (parse_reply(exchange, exchange.calls[i], reply, return_exceptions, &result)) {
+            bool is_exception = false;
+            result = reply_to_py(reply, &is_exception);
+            result = is_exception ? raise_or_return(result, return_exceptions) : result;
+        }
+        if (!result) {
+            Py_DECREF(results);
+            return NULL;
+        }
+        PyList_SET_ITEM(results, i, result);
+    }
+    return results;
+}
+
+static PyObject* pool_batch(py_pool_t* self, PyObject* args, PyObject* keywords) {
+    static char const* keywords_list[] = {"calls", "return_exceptions", NULL};
+    PyObject* calls = NULL;
+    int return_exceptions = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, keywords, "O|p", (char**)keywords_list, &calls, &return_exceptions))
+        return NULL;
+
+    PyObject* calls_fast = PySequence_Fast(calls, "Expecting a sequence of calls");
+    if (!calls_fast)
+        return NULL;
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(calls_fast);
+    if (!count) {
+        Py_DECREF(calls_fast);
+        return PyList_New(0);
+    }
+
+    exchange_t exchange;
+    bool printed = true;
+    for (Py_ssize_t i = 0; i != count && printed; ++i) {
+        PyObject *method, *params;
+        printed = unpack_call(PySequence_Fast_GET_ITEM(calls_fast, i), &method, &params) &&
+                  add_request(exchange, method, params, i);
+    }
+    Py_DECREF(calls_fast);
+    if (!printed || !pool_exchange(self, exchange, true))
+        return NULL;
+
+    sjd::element reply;
+    PyObject* exception;
+    if (!parse_reply(exchange, exchange.calls[0], reply, false, &exception))
+        return NULL;
+
+    // Replies to a batch may come in any order, so we match them by the "id".
+    sjd::array replies;
+    if (reply.get_array().get(replies) != sj::SUCCESS) {
+        // A single error object is returned, if the batch as a whole was rejected.
+        bool is_exception = false;
+        PyObject* result = reply_to_py(reply, &is_exception);
+        return is_exception ? raise_or_return(result, false) : result;
+    }
+    PyObject* results = PyList_New(count);
+    if (!results)
+        return NULL;
+    for (sjd::element item : replies) {
+        std::uint64_t id;
+        if (item.at_key("id").get(id) != sj::SUCCESS || id >= (std::uint64_t)count || PyList_GET_ITEM(results, id))
+            continue;
+        bool is_exception = false;
+        PyObject* result = reply_to_py(item, &is_exception);
+        result = is_exception ? raise_or_return(result, return_exceptions) : result;
+        if (!result) {
+            Py_DECREF(results);
+            return NULL;
+        }
+        PyList_SET_ITEM(results, id, result);
+    }
+    for (Py_ssize_t i = 0; i != count; ++i) {
+        if (PyList_GET_ITEM(results, i))
+            continue;
+        PyObject* result = raise_or_return(
+            PyObject_CallFunction(PyExc_ValueError, "s", "Batch reply is missing a response"), return_exceptions);
+        if (!result) {
+            Py_DECREF(results);
+            return NULL;
+        }
+        PyList_SET_ITEM(results, i, result);
+    }
+    return results;
+}
+
+static PyObject* pool_new(PyTypeObject* type, PyObject* args, PyObject* keywords) {
+    py_pool_t* self = (py_pool_t*)type->tp_alloc(type, 0);
+    return (PyObject*)self;
+}
+
+static int pool_init(py_pool_t* self, PyObject* args, PyObject* keywords) {
+    static char const* keywords_list[] = {
+        "hostname", "port", "use_http", "connections", "pipeline_depth",
+        "timeout", "ssl", "ssl_allow_self_signed", "ssl_certificate_authorities", NULL,
+    };
+    char const* hostname = "127.0.0.1";
+    int port = 8545;
+    int use_http = 1;
+    Py_ssize_t connections = 4;
+    Py_ssize_t pipeline_depth = 16;
+    double timeout = 10;
+    int ssl = 0;
+    int ssl_allow_self_signed = 0;
+    char const* ssl_certificate_authorities = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, keywords, "|sipnndppz", (char**)keywords_list, //
+                                     &hostname, &port, &use_http, &connections, &pipeline_depth, &timeout, &ssl,
+                                     &ssl_allow_self_signed, &ssl_certificate_authorities))
+        return -1;
+    if (connections < 1 || pipeline_depth < 1 || timeout <= 0 || timeout * 1e6 > UINT32_MAX) {
+        PyErr_SetString(PyExc_ValueError, "Expecting positive connections, pipeline depth and timeout");
+        return -1;
+    }
+
+    ucall_client_config_t& config = self->config;
+    config.hostname = hostname;
+    config.port = static_cast<uint16_t>(port);
+    config.protocol = use_http ? jsonrpc_http_k : jsonrpc_tcp_k;
+    config.max_connections = static_cast<uint32_t>(connections);
+    config.pipeline_depth = static_cast<uint32_t>(pipeline_depth);
+    config.timeout_micro_seconds = static_cast<uint32_t>(timeout * 1e6);
+    config.ssl = ssl;
+    config.ssl_allow_self_signed = ssl_allow_self_signed;
+    config.ssl_certificate_authorities_path = ssl_certificate_authorities;
+
+    // Initialization resolves the hostname, so release the GIL.
+    Py_BEGIN_ALLOW_THREADS;
+    ucall_client_init(&config, &self->client);
+    Py_END_ALLOW_THREADS;
+    if (!self->client) {
+        PyErr_Format(PyExc_OSError, "Failed to initialize a client for %s:%i", hostname, port);
+        return -1;
+    }
+    // String fields point into the arguments, that won't outlive this call.
+    config.hostname = NULL;
+    config.ssl_certificate_authorities_path = NULL;
+    return 0;
+}
+
+static void pool_dealloc(py_pool_t* self) {
+    ucall_client_free(self->client);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject* pool_port(py_pool_t* self, void*) { return PyLong_FromLong(self->config.port); }
+static PyObject* pool_connections(py_pool_t* self, void*) { return PyLong_FromSize_t(self->config.max_connections); }
+static PyObject* pool_pipeline_depth(py_pool_t* self, void*) { return PyLong_FromSize_t(self->config.pipeline_depth); }
+
+static PyMethodDef pool_methods[] = {
+    {"call", (PyCFunction)&pool_call, METH_VARARGS | METH_KEYWORDS,
+     PyDoc_STR("Calls a remote `method` with optional `params`, returning its result")},
+    {"call_many", (PyCFunction)&pool_call_many, METH_VARARGS | METH_KEYWORDS,
+     PyDoc_STR("Pipelines many `(method, params)` calls across pooled connections, returning the results in order")},
+    {"batch", (PyCFunction)&pool_batch, METH_VARARGS | METH_KEYWORDS,
+     PyDoc_STR("Sends many `(method, params)` calls in a single JSON-RPC batch, returning the results in order")},
+    {NULL},
+};
+
+static PyGetSetDef pool_computed_properties[] = {
+    {"port", (getter)&pool_port, NULL, PyDoc_STR("Port of the remote server")},
+    {"connections", (getter)&pool_connections, NULL, PyDoc_STR("Max number of pooled connections")},
+    {"pipeline_depth", (getter)&pool_pipeline_depth, NULL, PyDoc_STR("Max requests in flight per connection")},
+    {NULL},
+};
+
+static PyTypeObject pool_type = {PyVarObject_HEAD_INIT(NULL, 0)};
+
+static PyModuleDef client_module = {
+    PyModuleDef_HEAD_INIT,
+    "ucall.client_native",
+    "Native connection-pooling client for Uninterrupted JSON Remote Procedure Calls.",
+    -1,
+};
+
+PyMODINIT_FUNC PyInit_client_native(void) {
+    pool_type.tp_name = "ucall.client_native.Pool";
+    pool_type.tp_basicsize = sizeof(py_pool_t);
+    pool_type.tp_dealloc = (destructor)pool_dealloc;
+    pool_type.tp_flags = Py_TPFLAGS_DEFAULT;
+    pool_type.tp_doc = PyDoc_STR("Thread-safe pool of pipelined JSON-RPC connections to a single server");
+    pool_type.tp_methods = pool_methods;
+    pool_type.tp_getset = pool_computed_properties;
+    pool_type.tp_init = (initproc)pool_init;
+    pool_type.tp_new = pool_new;
+    if (PyType_Ready(&pool_type) < 0 || PyType_Ready(&tensor_buffer_type) < 0)
+        return NULL;
+
+    PyObject* m = PyModule_Create(&client_module);
+    if (!m)
+        return NULL;
+
+    Py_INCREF(&pool_type);
+    if (PyModule_AddObject(m, "Pool", (PyObject*)&pool_type) < 0) {
+        Py_DECREF(&pool_type);
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
+
+#pragma endregion Python Interface
@@ -55,19 +55,40 @@ typedef struct {
     py_param_t* u_params;
     size_t params_cnt;
     PyObject* callable;
+    struct py_server_t* server;
+    char* name; // Owned copy, as the server references it, while the Python string may be collected
 } py_wrapper_t;
 
-typedef struct {
+typedef struct py_server_t {
     PyObject_HEAD
     ucall_config_t config;
     ucall_server_t server;
     size_t count_threads;
-    py_wrapper_t* wrappers;
+    py_wrapper_t** wrappers;
     size_t wrapper_capacity;
     size_t count_added;
     bool quiet;
+    PyObject* loop;                     // Lazily started `asyncio` loop for coroutine callbacks, or NULL
+    PyObject* loop_thread;              // `threading.Thread` running the `loop`
+    PyObject* run_coroutine_threadsafe; // `asyncio.run_coroutine_threadsafe`
 } py_server_t;
 
+/**
+ * @brief Target of a reply, that is either submitted from inside the callback,
+ * or later, once the coroutine it has returned is complete.
+ */
+typedef struct {
+    ucall_call_t call;
+    ucall_server_t server;
+    ucall_deferred_t deferred;
+} py_reply_t;
+
+typedef struct {
+    ucall_server_t server;
+    ucall_deferred_t deferred;
+    PyObject* args;
+} py_deferred_t;
+
 typedef struct {
     py_server_t* server;
     PyObject* args;
@@ -201,7 +222,204 @@ static int prepare_wrapper(PyObject* callable, py_wrapper_t* wrap) {
     return 0;
 }
 
-static void wrapper(ucall_call_t call, ucall_callback_tag_t callback_tag) {
+/**
+ * @brief Decodes a Base64 binary argument. Tensors and `memoryview`-annotated arguments become read-only
+ * views of a `tensor_buffer_t`, that owns the decoded bytes, everything else is decoded in place into `bytes`.
+ */
+static PyObject* binary_to_py(PyTypeObject* type, char* base64, size_t base64_length) {
+    bool is_type = type && PyType_Check(type);
+    bool wants_bytes = is_type && (PyType_IsSubtype(type, &PyBytes_Type) || PyType_IsSubtype(type, &PyByteArray_Type));
+    bool is_tensor = !wants_bytes && tensor_is_encoded(base64, base64_length);
+    if (!is_tensor && !(is_type && PyType_IsSubtype(type, &PyMemoryView_Type))) {
+        size_t length = tb64dec((unsigned char const*)base64, base64_length, (unsigned char*)base64);
+        return PyBytes_FromStringAndSize(base64, (Py_ssize_t)length);
+    }
+
+    tensor_buffer_t* buffer = tensor_buffer_decode(base64, base64_length);
+    if (!buffer || (is_tensor && tensor_buffer_reshape(buffer) != 0)) {
+        Py_XDECREF(buffer);
+        return NULL;
+    }
+    PyObject* view = PyMemoryView_FromObject((PyObject*)buffer);
+    Py_DECREF(buffer);
+    return view;
+}
+
+static void reply_content(py_reply_t const* reply, ucall_str_t body, size_t body_len) {
+    if (reply->deferred)
+        ucall_deferred_reply_content(reply->server, reply->deferred, body, body_len);
+    else
+        ucall_call_reply_content(reply->call, body, body_len);
+}
+
+static void reply_error(py_reply_t const* reply, int code, ucall_str_t note, size_t note_len) {
+    if (reply->deferred)
+        ucall_deferred_reply_error(reply->server, reply->deferred, code, note, note_len);
+    else
+        ucall_call_reply_error(reply->call, code, note, note_len);
+}
+
+/**
+ * @brief Serializes the value returned by a callback, or the exception it has raised, if @p response is NULL.
+ * Steals the references to @p response and @p args.
+ */
+static void reply_with_result(py_reply_t const* reply, PyObject* response, PyObject* args) {
+    if (response == NULL) {
+        PyObject *ptype, *pvalue, *ptraceback;
+        PyErr_Fetch(&ptype, &pvalue, &ptraceback);
+        PyObject* pvalue_str = ptype != NULL ? PyObject_Str(pvalue) : NULL;
+        Py_XDECREF(ptype);
+        Py_XDECREF(pvalue);
+        Py_XDECREF(ptraceback);
+        Py_DECREF(args);
+        Py_ssize_t size = 0;
+        ucall_str_t error_str = pvalue_str ? PyUnicode_AsUTF8AndSize(pvalue_str, &size) : NULL;
+        if (error_str)
+            reply_error(reply, 500, error_str, (size_t)size);
+        else
+            reply_error(reply, -32603, "Unknown error.", 14);
+        Py_XDECREF(pvalue_str);
+        PyErr_Clear();
+        return;
+    }
+
+    Py_ssize_t sz = calculate_size_as_str(response);
+    // One more byte for the terminating NULL, that `sprintf` appends to the last scalar.
+    char* parsed_response = sz >= 0 ? (char*)(malloc((sz + 1) * sizeof(char))) : NULL;
+    size_t len = 0;
+    if (parsed_response)
+        to_string(response, &parsed_response[0], &len);
+    Py_DECREF(response);
+    Py_DECREF(args);
+    PyErr_Clear();
+
+    if (sz < 0)
+        reply_error(reply, -32603, "Unsupported result type.", 24);
+    else if (!parsed_response)
+        reply_error(reply, -32000, "Out of memory.", 14);
+    else
+        reply_content(reply, &parsed_response[0], len);
+    free(parsed_response);
+}
+
+/**
+ * @brief Starts an `asyncio` event loop in a daemon thread, on the first use.
+ * @return Borrowed reference, or NULL with a Python exception set.
+ */
+static PyObject* server_event_loop(py_server_t* self) {
+    if (self->loop)
+        return self->loop;
+
+    PyObject* asyncio = PyImport_ImportModule("asyncio");
+    PyObject* threading = asyncio ? PyImport_ImportModule("threading") : NULL;
+    PyObject* loop = threading ? PyObject_CallMethod(asyncio, "new_event_loop", NULL) : NULL;
+    PyObject* run_forever = loop ? PyObject_GetAttrString(loop, "run_forever") : NULL;
+    PyObject* thread_kwargs = run_forever ? Py_BuildValue("{s:O,s:O,s:s}", "target", run_forever, "daemon", Py_True,
+                                                          "name", "ucall-asyncio")
+                                          : NULL;
+    PyObject* thread_type = thread_kwargs ? PyObject_GetAttrString(threading, "Thread") : NULL;
+    PyObject* no_args = thread_type ? PyTuple_New(0) : NULL;
+    PyObject* thread = no_args ? PyObject_Call(thread_type, no_args, thread_kwargs) : NULL;
+    PyObject* started = thread ? PyObject_CallMethod(thread, "start", NULL) : NULL;
+    PyObject* run_coroutine_threadsafe = started ? PyObject_GetAttrString(asyncio, "run_coroutine_threadsafe") : NULL;
+
+    Py_XDECREF(started);
+    Py_XDECREF(no_args);
+    Py_XDECREF(thread_type);
+    Py_XDECREF(thread_kwargs);
+    Py_XDECREF(run_forever);
+    Py_XDECREF(threading);
+    Py_XDECREF(asyncio);
+    if (!run_coroutine_threadsafe) {
+        Py_XDECREF(thread);
+        Py_XDECREF(loop);
+        return NULL;
+    }
+
+    self->loop = loop;
+    self->loop_thread = thread;
+    self->run_coroutine_threadsafe = run_coroutine_threadsafe;
+    return loop;
+}
+
+static void deferred_free(PyObject* capsule) {
+    py_deferred_t* state = (py_deferred_t*)PyCapsule_GetPointer(capsule, NULL);
+    Py_XDECREF(state->args);
+    free(state);
+}
+
+/**
+ * @brief Called in the event loop thread with a `concurrent.futures.Future`, once the coroutine is complete.
+ */
+static PyObject* deferred_done(PyObject* capsule, PyObject* future) {
+    py_deferred_t* state = (py_deferred_t*)PyCapsule_GetPointer(capsule, NULL);
+    PyObject* result = PyObject_CallMethod(future, "result", NULL);
+    // The arguments are released with the reply, like those of synchronous calls.
+    PyObject* args = state->args;
+    state->args = NULL;
+    py_reply_t reply = {NULL, state->server, state->deferred};
+    reply_with_result(&reply, result, args);
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief Schedules the @p coroutine on the companion event loop, letting the polling thread
+ * serve other connections, until it completes. Steals references to @p coroutine and @p args.
+ */
+static void defer_coroutine(py_server_t* server, ucall_call_t call, PyObject* coroutine, PyObject* args) {
+    static PyMethodDef done_method = {"deferred_done", (PyCFunction)deferred_done, METH_O,
+                                      "Submits the result of a coroutine as a reply"};
+    py_reply_t reply = {call, NULL, NULL};
+    PyObject* loop = server_event_loop(server);
+    PyObject* future = loop ? PyObject_CallFunctionObjArgs(server->run_coroutine_threadsafe, coroutine, loop, NULL)
+                            : NULL;
+    if (!future) {
+        PyErr_Clear();
+        PyObject* closed = PyObject_CallMethod(coroutine, "close", NULL);
+        Py_XDECREF(closed);
+        PyErr_Clear();
+        Py_DECREF(coroutine);
+        Py_DECREF(args);
+        return ucall_call_reply_error_unknown(call);
+    }
+    Py_DECREF(coroutine);
+
+    // Batched calls are answered together, so we block until the coroutine is complete.
+    // Waiting on the future releases the GIL, letting the event loop progress.
+    ucall_deferred_t deferred = ucall_call_defer(call);
+    if (!deferred) {
+        PyObject* result = PyObject_CallMethod(future, "result", NULL);
+        Py_DECREF(future);
+        return reply_with_result(&reply, result, args);
+    }
+
+    reply.server = server->server;
+    reply.deferred = deferred;
+    py_deferred_t* state = (py_deferred_t*)malloc(sizeof(py_deferred_t));
+    PyObject* capsule = state ? PyCapsule_New(state, NULL, deferred_free) : NULL;
+    PyObject* done = capsule ? PyCFunction_New(&done_method, capsule) : NULL;
+    if (state) {
+        state->server = server->server;
+        state->deferred = deferred;
+        state->args = args;
+    }
+    PyObject* added = done ? PyObject_CallMethod(future, "add_done_callback", "O", done) : NULL;
+    Py_XDECREF(added);
+    Py_XDECREF(done);
+    Py_XDECREF(capsule);
+    Py_DECREF(future);
+    if (!added) {
+        // The reply must be submitted anyway, or the connection will hang.
+        PyErr_Clear();
+        if (!capsule) {
+            Py_DECREF(args);
+            free(state);
+        }
+        reply_error(&reply, -32000, "Out of memory.", 14);
+    }
+}
+
+static void wrapper_with_gil(ucall_call_t call, ucall_callback_tag_t callback_tag) {
     py_wrapper_t* wrap = (py_wrapper_t*)(callback_tag);
     PyObject* args = PyTuple_New(wrap->params_cnt);
 
@@ -223,7 +441,7 @@ static void wrapper(ucall_call_t call, ucall_callback_tag_t callback_tag) {
                 !ucall_param_positional_bool(call, i, &res))
                 return ucall_call_reply_error_invalid_params(call);
 
-            PyTuple_SetItem(args, i, res ? Py_True : Py_False);
+            PyTuple_SetItem(args, i, PyBool_FromLong(res));
         } else if (PyType_IsSubtype(type, &PyLong_Type)) {
             int64_t res;
             if (may_have_name && name_length > 0)
@@ -266,36 +484,29 @@ static void wrapper(ucall_call_t call, ucall_callback_tag_t callback_tag) {
                 !ucall_param_positional_str(call, i, &res, &len))
                 return ucall_call_reply_error_invalid_params(call);
 
-            len = tb64dec((unsigned char const*)res, len, (unsigned char*)res);
-            PyTuple_SetItem(args, i, PyBytes_FromStringAndSize(res, len));
+            PyObject* binary = binary_to_py(type, (char*)res, len);
+            if (!binary) {
+                PyErr_Clear();
+                Py_DECREF(args);
+                return ucall_call_reply_error_invalid_params(call);
+            }
+            PyTuple_SetItem(args, i, binary);
         }
     }
 
     PyObject* response = PyObject_CallObject(wrap->callable, args);
-    if (response == NULL) {
-        PyObject *ptype, *pvalue, *ptraceback;
-        PyErr_Fetch(&ptype, &pvalue, &ptraceback);
-        if (ptype != NULL) {
-            PyObject* pvalue_str = PyObject_Str(pvalue);
-            size_t size = 0;
-            ucall_str_t error_str = PyUnicode_AsUTF8AndSize(pvalue_str, &size);
-            ucall_call_reply_error(call, 500, error_str, size);
-            Py_DECREF(pvalue_str);
-        } else
-            ucall_call_reply_error_unknown(call);
-        Py_XDECREF(ptype);
-        Py_XDECREF(pvalue);
-        Py_XDECREF(ptraceback);
-        return;
-    }
+    if (response && PyCoro_CheckExact(response))
+        return defer_coroutine(wrap->server, call, response, args);
 
-    size_t sz = calculate_size_as_str(response);
-    char* parsed_response = (char*)(malloc(sz * sizeof(char)));
-    if (!parsed_response)
-        return ucall_call_reply_error_out_of_memory(call);
-    size_t len = 0;
-    int res = to_string(response, &parsed_response[0], &len);
-    ucall_call_reply_content(call, &parsed_response[0], len);
+    py_reply_t reply = {call, NULL, NULL};
+    reply_with_result(&reply, response, args);
+}
+
+static void wrapper(ucall_call_t call, ucall_callback_tag_t callback_tag) {
+    // The polling loop releases the GIL, while coroutines are being awaited in the companion thread.
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    wrapper_with_gil(call, callback_tag);
+    PyGILState_Release(gstate);
 }
 
 static PyObject* __add_procedure(py_decorator_self_t* decorated, PyObject* args) {
@@ -322,17 +533,32 @@ static PyObject* __add_procedure(py_decorator_self_t* decorated, PyObject* args)
     if (prepare_wrapper(wrap.callable, &wrap) != 0)
         return NULL;
 
+    // The engine keeps pointers to the wrappers, so those are allocated separately and never move.
     if (server->count_added >= server->wrapper_capacity) {
+        py_wrapper_t** wrappers =
+            (py_wrapper_t**)realloc(server->wrappers, server->wrapper_capacity * 2 * sizeof(py_wrapper_t*));
+        if (!wrappers)
+            return PyErr_NoMemory();
+        server->wrappers = wrappers;
         server->wrapper_capacity *= 2;
-        server->wrappers = (py_wrapper_t*)realloc(server->wrappers, server->wrapper_capacity);
     }
+    py_wrapper_t* added = (py_wrapper_t*)malloc(sizeof(py_wrapper_t));
+    if (!added)
+        return PyErr_NoMemory();
 
-    server->wrappers[server->count_added] = wrap;
+    wrap.server = server;
+    *added = wrap;
+    server->wrappers[server->count_added] = added;
 
     if (path == NULL)
         path = PyUnicode_AsUTF8(PyObject_GetAttrString(wrap.callable, "__name__"));
+    added->name = strdup(path);
+    if (!added->name) {
+        free(added);
+        return PyErr_NoMemory();
+    }
 
-    ucall_add_procedure(server->server, path, wrapper, decorated->request_type, &server->wrappers[server->count_added]);
+    ucall_add_procedure(server->server, added->name, wrapper, decorated->request_type, added);
 
     ++server->count_added;
     Py_INCREF(wrap.callable);
@@ -382,7 +608,11 @@ static bool pycheck_take_call(py_server_t* self, uint16_t thread_idx) {
         PyGILState_Release(gstate);
         return false;
     }
+    // Other threads, like the one awaiting coroutines or the one polling `stats`, can only run while
+    // we are blocked in the network engine, especially if no Python callbacks are being called.
+    Py_BEGIN_ALLOW_THREADS;
     ucall_take_call(self->server, thread_idx);
+    Py_END_ALLOW_THREADS;
     return true;
 }
 
@@ -420,7 +650,10 @@ static PyObject* server_run(py_server_t* self, PyObject* args) {
         }
     }
 
-    return NULL;
+    // Interrupted loops report the `KeyboardInterrupt`, others return `None`, so the server can be resumed.
+    if (PyErr_Occurred())
+        return NULL;
+    Py_RETURN_NONE;
 }
 
 static Py_ssize_t server_callbacks_count(py_server_t* self, PyObject* _) { return self->count_added; }
@@ -431,6 +664,62 @@ static PyObject* server_queue_depth(py_server_t* self, PyObject* _) {
 static PyObject* server_max_lifetime(py_server_t* self, PyObject* _) {
     return PyLong_FromLong(self->config.max_lifetime_micro_seconds);
 }
+static PyObject* server_loop(py_server_t* self, PyObject* _) {
+    PyObject* loop = server_event_loop(self);
+    Py_XINCREF(loop);
+    return loop;
+}
+
+static PyObject* latency_to_dict(ucall_latency_t const* latency) {
+    return Py_BuildValue("{s:K,s:K,s:K,s:K,s:K,s:K,s:K}",                     //
+                         "count", latency->count, "sum_ns", latency->sum_ns,     //
+                         "p50_ns", latency->p50_ns, "p90_ns", latency->p90_ns,   //
+                         "p99_ns", latency->p99_ns, "p999_ns", latency->p999_ns, //
+                         "max_ns", latency->max_ns);
+}
+
+static PyObject* allocations_to_dict(ucall_allocations_t const* allocations) {
+    return Py_BuildValue("{s:K,s:K,s:K}", "count", allocations->count, "requests", allocations->requests, //
+                         "peak_bytes", allocations->peak_bytes);
+}
+
+static PyObject* server_stats(py_server_t* self, PyObject* _) {
+    ucall_method_stats_t* methods = (ucall_method_stats_t*)malloc(sizeof(ucall_method_stats_t) * self->count_added);
+    if (self->count_added && !methods)
+        return PyErr_NoMemory();
+    ucall_stats_t stats = {.methods = methods, .methods_capacity = self->count_added};
+    ucall_get_stats(self->server, &stats);
+
+    PyObject* methods_dict = PyDict_New();
+    for (size_t i = 0; methods_dict && i != stats.methods_count && i != stats.methods_capacity; ++i) {
+        PyObject* method = Py_BuildValue("{s:N,s:N}",                                       //
+                                         "callback", latency_to_dict(&methods[i].callback), //
+                                         "request", latency_to_dict(&methods[i].request));
+        PyObject* name = PyUnicode_FromStringAndSize(methods[i].name, methods[i].name_length);
+        if (!method || !name || PyDict_SetItem(methods_dict, name, method) < 0)
+            Py_CLEAR(methods_dict);
+        Py_XDECREF(method);
+        Py_XDECREF(name);
+    }
+    free(methods);
+    if (!methods_dict)
+        return NULL;
+
+    return Py_BuildValue("{s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:N,s:N,s:N,s:N}",      //
+                         "connections_accepted", stats.connections_accepted,           //
+                         "connections_closed", stats.connections_closed,               //
+                         "bytes_received", stats.bytes_received,                       //
+                         "bytes_sent", stats.bytes_sent,                               //
+                         "packets_received", stats.packets_received,                   //
+                         "packets_sent", stats.packets_sent,                           //
+                         "connections_active", stats.connections_active,               //
+                         "connections_capacity", stats.connections_capacity,           //
+                         "deferred_replies_pending", stats.deferred_replies_pending,   //
+                         "input_buffers", allocations_to_dict(&stats.input_buffers),   //
+                         "output_buffers", allocations_to_dict(&stats.output_buffers), //
+                         "parsers", allocations_to_dict(&stats.parsers),               //
+                         "methods", methods_dict);
+}
 
 static PyMethodDef server_methods[] = {
     {"get", (PyCFunction)&server_add_procedure_get, METH_VARARGS, PyDoc_STR("Append a procedure callback")},
@@ -446,6 +735,8 @@ static PyGetSetDef server_computed_properties[] = {
     {"port", (getter)&server_port, NULL, PyDoc_STR("On which port the server listens")},
     {"queue_depth", (getter)&server_queue_depth, NULL, PyDoc_STR("Max number of concurrent users")},
     {"max_lifetime", (getter)&server_max_lifetime, NULL, PyDoc_STR("Max lifetime of connections in microseconds")},
+    {"loop", (getter)&server_loop, NULL, PyDoc_STR("Event loop running coroutine callbacks in a companion thread")},
+    {"stats", (getter)&server_stats, NULL, PyDoc_STR("Counters, gauges and latencies since the start, never reset")},
     {NULL},
 };
 
@@ -456,9 +747,25 @@ static PyMappingMethods server_mapping_methods = {
 };
 
 static void server_dealloc(py_server_t* self) {
+    if (self->loop) {
+        PyObject* stop = PyObject_GetAttrString(self->loop, "stop");
+        PyObject* stopped = stop ? PyObject_CallMethod(self->loop, "call_soon_threadsafe", "O", stop) : NULL;
+        PyObject* joined = stopped ? PyObject_CallMethod(self->loop_thread, "join", NULL) : NULL;
+        Py_XDECREF(joined);
+        Py_XDECREF(stopped);
+        Py_XDECREF(stop);
+        PyErr_Clear();
+        Py_CLEAR(self->run_coroutine_threadsafe);
+        Py_CLEAR(self->loop_thread);
+        Py_CLEAR(self->loop);
+    }
+    ucall_free(self->server);
+    for (size_t i = 0; i != self->count_added; ++i)
+        free(self->wrappers[i]->name), free(self->wrappers[i]);
     free(self->wrappers);
     free(self->config.ssl_certificates_paths);
-    ucall_free(self->server);
+    free((char*)self->config.metrics_path);
+    free((char*)self->config.logs_format);
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
@@ -469,8 +776,10 @@ static PyObject* server_new(PyTypeObject* type, PyObject* args, PyObject* keywor
 
 static int server_init(py_server_t* self, PyObject* args, PyObject* keywords) {
     static const char const* keywords_list[] = {
-        "hostname", "port",   "protocol",  "queue_depth", "max_callbacks", "max_threads", "count_threads",
-        "quiet",    "ssl_pk", "ssl_certs", NULL,
+        "hostname", "port", "protocol", "queue_depth", "max_callbacks", "max_threads", "count_threads", "quiet",
+        "ssl_pk", "ssl_certs", "metrics_path", "logs_file_descriptor", "logs_format", "slow_request_micro_seconds",
+        "slow_request_prefix_bytes", "access_log_file_descriptor", "trace_export_file_descriptor",
+        "connection_buffer_bytes", "adaptive_connection_buffers", NULL,
     };
     self->config.hostname = "0.0.0.0";
     self->config.port = 8545;
@@ -484,13 +793,25 @@ static int server_init(py_server_t* self, PyObject* args, PyObject* keywords) {
     self->quiet = false;
 
     PyObject* certs_path = NULL;
+    char const* metrics_path = NULL;
+    char const* logs_format = NULL;
+    int adaptive_connection_buffers = 0;
 
-    if (!PyArg_ParseTupleAndKeywords(args, keywords, "|snnnnnnpsO", (char**)keywords_list, //
+    if (!PyArg_ParseTupleAndKeywords(args, keywords, "|snnnnnnpsOzizIIiiIp", (char**)keywords_list, //
                                      &self->config.hostname, &self->config.port, &self->config.protocol,
                                      &self->config.queue_depth, &self->config.max_callbacks, &self->config.max_threads,
                                      &self->count_threads, &self->quiet, &self->config.ssl_private_key_path,
-                                     &certs_path))
+                                     &certs_path, &metrics_path, &self->config.logs_file_descriptor, &logs_format,
+                                     &self->config.slow_request_micro_seconds, &self->config.slow_request_prefix_bytes,
+                                     &self->config.access_log_file_descriptor,
+                                     &self->config.trace_export_file_descriptor,
+                                     &self->config.connection_buffer_bytes, &adaptive_connection_buffers))
         return -1;
+    self->config.adaptive_connection_buffers = adaptive_connection_buffers;
+
+    // The server keeps referencing the strings, while the arguments may be collected.
+    self->config.metrics_path = metrics_path ? strdup(metrics_path) : NULL;
+    self->config.logs_format = logs_format ? strdup(logs_format) : NULL;
 
     if (self->config.ssl_private_key_path && certs_path && PySequence_Check(certs_path)) {
         self->config.ssl_certificates_count = PySequence_Length(certs_path);
@@ -500,7 +821,7 @@ static int server_init(py_server_t* self, PyObject* args, PyObject* keywords) {
     }
 
     self->wrapper_capacity = 16;
-    self->wrappers = (py_wrapper_t*)malloc(self->wrapper_capacity * sizeof(py_wrapper_t));
+    self->wrappers = (py_wrapper_t**)malloc(self->wrapper_capacity * sizeof(py_wrapper_t*));
 
     // Initialize the server
     ucall_init(&self->config, &self->server);
@@ -544,7 +865,7 @@ static PyModuleDef server_module = {
 };
 
 PyMODINIT_FUNC pyinit_f_m(void) {
-    if (PyType_Ready(&ucall_type) < 0)
+    if (PyType_Ready(&ucall_type) < 0 || PyType_Ready(&tensor_buffer_type) < 0)
         return NULL;
 
     PyObject* m = PyModule_Create(&server_module);
@@ -0,0 +1,242 @@
+#pragma once
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <turbob64.h>
+
+/**
+ * @brief Binary tensor encoding, shared with `ucall.client`.
+ *
+ * Layout, all integers are little-endian:
+ * - 4 bytes of `tensor_magic_k`,
+ * - 1 byte with the `struct`-module format character of the scalar type, like 'f' or 'q',
+ * - 1 byte with the number of dimensions,
+ * - 2 zero bytes,
+ * - `ndim` unsigned 64-bit dimensions,
+ * - zero padding up to a multiple of `tensor_header_alignment_k`,
+ * - raw C-contiguous scalars.
+ *
+ * The header length is a multiple of 3 and 8, so the header and the scalars can be Base64-encoded
+ * separately, without concatenating them, and scalars remain 8-byte aligned relative to the header.
+ */
+static char const tensor_magic_k[4] = {'\x93', 'U', 'C', 'T'};
+
+enum {
+    tensor_header_alignment_k = 24,
+    tensor_max_dimensions_k = 32,
+    tensor_max_header_length_k = 8 + 8 * tensor_max_dimensions_k,
+};
+
+typedef struct {
+    char format;
+    Py_ssize_t itemsize;
+    char const* memoryview_format;
+} tensor_scalar_t;
+
+static tensor_scalar_t const tensor_scalars_k[] = {
+    {'?', 1, "?"}, {'b', 1, "b"}, {'B', 1, "B"}, {'h', 2, "h"}, {'H', 2, "H"}, {'i', 4, "i"},
+    {'I', 4, "I"}, {'q', 8, "q"}, {'Q', 8, "Q"}, {'e', 2, "e"}, {'f', 4, "f"}, {'d', 8, "d"},
+};
+
+static bool tensor_host_is_little_endian(void) {
+    uint16_t const probe = 1;
+    return *(uint8_t const*)&probe == 1;
+}
+
+static size_t tensor_header_length(size_t ndim) {
+    size_t unaligned = 8 + 8 * ndim;
+    return (unaligned + tensor_header_alignment_k - 1) / tensor_header_alignment_k * tensor_header_alignment_k;
+}
+
+static tensor_scalar_t const* tensor_scalar_for(char format) {
+    for (size_t i = 0; i != sizeof(tensor_scalars_k) / sizeof(tensor_scalars_k[0]); ++i)
+        if (tensor_scalars_k[i].format == format)
+            return &tensor_scalars_k[i];
+    return NULL;
+}
+
+/**
+ * @brief Maps a buffer-protocol format string, like "<f" or "l", to one of `tensor_scalars_k`.
+ * @return NULL for big-endian, composite and unsupported formats.
+ */
+static tensor_scalar_t const* tensor_scalar_for_buffer(char const* format, Py_ssize_t itemsize) {
+    if (!format)
+        format = "B";
+    if (*format == '@' || *format == '=' || *format == '<')
+        ++format;
+    if (!format[0] || format[1])
+        return NULL;
+
+    char normalized = *format;
+    switch (normalized) {
+    case 'l':
+    case 'n': normalized = itemsize == 8 ? 'q' : 'i'; break;
+    case 'L':
+    case 'N': normalized = itemsize == 8 ? 'Q' : 'I'; break;
+    case 'c': normalized = 'B'; break;
+    }
+    tensor_scalar_t const* scalar = tensor_scalar_for(normalized);
+    return scalar && scalar->itemsize == itemsize ? scalar : NULL;
+}
+
+/**
+ * @brief Checks if a Base64-encoded binary argument carries the tensor header, decoding just its prefix.
+ */
+static bool tensor_is_encoded(char const* base64, size_t base64_length) {
+    unsigned char prefix[6];
+    return base64_length >= tensor_header_length(0) / 3 * 4 &&
+           tb64dec((unsigned char const*)base64, 8, prefix) == sizeof(prefix) &&
+           memcmp(prefix, tensor_magic_k, sizeof(tensor_magic_k)) == 0;
+}
+
+/**
+ * @brief Read-only buffer-protocol exporter, owning the decoded bytes of a binary argument.
+ * The `memoryview` objects passed to callbacks wrap it, so anything the callback keeps, like
+ * `numpy.asarray(view)`, holds a reference to it, and remains valid once the request is gone.
+ */
+typedef struct {
+    PyObject_VAR_HEAD
+    Py_ssize_t offset;
+    Py_ssize_t length;
+    Py_ssize_t itemsize;
+    char const* format;
+    int ndim;
+    Py_ssize_t shape[tensor_max_dimensions_k];
+    Py_ssize_t strides[tensor_max_dimensions_k];
+    char data[1];
+} tensor_buffer_t;
+
+static int tensor_buffer_get(PyObject* exporter, Py_buffer* view, int flags) {
+    tensor_buffer_t* buffer = (tensor_buffer_t*)exporter;
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "Binary arguments are read-only");
+        view->obj = NULL;
+        return -1;
+    }
+    bool wants_shape = (flags & PyBUF_ND) == PyBUF_ND;
+    Py_INCREF(exporter);
+    view->obj = exporter;
+    view->buf = buffer->data + buffer->offset;
+    view->len = buffer->length;
+    view->readonly = 1;
+    view->itemsize = wants_shape ? buffer->itemsize : 1;
+    view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT ? (char*)(wants_shape ? buffer->format : "B") : NULL;
+    view->ndim = wants_shape ? buffer->ndim : 1;
+    view->shape = wants_shape ? buffer->shape : NULL;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? buffer->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+static PyBufferProcs tensor_buffer_procs_k = {tensor_buffer_get, NULL};
+
+static PyTypeObject tensor_buffer_type = {
+    PyVarObject_HEAD_INIT(NULL, 0).tp_name = "ucall.Buffer",
+    .tp_basicsize = offsetof(tensor_buffer_t, data),
+    .tp_itemsize = 1,
+    .tp_as_buffer = &tensor_buffer_procs_k,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = PyDoc_STR("Decoded binary argument, exported as a read-only buffer"),
+};
+
+/**
+ * @brief Decodes a Base64 argument into a new exporter, shaped as a flat array of bytes.
+ * @return New reference, or NULL with a Python exception set.
+ */
+static tensor_buffer_t* tensor_buffer_decode(char const* base64, size_t base64_length) {
+    tensor_buffer_t* buffer = PyObject_NewVar(tensor_buffer_t, &tensor_buffer_type, base64_length / 4 * 3 + 1);
+    if (!buffer)
+        return NULL;
+    size_t length = tb64dec((unsigned char const*)base64, base64_length, (unsigned char*)buffer->data);
+    buffer->offset = 0;
+    buffer->length = (Py_ssize_t)length;
+    buffer->itemsize = 1;
+    buffer->format = "B";
+    buffer->ndim = 1;
+    buffer->shape[0] = (Py_ssize_t)length;
+    buffer->strides[0] = 1;
+    return buffer;
+}
+
+/**
+ * @brief Reshapes the decoded bytes of an encoded tensor into its scalars, without copying them.
+ * @return Zero, or -1 with a Python exception set.
+ */
+static int tensor_buffer_reshape(tensor_buffer_t* buffer) {
+    char const* data = buffer->data;
+    size_t length = (size_t)buffer->length;
+    size_t ndim = (uint8_t)data[5];
+    tensor_scalar_t const* scalar = tensor_scalar_for(data[4]);
+    size_t header_length = tensor_header_length(ndim);
+    if (!scalar || ndim > tensor_max_dimensions_k || length < header_length || !tensor_host_is_little_endian()) {
+        PyErr_SetString(PyExc_ValueError, "Malformed or unsupported tensor header");
+        return -1;
+    }
+
+    size_t count = 1;
+    for (size_t i = 0; i != ndim; ++i) {
+        uint64_t dimension;
+        memcpy(&dimension, data + 8 + 8 * i, sizeof(dimension));
+        if (dimension && count > (size_t)PY_SSIZE_T_MAX / dimension) {
+            PyErr_SetString(PyExc_ValueError, "Tensor is too large");
+            return -1;
+        }
+        count *= dimension;
+        buffer->shape[i] = (Py_ssize_t)dimension;
+    }
+    if (count * scalar->itemsize != length - header_length) {
+        PyErr_SetString(PyExc_ValueError, "Tensor shape doesn't match its payload");
+        return -1;
+    }
+
+    Py_ssize_t stride = scalar->itemsize;
+    for (size_t i = ndim; i != 0; --i)
+        buffer->strides[i - 1] = stride, stride *= buffer->shape[i - 1];
+    buffer->offset = (Py_ssize_t)header_length;
+    buffer->length = (Py_ssize_t)(length - header_length);
+    buffer->itemsize = scalar->itemsize;
+    buffer->format = scalar->memoryview_format;
+    buffer->ndim = (int)ndim;
+    return 0;
+}
+
+/**
+ * @brief Exports C-contiguous scalars of any buffer-protocol object, like `numpy.ndarray`.
+ * @return True if @p obj is a supported tensor. Otherwise, no exception is left set.
+ */
+static bool tensor_get_buffer(PyObject* obj, Py_buffer* view, tensor_scalar_t const** scalar) {
+    if (!tensor_host_is_little_endian() || PyByteArray_Check(obj) || !PyObject_CheckBuffer(obj))
+        return false;
+    if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+        PyErr_Clear();
+        return false;
+    }
+    *scalar = tensor_scalar_for_buffer(view->format, view->itemsize);
+    if (!*scalar || view->ndim > (int)tensor_max_dimensions_k) {
+        PyBuffer_Release(view);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Prints the tensor header into @p header, which must fit `tensor_header_length(view->ndim)` bytes.
+ */
+static size_t tensor_print_header(Py_buffer const* view, tensor_scalar_t const* scalar, char* header) {
+    size_t header_length = tensor_header_length(view->ndim);
+    memset(header, 0, header_length);
+    memcpy(header, tensor_magic_k, sizeof(tensor_magic_k));
+    header[4] = scalar->format;
+    header[5] = (char)view->ndim;
+    for (int i = 0; i != view->ndim; ++i) {
+        uint64_t dimension = (uint64_t)view->shape[i];
+        memcpy(header + 8 + 8 * i, &dimension, sizeof(dimension));
+    }
+    return header_length;
+}
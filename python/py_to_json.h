@@ -5,6 +5,8 @@
 
 #include <turbob64.h>
 
+#include "py_tensor.h"
+
 static const char int_to_hex_k[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
 
 static void char_to_hex(uint8_t const c, uint8_t* hex) {
@@ -12,22 +14,46 @@ static void char_to_hex(uint8_t const c, uint8_t* hex) {
     hex[1] = int_to_hex_k[c & 0x0F];
 }
 
+/**
+ * @brief Computes the length of a UTF-8 string, once the control characters, quotes and backslashes are escaped.
+ */
+static size_t escaped_length(char const* chars, Py_ssize_t size) {
+    size_t length = 0;
+    for (Py_ssize_t i = 0; i != size; ++i) {
+        uint8_t c = chars[i];
+        if (c == '"' || c == '\\' || c == '\b' || c == '\t' || c == '\n' || c == '\f' || c == '\r')
+            length += 2;
+        else if (c < 32)
+            length += 6;
+        else
+            length += 1;
+    }
+    return length;
+}
+
 static int to_string(PyObject* obj, char* data, size_t* len) {
     if (obj == Py_None)
         *len = sprintf(data, "%s", "null");
     else if (PyBool_Check(obj))
         *len = sprintf(data, "%s", obj == Py_False ? "false" : "true");
     else if (PyLong_Check(obj))
-        *len = sprintf(data, "%li", PyLong_AsLong(obj));
+        *len = sprintf(data, "%lld", PyLong_AsLongLong(obj));
     else if (PyFloat_Check(obj))
-        *len = sprintf(data, "%f", PyFloat_AsDouble(obj));
+        *len = sprintf(data, "%.17g", PyFloat_AsDouble(obj));
     else if (PyBytes_Check(obj)) {
         char* src = NULL;
-        size_t src_len = 0;
+        Py_ssize_t src_len = 0;
         PyBytes_AsStringAndSize(obj, &src, &src_len);
         char* begin = data;
         *(begin++) = '"';
-        begin += tb64enc(src, src_len, begin);
+        begin += tb64enc((unsigned char const*)src, src_len, (unsigned char*)begin);
+        *(begin++) = '"';
+        *len = begin - data;
+    } else if (PyByteArray_Check(obj)) {
+        char* begin = data;
+        *(begin++) = '"';
+        begin += tb64enc((unsigned char const*)PyByteArray_AS_STRING(obj), PyByteArray_GET_SIZE(obj),
+                         (unsigned char*)begin);
         *(begin++) = '"';
         *len = begin - data;
     } else if (PyUnicode_Check(obj)) {
@@ -35,7 +61,7 @@ static int to_string(PyObject* obj, char* data, size_t* len) {
         const char* char_ptr = PyUnicode_AsUTF8AndSize(obj, &size);
         char* begin = data;
         *(begin++) = '"';
-        for (size_t i = 0; i != size; ++i) {
+        for (Py_ssize_t i = 0; i != size; ++i) {
             uint8_t c = char_ptr[i];
             switch (c) {
             case 34:
@@ -104,6 +130,22 @@ static int to_string(PyObject* obj, char* data, size_t* len) {
         }
         *(begin++) = '"';
         *len = begin - data;
+    } else if (PyObject_CheckBuffer(obj)) {
+        // Tensors, like `numpy.ndarray`, are exported via the buffer protocol,
+        // Base64-encoding the scalars straight from the source memory.
+        Py_buffer view;
+        tensor_scalar_t const* scalar = NULL;
+        if (!tensor_get_buffer(obj, &view, &scalar))
+            return -1;
+        char header[tensor_max_header_length_k];
+        size_t header_length = tensor_print_header(&view, scalar, header);
+        char* begin = data;
+        *(begin++) = '"';
+        begin += tb64enc((unsigned char const*)header, header_length, (unsigned char*)begin);
+        begin += tb64enc((unsigned char const*)view.buf, view.len, (unsigned char*)begin);
+        *(begin++) = '"';
+        *len = begin - data;
+        PyBuffer_Release(&view);
     } else if (PySequence_Check(obj)) {
         char* begin = data;
         *(begin++) = '[';
@@ -112,7 +154,11 @@ static int to_string(PyObject* obj, char* data, size_t* len) {
         } else {
             for (Py_ssize_t i = 0; i < PySequence_Length(obj); i++) {
                 size_t n_len = 0;
-                to_string(PySequence_GetItem(obj, i), begin, &n_len);
+                PyObject* item = PySequence_GetItem(obj, i);
+                int failed = !item || to_string(item, begin, &n_len) != 0;
+                Py_XDECREF(item);
+                if (failed)
+                    return -1;
                 begin += n_len;
                 *(begin++) = ',';
             }
@@ -129,11 +175,13 @@ static int to_string(PyObject* obj, char* data, size_t* len) {
             Py_ssize_t pos = 0;
             while (PyDict_Next(obj, &pos, &key, &value)) {
                 size_t n_len = 0;
-                to_string(key, begin, &n_len);
+                if (to_string(key, begin, &n_len) != 0)
+                    return -1;
                 begin += n_len;
                 (*begin++) = ':';
                 n_len = 0;
-                to_string(value, &begin[*len], &n_len);
+                if (to_string(value, begin, &n_len) != 0)
+                    return -1;
                 begin += n_len;
                 (*begin++) = ',';
             }
@@ -151,34 +199,50 @@ static Py_ssize_t calculate_size_as_str(PyObject* obj) {
     else if (PyBool_Check(obj))
         return obj == Py_False ? 5 : 4;
     else if (PyLong_Check(obj))
-        return snprintf(NULL, 0, "%li", PyLong_AsLong(obj));
+        return snprintf(NULL, 0, "%lld", PyLong_AsLongLong(obj));
     else if (PyFloat_Check(obj))
-        return snprintf(NULL, 0, "%f", PyFloat_AsDouble(obj));
+        return snprintf(NULL, 0, "%.17g", PyFloat_AsDouble(obj));
     else if (PyBytes_Check(obj)) {
-        size_t len = 0;
-        char* data_ptr = NULL;
-        PyBytes_AsStringAndSize(obj, &data_ptr, &len);
-        return tb64enclen(len) + 2;
+        return tb64enclen(PyBytes_GET_SIZE(obj)) + 2;
+    } else if (PyByteArray_Check(obj)) {
+        return tb64enclen(PyByteArray_GET_SIZE(obj)) + 2;
     } else if (PyUnicode_Check(obj)) {
         Py_ssize_t byte_size = 0;
-        PyUnicode_AsUTF8AndSize(obj, &byte_size);
-        return byte_size + 2;
+        char const* chars = PyUnicode_AsUTF8AndSize(obj, &byte_size);
+        return chars ? (Py_ssize_t)escaped_length(chars, byte_size) + 2 : -1;
+    } else if (PyObject_CheckBuffer(obj)) {
+        Py_buffer view;
+        tensor_scalar_t const* scalar = NULL;
+        if (!tensor_get_buffer(obj, &view, &scalar))
+            return -1;
+        Py_ssize_t size = tb64enclen(tensor_header_length(view.ndim)) + tb64enclen(view.len) + 2;
+        PyBuffer_Release(&view);
+        return size;
     } else if (PySequence_Check(obj)) {
-        size_t size = 2;
+        Py_ssize_t size = 2;
         if (PySequence_Length(obj)) {
-            for (Py_ssize_t i = 0; i < PySequence_Length(obj); i++)
-                size += calculate_size_as_str(PySequence_GetItem(obj, i)) + 1;
+            for (Py_ssize_t i = 0; i < PySequence_Length(obj); i++) {
+                PyObject* item = PySequence_GetItem(obj, i);
+                Py_ssize_t item_size = item ? calculate_size_as_str(item) : -1;
+                Py_XDECREF(item);
+                if (item_size < 0)
+                    return -1;
+                size += item_size + 1;
+            }
             --size;
         }
         return size;
     } else if (PyDict_Check(obj)) {
-        size_t size = 2;
+        Py_ssize_t size = 2;
         if (PyDict_Size(obj)) {
             PyObject *key, *value;
             Py_ssize_t pos = 0;
             while (PyDict_Next(obj, &pos, &key, &value)) {
-                size += calculate_size_as_str(key) + 1;
-                size += calculate_size_as_str(value) + 1;
+                Py_ssize_t key_size = calculate_size_as_str(key);
+                Py_ssize_t value_size = calculate_size_as_str(value);
+                if (key_size < 0 || value_size < 0)
+                    return -1;
+                size += key_size + value_size + 2;
             }
             --size;
         }
@@ -4,12 +4,16 @@ import errno
 import base64
 import random
 import socket
+import asyncio
+import functools
 from io import BytesIO
-from typing import Union
+from typing import Iterable, List, Optional, Union
 
 import numpy as np
 from PIL import Image
 
+from ucall.tensor import TENSOR_MAGIC, tensor_format, pack_tensor, unpack_tensor
+
 
 class Response:
 
@@ -31,8 +35,10 @@ class Response:
 
     @property
     def numpy(self) -> np.ndarray:
-        buf = BytesIO(self.bytes)
-        return np.load(buf, allow_pickle=True)
+        buffer = self.bytes
+        if buffer.startswith(TENSOR_MAGIC):
+            return unpack_tensor(buffer)
+        return np.load(BytesIO(buffer), allow_pickle=False)
 
     @property
     def image(self) -> Image.Image:
@@ -47,9 +53,10 @@ class Request:
         self.packed = self.pack(json)
 
     def _pack_numpy(self, array):
+        if tensor_format(array.dtype):
+            return base64.b64encode(pack_tensor(array)).decode()
         buf = BytesIO()
-        np.save(buf, array)
-        buf.seek(0)
+        np.save(buf, array, allow_pickle=False)
         return base64.b64encode(buf.getvalue()).decode()
 
     def _pack_bytes(self, buffer):
@@ -230,3 +237,85 @@ class ClientTLS(Client):
             self.sock.setblocking(True)
 
         return self.sock.pending() <= 0
+
+
+def _params_of(args, kwargs):
+    assert len(args) == 0 or len(kwargs) == 0, 'Can\'t mix positional and keyword parameters!'
+    return list(args) if len(args) != 0 else kwargs
+
+
+class ClientPool:
+    """
+    JSON-RPC Client backed by the native `ucall.client_native` extension.
+    Pools connections across threads, serializes requests and parses replies
+    outside of the interpreter, releasing the GIL while waiting for the server.
+
+    Unlike `Client`, returns the decoded `result` directly and raises a `RuntimeError`
+    with the JSON-RPC `error` object, or an `OSError` if the connection fails.
+    Tensors, packed like `ucall.tensor.pack_tensor` does, are returned as read-only NumPy arrays,
+    while other binary results remain Base64 strings, as JSON doesn't mark them.
+
+    `pipeline_depth` limits the number of requests in flight per connection.
+    UCall servers answer pipelined requests in order, but set it to 1 for servers that don't.
+
+    With `ssl` enabled, connections use TLS 1.3, verifying the server certificate against
+    the system authorities, or the `ssl_certificate_authorities` PEM file, unless `ssl_allow_self_signed`.
+    """
+
+    def __init__(
+            self, uri: str = '127.0.0.1', port: int = 8545, use_http: bool = True,
+            connections: int = 4, pipeline_depth: int = 16, timeout: float = 10.0,
+            ssl: bool = False, ssl_allow_self_signed: bool = False,
+            ssl_certificate_authorities: Optional[str] = None) -> None:
+        from ucall.client_native import Pool
+        self.native = Pool(uri, port, use_http=use_http, connections=connections,
+                           pipeline_depth=pipeline_depth, timeout=timeout, ssl=ssl,
+                           ssl_allow_self_signed=ssl_allow_self_signed,
+                           ssl_certificate_authorities=ssl_certificate_authorities)
+
+    def __getattr__(self, name):
+        def call(*args, **kwargs):
+            return self.native.call(name, _params_of(args, kwargs))
+        return call
+
+    def call(self, method: str, params: Union[list, tuple, dict, None] = None) -> object:
+        return self.native.call(method, params)
+
+    def call_many(self, calls: Iterable[tuple], return_exceptions: bool = False) -> List[object]:
+        """Spreads `(method, params)` calls across pooled connections, returning results in order."""
+        return self.native.call_many(list(calls), return_exceptions=return_exceptions)
+
+    def batch(self, calls: Iterable[tuple], return_exceptions: bool = False) -> List[object]:
+        """Sends `(method, params)` calls as a single JSON-RPC batch, returning results in order."""
+        return self.native.batch(list(calls), return_exceptions=return_exceptions)
+
+
+class AsyncExecutorClientPool(ClientPool):
+    """
+    `asyncio` flavor of `ClientPool`, that offloads every call to a thread of the `executor`.
+    The sockets aren't driven by the event loop: each awaited call blocks an executor thread,
+    with the GIL released, until its replies arrive, so the number of concurrent calls is
+    bounded by the executor size. Prefer `call_many` or `batch` to fan out many requests.
+    """
+
+    def __init__(self, *args, executor: Optional[object] = None, **kwargs) -> None:
+        super().__init__(*args, **kwargs)
+        self.executor = executor
+
+    async def _run(self, function, *args, **kwargs):
+        loop = asyncio.get_running_loop()
+        return await loop.run_in_executor(self.executor, functools.partial(function, *args, **kwargs))
+
+    def __getattr__(self, name):
+        async def call(*args, **kwargs):
+            return await self._run(self.native.call, name, _params_of(args, kwargs))
+        return call
+
+    async def call(self, method: str, params: Union[list, tuple, dict, None] = None) -> object:
+        return await self._run(self.native.call, method, params)
+
+    async def call_many(self, calls: Iterable[tuple], return_exceptions: bool = False) -> List[object]:
+        return await self._run(self.native.call_many, list(calls), return_exceptions=return_exceptions)
+
+    async def batch(self, calls: Iterable[tuple], return_exceptions: bool = False) -> List[object]:
+        return await self._run(self.native.batch, list(calls), return_exceptions=return_exceptions)
@@ -8,6 +8,8 @@ from io import BytesIO
 import numpy as np
 from PIL import Image
 
+from ucall.tensor import tensor_format
+
 
 def supports_io_uring() -> bool:
     if platform.system() != "Linux":
@@ -60,21 +62,40 @@ class Server:
     def run(self, max_cycles: int = -1, max_seconds: float = -1):
         return self.native.run(max_cycles, max_seconds)
 
-    def unpack(self, arg: bytes, hint: type):
-        if hint == bytes or hint == bytearray:
-            return arg
+    @property
+    def loop(self):
+        """Event loop awaiting `async def` procedures in a companion thread.
+        Resources used by coroutines, like connection pools, should be bound to it."""
+        return self.native.loop
 
-        bin = BytesIO(arg)
+    @property
+    def stats(self) -> dict:
+        """Counters, gauges and latency percentiles of every procedure since the start.
+        Reading them is cheap, doesn't reset them, and doesn't affect the logs."""
+        return self.native.stats
+
+    def unpack(self, arg: Union[bytes, memoryview], hint: type):
+        if hint == bytes or hint == bytearray or hint == memoryview:
+            return arg
 
+        # Tensors arrive as read-only views of the bytes decoded from the request,
+        # so wrapping them into NumPy arrays doesn't copy the data again.
+        # Those views own the bytes, so the arrays can be kept past the call.
         if hint == np.ndarray:
-            return np.load(bin, allow_pickle=True)
+            if isinstance(arg, memoryview):
+                return np.asarray(arg)
+            return np.load(BytesIO(arg), allow_pickle=False)
         if hint == Image.Image:
-            return Image.open(bin)
+            return Image.open(BytesIO(arg))
 
     def pack(self, res):
+        # Little-endian numeric arrays are serialized by the native layer
+        # straight from their buffer, avoiding intermediate copies.
         if isinstance(res, np.ndarray):
+            if tensor_format(res.dtype) and res.dtype.byteorder != ">":
+                return np.ascontiguousarray(res)
             buf = BytesIO()
-            np.save(buf, res)
+            np.save(buf, res, allow_pickle=False)
             return buf.getvalue()
 
         if isinstance(res, Image.Image):
@@ -97,25 +118,39 @@ class Server:
             self.native.route(func)
             return func
 
-        @wraps(func)
-        def wrapper(*args, **kwargs):
+        def unpack_all(args, kwargs):
             new_args = []
             new_kwargs = {}
 
             for arg, hint in zip(args, hints.values()):
-                if isinstance(arg, bytes):
+                if isinstance(arg, (bytes, memoryview)):
                     new_args.append(self.unpack(arg, hint))
                 else:
                     new_args.append(arg)
 
             for kw, arg in kwargs.items():
-                if isinstance(arg, bytes):
+                if isinstance(arg, (bytes, memoryview)):
                     new_kwargs[kw] = self.unpack(arg, hints[kw])
                 else:
                     new_kwargs[kw] = arg
+            return new_args, new_kwargs
+
+        # Coroutines are awaited in a companion thread, while the server keeps polling.
+        if inspect.iscoroutinefunction(func):
+
+            @wraps(func)
+            async def wrapper(*args, **kwargs):
+                new_args, new_kwargs = unpack_all(args, kwargs)
+                res = await func(*new_args, **new_kwargs)
+                return self.pack(res)
+
+        else:
 
-            res = func(*new_args, **new_kwargs)
-            return self.pack(res)
+            @wraps(func)
+            def wrapper(*args, **kwargs):
+                new_args, new_kwargs = unpack_all(args, kwargs)
+                res = func(*new_args, **new_kwargs)
+                return self.pack(res)
 
         wrapper.__signature__ = inspect.signature(func)
         self.native.route(wrapper)
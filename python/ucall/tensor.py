@@ -0,0 +1,42 @@
+import struct
+from typing import Optional
+
+import numpy as np
+
+# Binary tensor encoding, mirrored by `python/py_tensor.h` in the native server:
+# a magic prefix, `struct` format character, number of dimensions, two zero bytes,
+# 64-bit little-endian dimensions, zero-padding to a multiple of 24 bytes, and raw scalars.
+TENSOR_MAGIC = b'\x93UCT'
+TENSOR_FORMATS = {
+    'b1': '?', 'i1': 'b', 'u1': 'B', 'i2': 'h', 'u2': 'H', 'i4': 'i',
+    'u4': 'I', 'i8': 'q', 'u8': 'Q', 'f2': 'e', 'f4': 'f', 'f8': 'd',
+}
+TENSOR_DTYPES = {format: np.dtype('<' + dtype) for dtype, format in TENSOR_FORMATS.items()}
+
+
+def _tensor_header_length(ndim: int) -> int:
+    return (8 + 8 * ndim + 23) // 24 * 24
+
+
+def tensor_format(dtype: np.dtype) -> Optional[str]:
+    """`struct` format of the scalars, or None, if arrays of that type can't be packed as tensors."""
+    return TENSOR_FORMATS.get(f'{dtype.kind}{dtype.itemsize}')
+
+
+def pack_tensor(array: np.ndarray) -> bytes:
+    dtype = array.dtype.newbyteorder('<')
+    format = tensor_format(dtype)
+    if format is None:
+        raise TypeError(f'Unsupported tensor type: {array.dtype}')
+    array = np.ascontiguousarray(array, dtype=dtype)
+    header = bytearray(_tensor_header_length(array.ndim))
+    struct.pack_into(f'<4scB2x{array.ndim}Q', header, 0, TENSOR_MAGIC,
+                     format.encode(), array.ndim, *array.shape)
+    return bytes(header) + array.tobytes()
+
+
+def unpack_tensor(buffer: bytes) -> np.ndarray:
+    format, ndim = chr(buffer[4]), buffer[5]
+    shape = struct.unpack_from(f'<{ndim}Q', buffer, 8)
+    return np.frombuffer(buffer, dtype=TENSOR_DTYPES[format],
+                         offset=_tensor_header_length(ndim)).reshape(shape)
@@ -75,7 +75,7 @@ class CMakeBuild(build_ext):
         build_ext.run(self)
 
 
-ext_modules = [CMakeExtension("ucall.posix")]
+ext_modules = [CMakeExtension("ucall.posix"), CMakeExtension("ucall.client_native")]
 
 if platform.system() == "Linux":
     ext_modules.append(CMakeExtension("ucall.epoll"))
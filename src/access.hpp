@@ -0,0 +1,89 @@
+#pragma once
+
+#include <arpa/inet.h>  // `inet_ntop`
+#include <netinet/in.h> // `sockaddr_in`
+
+#include <cstdint>     // `std::uint64_t`
+#include <stdio.h>     // `std::snprintf`
+#include <string_view> // `std::string_view`
+
+#include "clock.hpp"
+#include "shared.hpp"
+#include "writer.hpp"
+
+namespace unum::ucall {
+
+/// @brief Requests, that every polling thread can queue before the writer catches up. Must be a power of two.
+static constexpr std::size_t access_ring_capacity_k = 4096;
+/// @brief Lines printed with a single `writev`.
+static constexpr std::size_t access_batch_k = 64;
+/// @brief Longest method name printed, before escaping.
+static constexpr std::size_t access_method_capacity_k = 128;
+/// @brief Longest printed line, fitting any escaped method name.
+static constexpr std::size_t access_line_capacity_k = access_method_capacity_k * 6 + 256;
+
+struct access_record_t {
+    /// @brief When the last byte of the reply was sent, on the `cycle_clock_t` scale.
+    std::uint64_t finished_ns;
+    std::uint64_t latency_ns;
+    /// @brief Name of the last method called, pointing into the callbacks of the server, or empty.
+    std::string_view method;
+    struct sockaddr client_address;
+    std::uint32_t request_bytes;
+    std::uint32_t reply_bytes;
+    /// @brief Code of the last error replied, or zero if the request succeeded.
+    std::int32_t status;
+    std::uint16_t thread_idx;
+};
+
+/**
+ * @brief Prints a served request as a single NDJSON line, timestamped in the Unix time.
+ */
+struct access_printer_t {
+    /// @brief Records are timestamped with the cycle counter, and printed in the Unix time.
+    std::uint64_t unix_offset_ns{};
+
+    std::size_t print(access_record_t const& record, char* line) const noexcept {
+        char client[INET_ADDRSTRLEN]{};
+        unsigned port = 0;
+        if (record.client_address.sa_family == AF_INET) {
+            auto const& address = reinterpret_cast<sockaddr_in const&>(record.client_address);
+            inet_ntop(AF_INET, &address.sin_addr, client, sizeof(client));
+            port = ntohs(address.sin_port);
+        }
+        char method[access_method_capacity_k * 6];
+        std::size_t method_len = escape_json_string(
+            record.method.data(), (std::min)(record.method.size(), access_method_capacity_k), method, sizeof(method));
+        auto len = snprintf( //
+            line, access_line_capacity_k,
+            R"({"ts_ns":%llu,"method":"%.*s","status":%d,"latency_ns":%llu,)"
+            R"("request_bytes":%u,"reply_bytes":%u,"client":"%s:%u","thread":%u})"
+            "\n",
+            static_cast<unsigned long long>(record.finished_ns + unix_offset_ns),                                    //
+            static_cast<int>(method_len), method, record.status, static_cast<unsigned long long>(record.latency_ns), //
+            record.request_bytes, record.reply_bytes, client, port, static_cast<unsigned>(record.thread_idx)         //
+        );
+        return len < 0 ? 0 : (std::min)(static_cast<std::size_t>(len), access_line_capacity_k - 1);
+    }
+
+    std::size_t print_dropped(std::size_t dropped, char* line) const noexcept {
+        auto len = snprintf(line, access_line_capacity_k, "{\"dropped\":%zu}\n", dropped);
+        return len < 0 ? 0 : static_cast<std::size_t>(len);
+    }
+};
+
+using access_writer_t = batched_writer_gt<access_record_t, access_printer_t, access_ring_capacity_k, access_batch_k,
+                                          access_line_capacity_k>;
+using access_ring_t = access_writer_t::ring_t;
+
+/**
+ * @brief Opt-in log of every served request, printed as NDJSON into a dedicated file descriptor.
+ */
+struct access_log_t : public access_writer_t {
+    void start(int file_descriptor) noexcept {
+        printer.unix_offset_ns = cycle_clock_t::unix_offset_ns();
+        access_writer_t::start(file_descriptor);
+    }
+};
+
+} // namespace unum::ucall
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>   // `std::max`
+#include <atomic>      // `std::atomic`
+#include <cstdint>     // `std::uint64_t`
+#include <memory>      // `std::unique_ptr`
+#include <stdio.h>     // `std::snprintf`
+#include <string_view> // `std::string_view`
+
+#include "containers.hpp"
+#include "histogram.hpp"
+#include "log.hpp"
+
+namespace unum::ucall {
+
+/// @brief Dynamically growing buffers of a connection, that may have to allocate while serving a request.
+enum class allocation_site_t : std::uint8_t {
+    /// @brief Requests outgrowing the embedded input page, copied into `exchange_pipes_t` heap memory.
+    input_k = 0,
+    /// @brief Replies outgrowing the embedded output page.
+    output_k,
+    /// @brief JSON parsers meeting a document larger than any before.
+    parser_k,
+};
+
+static constexpr std::size_t allocation_sites_k = 3;
+
+/// @brief Allocation histograms keep ~3% precision, like the per-method ones.
+using allocation_histogram_t = histogram_gt<6>;
+using owned_allocation_histogram_t = owned_histogram_gt<6>;
+
+/**
+ * @brief High-water mark raised by a single thread and read by any other, with no locked instructions.
+ */
+class owned_maximum_t {
+    std::atomic<std::size_t> value_{};
+
+  public:
+    void raise(std::size_t n) noexcept {
+        if (n > value_.load(std::memory_order_relaxed))
+            value_.store(n, std::memory_order_relaxed);
+    }
+    std::size_t load() const noexcept { return value_.load(std::memory_order_relaxed); }
+};
+
+/**
+ * @brief Allocations attributed to a single polling thread, occupying their own cache lines.
+ */
+struct alignas(64) allocation_shard_t {
+    /// @brief Largest buffer of every request, that had to allocate, in bytes.
+    owned_allocation_histogram_t bytes[allocation_sites_k]{};
+    /// @brief Every `malloc` and `realloc`, including the repeated growths within a single request.
+    owned_counter_t allocations[allocation_sites_k]{};
+    owned_counter_t requests[allocation_sites_k]{};
+    owned_maximum_t peak_bytes[allocation_sites_k]{};
+};
+
+/// @brief Counts since the server has started, or since the previous log, with the all-time largest buffer.
+struct allocation_totals_t {
+    std::size_t allocations{};
+    std::size_t requests{};
+    std::size_t peak_bytes{};
+};
+
+/**
+ * @brief Accounts for the requests spilling out of the pre-allocated pages of their connections, and for the
+ * growth of the JSON parsers, to size the buffers from data. Buffers report their allocations lazily, once per
+ * request, so the accounting costs nothing on the allocation path itself.
+ */
+struct allocation_stats_t {
+    std::unique_ptr<allocation_shard_t[]> shards{};
+    std::size_t shards_count{};
+    /// @brief Totals at the time of the last log.
+    std::uint64_t logged_bytes[allocation_sites_k][allocation_histogram_t::buckets_k]{};
+    std::uint64_t logged_allocations[allocation_sites_k]{};
+    std::uint64_t logged_requests[allocation_sites_k]{};
+
+    void record(std::size_t thread_idx, allocation_site_t site, allocations_t const& taken) noexcept {
+        if (!taken.count)
+            return;
+        allocation_shard_t& shard = shards[thread_idx];
+        std::size_t i = static_cast<std::size_t>(site);
+        shard.bytes[i].record(taken.peak_bytes);
+        shard.allocations[i].add(taken.count);
+        shard.requests[i].add(1);
+        shard.peak_bytes[i].raise(taken.peak_bytes);
+    }
+
+    /// @brief Sums up all the shards since the server has started, with the largest buffer ever allocated.
+    allocation_totals_t total(allocation_site_t site) const noexcept {
+        std::size_t i = static_cast<std::size_t>(site);
+        allocation_totals_t totals{};
+        for (std::size_t j = 0; j != shards_count; ++j) {
+            totals.allocations += shards[j].allocations[i].load();
+            totals.requests += shards[j].requests[i].load();
+            totals.peak_bytes = (std::max)(totals.peak_bytes, shards[j].peak_bytes[i].load());
+        }
+        return totals;
+    }
+
+    /// @brief Prints the allocations since the previous call, or nothing if there were none.
+    std::size_t log_human_readable(char* buffer, std::size_t buffer_capacity) noexcept {
+        allocation_histogram_t input, output, parser;
+        allocation_totals_t inputs, outputs, parsers;
+        if (!collect(input, output, parser, inputs, outputs, parsers))
+            return 0;
+        auto n = [](std::uint64_t value) noexcept { return static_cast<std::size_t>(value); };
+        auto len = snprintf( //
+            buffer, buffer_capacity,
+            "allocations: inputs %zu in %zu requests, p50 %zu, max %zu, peak %zu bytes, "
+            "outputs %zu in %zu requests, p50 %zu, max %zu, peak %zu bytes, "
+            "parsers %zu, max %zu, peak %zu bytes. \n",
+            n(inputs.allocations), n(inputs.requests), n(input.percentile(50)), n(input.max()),     //
+            n(inputs.peak_bytes),                                                                   //
+            n(outputs.allocations), n(outputs.requests), n(output.percentile(50)), n(output.max()), //
+            n(outputs.peak_bytes),                                                                  //
+            n(parsers.allocations), n(parser.max()), n(parsers.peak_bytes)                          //
+        );
+        return len < 0 ? 0 : (std::min)(static_cast<std::size_t>(len), buffer_capacity - 1);
+    }
+
+    /// @brief Prints the allocations since the previous call as an `,"allocations":{...}` member, or nothing.
+    std::size_t log_json(char* buffer, std::size_t buffer_capacity) noexcept {
+        allocation_histogram_t input, output, parser;
+        allocation_totals_t inputs, outputs, parsers;
+        if (!collect(input, output, parser, inputs, outputs, parsers))
+            return 0;
+        auto format = R"(,"allocations":{)"
+                      R"("input":{"allocations":%zu,"requests":%zu,"p50":%zu,"p99":%zu,"max":%zu,"peak":%zu},)"
+                      R"("output":{"allocations":%zu,"requests":%zu,"p50":%zu,"p99":%zu,"max":%zu,"peak":%zu},)"
+                      R"("parser":{"allocations":%zu,"max":%zu,"peak":%zu}})";
+        auto n = [](std::uint64_t value) noexcept { return static_cast<std::size_t>(value); };
+        auto len = snprintf( //
+            buffer, buffer_capacity, format,
+            n(inputs.allocations), n(inputs.requests), n(input.percentile(50)), n(input.percentile(99)),     //
+            n(input.max()), n(inputs.peak_bytes),                                                            //
+            n(outputs.allocations), n(outputs.requests), n(output.percentile(50)), n(output.percentile(99)), //
+            n(output.max()), n(outputs.peak_bytes),                                                          //
+            n(parsers.allocations), n(parser.max()), n(parsers.peak_bytes)                                   //
+        );
+        return len < 0 ? 0 : (std::min)(static_cast<std::size_t>(len), buffer_capacity - 1);
+    }
+
+  private:
+    /// @brief Merges the shards into histograms and totals of the allocations since the previous call,
+    /// with the all-time peaks, returning false if there were none.
+    bool collect(allocation_histogram_t& input, allocation_histogram_t& output, allocation_histogram_t& parser,
+                 allocation_totals_t& inputs, allocation_totals_t& outputs, allocation_totals_t& parsers) noexcept {
+        allocation_histogram_t* histograms[allocation_sites_k] = {&input, &output, &parser};
+        allocation_totals_t* totals[allocation_sites_k] = {&inputs, &outputs, &parsers};
+        bool any = false;
+        for (std::size_t i = 0; i != allocation_sites_k; ++i) {
+            allocation_totals_t site_total = total(static_cast<allocation_site_t>(i));
+            *totals[i] = site_total;
+            totals[i]->allocations -= logged_allocations[i];
+            totals[i]->requests -= logged_requests[i];
+            logged_allocations[i] = site_total.allocations, logged_requests[i] = site_total.requests;
+            any |= totals[i]->allocations != 0;
+        }
+        if (!any)
+            return false;
+
+        for (std::size_t i = 0; i != allocation_sites_k; ++i)
+            for (std::size_t k = 0; k != allocation_histogram_t::buckets_k; ++k) {
+                std::uint64_t sum = 0;
+                for (std::size_t j = 0; j != shards_count; ++j)
+                    sum += shards[j].bytes[i].bucket(k);
+                histograms[i]->record_bucket(k, sum - logged_bytes[i][k]);
+                logged_bytes[i][k] = sum;
+            }
+        return true;
+    }
+};
+
+} // namespace unum::ucall
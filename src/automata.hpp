@@ -1,6 +1,8 @@
 #pragma once
 
 #include "connection.hpp"
+#include "metrics.hpp"
+#include "probes.hpp"
 #include "server.hpp"
 #include "shared.hpp"
 
@@ -10,6 +12,8 @@ struct automata_t {
     server_t& server;
     connection_t& connection;
     ssize_t completed_result{};
+    /// @brief The polling thread, whose statistics shard this automata updates.
+    std::uint16_t thread_idx{};
 
     void operator()() noexcept;
 
@@ -18,8 +22,13 @@ struct automata_t {
     bool is_corrupted() const noexcept;
 
     void send_next() noexcept;
+    void send_reply() noexcept;
     void receive_next() noexcept;
+    void process_input() noexcept;
     void close_gracefully() noexcept;
+    void record_request_latency() noexcept;
+    std::uint64_t record_step(flight_step_t) noexcept;
+    std::uint32_t connection_offset() const noexcept;
     protocol_t const& get_protocol() const noexcept;
 };
 
@@ -32,6 +41,37 @@ void automata_t::close_gracefully() noexcept {
     server.network_engine.close_connection_gracefully(connection);
 }
 
+void automata_t::record_request_latency() noexcept {
+    std::uint64_t now = cycle_clock_t::now_ns();
+    // Cores may disagree by a few cycles, if the thread has migrated since the request has arrived.
+    std::uint64_t latency = now > connection.request_started_ns ? now - connection.request_started_ns : 0;
+    if (server.transport.should_sample(thread_idx, now))
+        server.record_transport(connection, thread_idx);
+    server.record_allocations(connection, thread_idx);
+    if (server.slow_request_ns && latency > server.slow_request_ns)
+        server.log_slow_request(connection, thread_idx, now);
+    if (server.access_log.is_enabled())
+        server.log_access(connection, thread_idx, now, latency);
+    if (connection.trace.is_sampled())
+        server.export_span(connection, thread_idx, now);
+    connection.trace.has_context = false;
+    connection.method_name = {};
+    if (!connection.method_stats)
+        return;
+    connection.method_stats->shards[thread_idx].request_ns.record(latency);
+    connection.method_stats = nullptr;
+}
+
+std::uint32_t automata_t::connection_offset() const noexcept {
+    return static_cast<std::uint32_t>(server.connections.offset_of(connection));
+}
+
+std::uint64_t automata_t::record_step(flight_step_t step) noexcept {
+    std::uint64_t now = cycle_clock_t::now_ns();
+    server.recorder.record(thread_idx, step, connection_offset(), completed_result, now);
+    return now;
+}
+
 void automata_t::send_next() noexcept {
     exchange_pipes_t& pipes = connection.pipes;
     connection.stage = stage_t::responding_in_progress_k;
@@ -43,15 +83,97 @@ void automata_t::send_next() noexcept {
                                       server.connections.offset_of(connection) * 2u + 1u);
 }
 
+void automata_t::send_reply() noexcept {
+    connection.pipes.release_inputs();
+    // Some requests require no response at all,
+    // so we can go back to listening the port.
+    if (!connection.pipes.has_outputs()) {
+        connection.exchanges++;
+        record_request_latency();
+        // if (connection.exchanges >= server.max_lifetime_exchanges) TODO Why?
+        //     return close_gracefully();
+        // else
+        return receive_next();
+    } else {
+        connection.pipes.prepare_more_outputs();
+        return send_next();
+    }
+}
+
 void automata_t::receive_next() noexcept {
     exchange_pipes_t& pipes = connection.pipes;
     connection.stage = stage_t::expecting_reception_k;
     pipes.release_outputs();
 
+    // Pipelined requests have already arrived, and are answered without waiting for the socket.
+    if (pipes.has_pipelined_input()) {
+        connection.protocol.reset();
+        connection.request_started_ns = connection.last_active_ns;
+        if (!pipes.restore_pipelined_input()) {
+            ucall_call_reply_error_out_of_memory(this);
+            return send_next();
+        }
+        return process_input();
+    }
+
     server.network_engine.recv_packet(connection, (void*)pipes.next_input_address(), pipes.next_input_length(),
                                       server.connections.offset_of(connection) * 2u);
 }
 
+/**
+ * @brief Answers the first complete request in the input, or waits for the rest of it.
+ * Called both for the freshly received data, and for the pipelined requests held back from earlier.
+ */
+void automata_t::process_input() noexcept {
+    // Scrapes are answered by the server itself, whatever the protocol of its callbacks.
+    std::size_t scrape_length =
+        server.metrics_path.empty() ? 0 : metrics_request_length(connection.pipes.input_span(), server.metrics_path);
+    if (scrape_length) {
+        if (!connection.pipes.hold_pipelined_input(scrape_length) || !append_metrics(connection.pipes, server)) {
+            connection.pipes.release_outputs();
+            connection.pipes.append_outputs(metrics_unavailable_k);
+        }
+        return send_reply();
+    }
+    if (connection.protocol.is_input_complete(connection.pipes.input_span())) {
+        // Clients may send the next requests without waiting for the replies, but those are answered in order.
+        if (!connection.pipes.hold_pipelined_input(connection.protocol.request_length())) {
+            ucall_call_reply_error_out_of_memory(this);
+            return send_next();
+        }
+        if (server.capture)
+            server.capture->record(thread_idx, connection.capture_id, connection.pipes.input_span());
+        connection.request_dispatched_ns = record_step(flight_step_t::dispatch_k);
+        connection.request_bytes = static_cast<std::uint32_t>(connection.pipes.input_span().size());
+        connection.reply_error_code = 0;
+        if (server.spans.is_enabled())
+            connection.trace = {};
+        if (server.slow_request_ns)
+            server.slow_requests.remember_prefix(connection_offset(), connection.pipes.input_span());
+        server.engine.raise_request(connection, this, thread_idx, connection_offset());
+        // Deferred replies are stamped by the thread submitting them.
+        if (server.slow_request_ns && connection.stage != stage_t::awaiting_deferred_reply_k)
+            connection.request_replied_ns = cycle_clock_t::now_ns();
+
+        // The callback may have postponed the reply, in which case the inputs
+        // must outlive it and the connection stays idle until it's submitted.
+        // If it was submitted before we got here, the other thread left the sending to us.
+        if (connection.stage == stage_t::awaiting_deferred_reply_k &&
+            !connection.deferred_handoff.exchange(true, std::memory_order_acq_rel))
+            return;
+        return send_reply();
+    }
+    // We are looking for more data to come
+    else if (connection.pipes.shift_input_to_dynamic()) {
+        return receive_next();
+    }
+    // We may fail to allocate memory to receive the next input
+    else {
+        ucall_call_reply_error_out_of_memory(this);
+        return send_next();
+    }
+}
+
 void automata_t::operator()() noexcept {
 
     switch (connection.stage) {
@@ -59,16 +181,20 @@ void automata_t::operator()() noexcept {
     case stage_t::waiting_to_accept_k:
 
         if (server.network_engine.is_canceled(completed_result, connection)) {
-            server.release_connection(connection);
+            server.release_connection(connection, thread_idx);
             return;
         }
+        record_step(flight_step_t::accept_k);
+        UCALL_PROBE2(accept, connection_offset(), completed_result);
         if (server.ssl_ctx)
             connection.make_tls(&server.ssl_ctx->ssl);
+        if (server.capture)
+            connection.capture_id = server.capture->next_connection_id();
 
         // Check if accepting the new connection request worked out.
         connection.record_activity();
         ++server.active_connections;
-        server.stats.added_connections.fetch_add(1, std::memory_order_relaxed);
+        server.stats.shard(thread_idx).added_connections.add(1);
         connection.descriptor = descriptor_t{completed_result};
         return receive_next();
 
@@ -87,65 +213,49 @@ void automata_t::operator()() noexcept {
         // If the following timeout request has happened,
         // we don't want to do anything here. Let's leave the faith of
         // this connection to the subsequent timer to decide.
-        if (server.network_engine.is_corrupted(completed_result, connection) || connection.expired())
+        if (server.network_engine.is_corrupted(completed_result, connection) || connection.expired()) {
+            record_step(flight_step_t::receive_k);
             return close_gracefully();
+        }
 
         if (server.network_engine.is_canceled(completed_result, connection)) {
             connection.next_wakeup *= sleep_growth_factor_k;
             completed_result = 0;
         }
 
-        // No data was received.
+        // No data was received. Those wake-ups are frequent, and aren't recorded.
         if (completed_result == 0) {
             connection.empty_transmits++;
             return receive_next();
         }
 
         // Absorb the arrived data.
-        server.stats.bytes_received.fetch_add(completed_result, std::memory_order_relaxed);
-        server.stats.packets_received.fetch_add(1, std::memory_order_relaxed);
+        server.stats.shard(thread_idx).bytes_received.add(completed_result);
+        server.stats.shard(thread_idx).packets_received.add(1);
         connection.empty_transmits = 0;
-        connection.record_activity();
+        // The recorded step doubles as the activity timestamp.
+        connection.last_active_ns = record_step(flight_step_t::receive_k);
+        UCALL_PROBE2(receive, connection_offset(), completed_result);
+        if (!connection.pipes.input_span().size())
+            connection.request_started_ns = connection.last_active_ns;
         if (!connection.pipes.absorb_input(completed_result)) {
             ucall_call_reply_error_out_of_memory(this);
             return send_next();
         }
 
-        if (!connection.prepare_step())
+        if (!connection.prepare_step()) {
+            record_step(flight_step_t::handshake_k);
             return send_next();
+        }
 
         // If we have reached the end of the stream,
         // it is time to analyze the contents
         // and send back a response.
         connection.decrypt(completed_result);
-        if (connection.protocol.is_input_complete(connection.pipes.input_span())) {
-            server.engine.raise_request(connection.pipes, connection.protocol, this);
-
-            connection.pipes.release_inputs();
-            // Some requests require no response at all,
-            // so we can go back to listening the port.
-            if (!connection.pipes.has_outputs()) {
-                connection.exchanges++;
-                // if (connection.exchanges >= server.max_lifetime_exchanges) TODO Why?
-                //     return close_gracefully();
-                // else
-                return receive_next();
-            } else {
-                connection.pipes.prepare_more_outputs();
-                return send_next();
-            }
-        }
-        // We are looking for more data to come
-        else if (connection.pipes.shift_input_to_dynamic()) {
-            return receive_next();
-        }
-        // We may fail to allocate memory to receive the next input
-        else {
-            ucall_call_reply_error_out_of_memory(this);
-            return send_next();
-        }
+        return process_input();
 
     case stage_t::responding_in_progress_k:
+        record_step(flight_step_t::respond_k);
         if (server.network_engine.is_corrupted(completed_result, connection) || connection.expired())
             return close_gracefully();
 
@@ -156,15 +266,19 @@ void automata_t::operator()() noexcept {
             completed_result = 0;
         }
 
-        if (!connection.is_ready())
+        if (!connection.is_ready()) {
+            record_step(flight_step_t::handshake_k);
             return receive_next();
+        }
 
         connection.record_activity();
-        server.stats.bytes_sent.fetch_add(completed_result, std::memory_order_relaxed);
-        server.stats.packets_sent.fetch_add(1, std::memory_order_relaxed);
+        UCALL_PROBE2(send, connection_offset(), completed_result);
+        server.stats.shard(thread_idx).bytes_sent.add(completed_result);
+        server.stats.shard(thread_idx).packets_sent.add(1);
         connection.pipes.mark_submitted_outputs(completed_result);
         if (!connection.pipes.has_remaining_outputs()) {
             connection.exchanges++;
+            record_request_latency();
             if (connection.must_close())
                 return close_gracefully();
             else
@@ -174,8 +288,15 @@ void automata_t::operator()() noexcept {
             return send_next();
         }
 
+    case stage_t::awaiting_deferred_reply_k:
+        // The reply was appended and finalized by `ucall_deferred_reply_content`.
+        record_step(flight_step_t::deferred_reply_k);
+        return send_reply();
+
     case stage_t::waiting_to_close_k:
-        return server.release_connection(connection);
+        record_step(flight_step_t::close_k);
+        UCALL_PROBE1(close, connection_offset());
+        return server.release_connection(connection, thread_idx);
 
     case stage_t::log_stats_k:
         server.log_and_reset_stats();
@@ -21,6 +21,19 @@ unum::ucall::any_param_t param_at(ucall_call_t call, size_t position) noexcept {
     return automata.get_protocol().get_param(position);
 }
 
+ucall_allocations_t allocations_of(unum::ucall::allocation_stats_t const& allocations,
+                                   unum::ucall::allocation_site_t site) noexcept {
+    unum::ucall::allocation_totals_t totals = allocations.total(site);
+    return {totals.allocations, totals.requests, totals.peak_bytes};
+}
+
+ucall_latency_t latency_of(unum::ucall::method_histogram_t const& histogram, std::uint64_t sum_ns) noexcept {
+    return {histogram.count(),        sum_ns,
+            histogram.percentile(50), histogram.percentile(90),
+            histogram.percentile(99), histogram.percentile(99.9),
+            histogram.max()};
+}
+
 #pragma endregion
 
 #pragma region C Interface Implementation
@@ -45,8 +58,13 @@ void ucall_take_call(ucall_server_t punned_server, uint16_t thread_idx) {
     // is responsible for checking if a specific request has been completed. All of the submitted
     // memory must be preserved until we get the confirmation.
     unum::ucall::server_t* server = reinterpret_cast<unum::ucall::server_t*>(punned_server);
-    if (thread_idx == 0)
+    if (thread_idx == 0) {
         server->consider_accepting_new_connection();
+        // Dumps requested with a signal can't be printed from the signal handler itself.
+        if (unum::ucall::flight_recorder_t::dump_requested.load(std::memory_order_relaxed) &&
+            unum::ucall::flight_recorder_t::dump_requested.exchange(false))
+            server->recorder.dump(server->flight_dump_descriptor(), server->logs_format == "json");
+    }
 
     constexpr std::size_t completed_max_k{16};
     unum::ucall::completed_event_t completed_events[completed_max_k]{};
@@ -60,11 +78,108 @@ void ucall_take_call(ucall_server_t punned_server, uint16_t thread_idx) {
             *server, //
             *completed.connection_ptr,
             completed.result,
+            thread_idx,
         };
 
         // If everything is fine, let automata work in its normal regime.
         automata();
     }
+
+    // Replies submitted from other threads for previously deferred calls.
+    unum::ucall::connection_t* deferred_connections[completed_max_k]{};
+    std::size_t deferred_count = server->pop_deferred_replies<completed_max_k>(deferred_connections);
+    for (std::size_t i = 0; i != deferred_count; ++i) {
+        unum::ucall::automata_t automata{*server, *deferred_connections[i], 0, thread_idx};
+        automata();
+    }
+}
+
+void ucall_dump_flight_recorder(ucall_server_t punned_server, int32_t file_descriptor) {
+    unum::ucall::server_t& server = *reinterpret_cast<unum::ucall::server_t*>(punned_server);
+    server.recorder.dump(file_descriptor, server.logs_format == "json");
+}
+
+uint64_t ucall_now_ns(void) {
+    unum::ucall::cycle_clock_t::calibrate();
+    return unum::ucall::cycle_clock_t::now_ns();
+}
+
+void ucall_get_stats(ucall_server_t punned_server, ucall_stats_t* stats) {
+    unum::ucall::server_t& server = *reinterpret_cast<unum::ucall::server_t*>(punned_server);
+    unum::ucall::stats_totals_t totals = server.stats.total();
+    stats->connections_accepted = totals.added_connections;
+    stats->connections_closed = totals.closed_connections;
+    stats->bytes_received = totals.bytes_received;
+    stats->bytes_sent = totals.bytes_sent;
+    stats->packets_received = totals.packets_received;
+    stats->packets_sent = totals.packets_sent;
+    stats->connections_active = server.active_connections.load(std::memory_order_relaxed);
+    stats->connections_capacity = server.connections.capacity();
+    stats->deferred_replies_pending = server.deferred_replies_count.load(std::memory_order_relaxed);
+    stats->input_buffers = allocations_of(server.allocations, unum::ucall::allocation_site_t::input_k);
+    stats->output_buffers = allocations_of(server.allocations, unum::ucall::allocation_site_t::output_k);
+    stats->parsers = allocations_of(server.allocations, unum::ucall::allocation_site_t::parser_k);
+
+    std::size_t methods_count = 0;
+    for (unum::ucall::named_callback_t const& named : server.engine.callbacks) {
+        if (!named.stats)
+            continue;
+        if (methods_count < stats->methods_capacity) {
+            unum::ucall::method_histogram_t callback, request;
+            std::uint64_t callback_sum, request_sum;
+            named.stats->snapshot(callback, request, callback_sum, request_sum);
+            ucall_method_stats_t& method = stats->methods[methods_count];
+            method.name = named.name.data();
+            method.name_length = named.name.size();
+            method.callback = latency_of(callback, callback_sum);
+            method.request = latency_of(request, request_sum);
+        }
+        ++methods_count;
+    }
+    stats->methods_count = methods_count;
+}
+
+bool ucall_get_trace_context(ucall_call_t call, ucall_trace_context_t* output) {
+    unum::ucall::automata_t& automata = *reinterpret_cast<unum::ucall::automata_t*>(call);
+    unum::ucall::traced_call_t const& trace = automata.connection.trace;
+    if (!trace.has_context)
+        return false;
+    std::memcpy(output->trace_id, trace.context.trace_id, sizeof(output->trace_id));
+    std::memcpy(output->parent_span_id, trace.context.parent_span_id, sizeof(output->parent_span_id));
+    std::memcpy(output->span_id, trace.context.span_id, sizeof(output->span_id));
+    output->flags = trace.context.flags;
+    return true;
+}
+
+ucall_deferred_t ucall_call_defer(ucall_call_t call) {
+    unum::ucall::automata_t& automata = *reinterpret_cast<unum::ucall::automata_t*>(call);
+    unum::ucall::connection_t& connection = automata.connection;
+
+    // Every call in a batch must be answered before the batch is finalized.
+    if (connection.stage != unum::ucall::stage_t::expecting_reception_k || connection.protocol.is_batch())
+        return nullptr;
+
+    connection.deferred_handoff.store(false, std::memory_order_relaxed);
+    connection.stage = unum::ucall::stage_t::awaiting_deferred_reply_k;
+    return &connection;
+}
+
+void ucall_deferred_reply_content(ucall_server_t punned_server, ucall_deferred_t deferred, ucall_str_t body,
+                                  size_t body_len) {
+    unum::ucall::server_t& server = *reinterpret_cast<unum::ucall::server_t*>(punned_server);
+    unum::ucall::connection_t& connection = *reinterpret_cast<unum::ucall::connection_t*>(deferred);
+    unum::ucall::automata_t automata{server, connection};
+    ucall_call_reply_content(&automata, body, body_len);
+    server.submit_deferred_reply(connection);
+}
+
+void ucall_deferred_reply_error(ucall_server_t punned_server, ucall_deferred_t deferred, int code_int,
+                                ucall_str_t note, size_t note_len) {
+    unum::ucall::server_t& server = *reinterpret_cast<unum::ucall::server_t*>(punned_server);
+    unum::ucall::connection_t& connection = *reinterpret_cast<unum::ucall::connection_t*>(deferred);
+    unum::ucall::automata_t automata{server, connection};
+    ucall_call_reply_error(&automata, code_int, note, note_len);
+    server.submit_deferred_reply(connection);
 }
 
 void ucall_call_reply_content(ucall_call_t call, ucall_str_t body, size_t body_len) {
@@ -80,10 +195,11 @@ void ucall_call_reply_error(ucall_call_t call, int code_int, ucall_str_t note, s
     unum::ucall::connection_t& connection = automata.connection;
 
     note_len = unum::ucall::string_length(note, note_len);
+    connection.reply_error_code = code_int;
     char code[unum::ucall::max_integer_length_k]{};
     std::to_chars_result res = std::to_chars(code, code + unum::ucall::max_integer_length_k, code_int);
     auto code_len = res.ptr - code;
-    if (res.ec != std::error_code())
+    if (res.ec != std::errc())
         return ucall_call_reply_error_unknown(call);
 
     if (!connection.protocol.append_error(connection.pipes, std::string_view(code, code_len),
@@ -0,0 +1,235 @@
+#pragma once
+
+#include "clock.hpp"
+#include "globals.hpp"
+#include "writer.hpp"
+
+#include <fcntl.h>   // `open`
+#include <sys/uio.h> // `writev`
+#include <unistd.h>  // `close`
+
+#include <algorithm>   // `std::min`
+#include <atomic>      // `std::atomic`
+#include <cstdint>     // `std::uint64_t`
+#include <cstring>     // `std::memcpy`
+#include <memory>      // `std::unique_ptr`
+#include <stdio.h>     // `std::snprintf`
+#include <string_view> // `std::string_view`
+
+#include "ucall/ucall.h" // `protocol_type_t`
+
+namespace unum::ucall {
+
+/**
+ * @brief Starts every capture file, identifying the protocol of the requests it contains.
+ */
+struct capture_header_t {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t protocol;
+};
+
+/**
+ * @brief Precedes every request in a capture file, followed by `length` raw bytes.
+ * Timestamps are relative to the start of the capture. Connection IDs are never reused
+ * within one file, even if the server recycles the connection object. Records of different
+ * threads are written in batches, so they are only ordered by time within a thread.
+ */
+struct capture_record_t {
+    std::uint64_t timestamp_ns;
+    std::uint32_t connection_id;
+    std::uint32_t length;
+};
+
+static constexpr char capture_magic_k[8] = {'U', 'C', 'A', 'L', 'L', 'C', 'A', 'P'};
+static constexpr std::uint32_t capture_version_k = 1;
+
+/// @brief Bytes of records queued by every thread, larger requests are never captured.
+static constexpr std::size_t capture_ring_capacity_k = 4 * 1024 * 1024;
+
+/**
+ * @brief Single-producer single-consumer queue of records with their bytes, that may wrap around.
+ * Whatever the consumer reads is already laid out like the file, so it's written without copies.
+ */
+class alignas(64) capture_ring_t {
+    static_assert((capture_ring_capacity_k & (capture_ring_capacity_k - 1)) == 0);
+
+    alignas(64) std::atomic<std::uint64_t> head_{};
+    alignas(64) std::atomic<std::uint64_t> tail_{};
+    std::unique_ptr<char[]> bytes_{};
+
+    void copy_in(std::uint64_t offset, void const* source, std::size_t length) noexcept {
+        std::size_t begin = offset % capture_ring_capacity_k;
+        std::size_t first = (std::min)(length, capture_ring_capacity_k - begin);
+        std::memcpy(bytes_.get() + begin, source, first);
+        std::memcpy(bytes_.get(), static_cast<char const*>(source) + first, length - first);
+    }
+
+  public:
+    bool init() noexcept {
+        bytes_.reset(new (std::nothrow) char[capture_ring_capacity_k]);
+        return bytes_ != nullptr;
+    }
+
+    /// @brief Queues a record from the producer, returning false if it doesn't fit.
+    bool push(capture_record_t const& record, std::string_view request) noexcept {
+        std::uint64_t head = head_.load(std::memory_order_relaxed);
+        std::size_t length = sizeof(record) + request.size();
+        if (capture_ring_capacity_k - (head - tail_.load(std::memory_order_acquire)) < length)
+            return false;
+        copy_in(head, &record, sizeof(record));
+        copy_in(head + sizeof(record), request.data(), request.size());
+        head_.store(head + length, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Exports the queued bytes as up to two parts, returning their total length.
+    std::size_t peek(iovec* parts, std::size_t& parts_count) noexcept {
+        std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t length = head_.load(std::memory_order_acquire) - tail;
+        std::size_t begin = tail % capture_ring_capacity_k;
+        std::size_t first = (std::min)(length, capture_ring_capacity_k - begin);
+        if (first)
+            parts[parts_count++] = {bytes_.get() + begin, first};
+        if (length - first)
+            parts[parts_count++] = {bytes_.get(), length - first};
+        return length;
+    }
+
+    void pop(std::size_t length) noexcept {
+        tail_.store(tail_.load(std::memory_order_relaxed) + length, std::memory_order_release);
+    }
+};
+
+/**
+ * @brief Appends every complete request, as the server has seen it after decryption, to a binary log.
+ * Polling threads only copy the request into their own ring, and a background thread appends all of them
+ * with a single `writev`. If it falls behind, requests are dropped and counted in the periodic logs.
+ */
+class capture_log_t {
+    int file_descriptor_{-1};
+    std::uint64_t start_ns_{};
+    std::atomic<std::uint32_t> next_connection_id_{};
+    std::unique_ptr<capture_ring_t[]> rings_{};
+    /// @brief Only accessed by the background thread: two parts per ring, and the bytes they span.
+    std::unique_ptr<iovec[]> parts_{};
+    std::unique_ptr<std::size_t[]> exported_{};
+    std::size_t rings_count_{};
+    std::atomic<std::size_t> dropped_{};
+    std::size_t logged_dropped_{};
+    background_writer_t writer_{};
+
+    bool drain() noexcept {
+        std::size_t parts_count = 0;
+        bool found = false;
+        for (std::size_t thread_idx = 0; thread_idx != rings_count_; ++thread_idx)
+            found |= (exported_[thread_idx] = rings_[thread_idx].peek(parts_.get(), parts_count)) != 0;
+        if (!found)
+            return false;
+        // Rings are only released after the write, so producers never overwrite the exported bytes.
+        [[maybe_unused]] ssize_t written = writev(file_descriptor_, parts_.get(), static_cast<int>(parts_count));
+        for (std::size_t thread_idx = 0; thread_idx != rings_count_; ++thread_idx)
+            rings_[thread_idx].pop(exported_[thread_idx]);
+        return true;
+    }
+
+  public:
+    capture_log_t() = default;
+    capture_log_t(capture_log_t const&) = delete;
+    capture_log_t& operator=(capture_log_t const&) = delete;
+    ~capture_log_t() noexcept {
+        writer_.stop();
+        if (file_descriptor_ >= 0)
+            close(file_descriptor_);
+    }
+
+    int open(char const* path, protocol_type_t protocol, std::size_t threads_count) noexcept {
+        rings_.reset(new (std::nothrow) capture_ring_t[threads_count]);
+        parts_.reset(new (std::nothrow) iovec[threads_count * 2]);
+        exported_.reset(new (std::nothrow) std::size_t[threads_count]);
+        if (!rings_ || !parts_ || !exported_)
+            return -1;
+        for (std::size_t thread_idx = 0; thread_idx != threads_count; ++thread_idx)
+            if (!rings_[thread_idx].init())
+                return -1;
+        rings_count_ = threads_count;
+
+        file_descriptor_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        if (file_descriptor_ < 0)
+            return -1;
+        capture_header_t header{};
+        std::memcpy(header.magic, capture_magic_k, sizeof(capture_magic_k));
+        header.version = capture_version_k;
+        header.protocol = static_cast<std::uint32_t>(protocol);
+        if (write(file_descriptor_, &header, sizeof(header)) != sizeof(header))
+            return -1;
+        start_ns_ = cycle_clock_t::now_ns();
+        writer_.start([this] { return drain(); });
+        return 0;
+    }
+
+    std::uint32_t next_connection_id() noexcept {
+        return next_connection_id_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record(std::size_t thread_idx, std::uint32_t connection_id, std::string_view request) noexcept {
+        capture_record_t record{cycle_clock_t::now_ns() - start_ns_, connection_id,
+                                static_cast<std::uint32_t>(request.size())};
+        if (!rings_[thread_idx].push(record, request))
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// @brief Prints the requests dropped since the previous call, or nothing if there were none.
+    std::size_t log_human_readable(char* buffer, std::size_t buffer_capacity) noexcept {
+        std::size_t dropped = collect_dropped();
+        if (!dropped)
+            return 0;
+        auto len = snprintf(buffer, buffer_capacity, "capture: dropped %zu requests. \n", dropped);
+        return len < 0 ? 0 : (std::min)(static_cast<std::size_t>(len), buffer_capacity - 1);
+    }
+
+    /// @brief Prints the requests dropped since the previous call as a `,"capture":{...}` member, or nothing.
+    std::size_t log_json(char* buffer, std::size_t buffer_capacity) noexcept {
+        std::size_t dropped = collect_dropped();
+        if (!dropped)
+            return 0;
+        auto len = snprintf(buffer, buffer_capacity, R"(,"capture":{"dropped":%zu})", dropped);
+        return len < 0 ? 0 : (std::min)(static_cast<std::size_t>(len), buffer_capacity - 1);
+    }
+
+  private:
+    std::size_t collect_dropped() noexcept {
+        std::size_t dropped = dropped_.load(std::memory_order_relaxed);
+        std::size_t since = dropped - logged_dropped_;
+        logged_dropped_ = dropped;
+        return since;
+    }
+};
+
+/**
+ * @brief Walks a capture loaded into memory, calling @p callback with every record and its bytes.
+ * @return False if the header is malformed, or the file is truncated mid-record.
+ */
+template <typename callback_at>
+bool for_each_captured(std::string_view file, capture_header_t& header, callback_at&& callback) noexcept {
+    if (file.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, capture_magic_k, sizeof(capture_magic_k)) != 0 ||
+        header.version != capture_version_k)
+        return false;
+
+    std::size_t offset = sizeof(header);
+    while (offset + sizeof(capture_record_t) <= file.size()) {
+        capture_record_t record;
+        std::memcpy(&record, file.data() + offset, sizeof(record));
+        offset += sizeof(record);
+        if (offset + record.length > file.size())
+            return false;
+        callback(record, file.substr(offset, record.length));
+        offset += record.length;
+    }
+    return offset == file.size();
+}
+
+} // namespace unum::ucall
@@ -0,0 +1,798 @@
+/**
+ * @file client.cpp
+ * @brief JSON-RPC client, implementing `ucall/client.h`.
+ *
+ * Every exchange locks a few idle connections from the pool and runs entirely on the calling
+ * thread. Requests are framed with `iovec`s, pointing straight into the caller's memory,
+ * and the connections are multiplexed with `poll`, as a blocking client only ever waits
+ * on a handful of its own sockets.
+ */
+#include <netdb.h>       // `getaddrinfo`
+#include <netinet/in.h>  // `IPPROTO_TCP`
+#include <netinet/tcp.h> // `TCP_NODELAY`
+#include <poll.h>        // `poll`
+#include <sys/socket.h>  // `sendmsg`, `recv`
+#include <sys/uio.h>     // `iovec`
+#include <time.h>        // `clock_gettime`
+#include <unistd.h>      // `close`
+
+#include <atomic>       // `std::atomic`
+#include <cassert>      // `assert`
+#include <cerrno>       // `errno`
+#include <charconv>     // `std::to_chars`
+#include <mutex>        // `std::mutex`
+#include <system_error> // `std::errc`
+
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <picohttpparser.h>
+#include <picotls.h>
+#include <picotls/openssl.h>
+
+#include "ucall/client.h"
+
+#include "containers.hpp"
+#include "shared.hpp"
+
+using namespace unum::ucall;
+
+/// @brief Bytes requested from the socket per `recv`.
+static constexpr std::size_t read_chunk_k = 64 * 1024;
+/// @brief Max requests submitted with a single `sendmsg`.
+static constexpr std::size_t max_iovecs_k = 64;
+/// @brief Max connections a single exchange can multiplex.
+static constexpr std::size_t max_parallelism_k = 64;
+static constexpr std::size_t max_hostname_length_k = 256;
+static constexpr std::size_t max_http_headers_k = 32;
+static constexpr char tcp_termination_symbol_k = '\0';
+
+static std::uint64_t monotonic_micro_seconds() noexcept {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1'000'000ull + ts.tv_nsec / 1'000;
+}
+
+/**
+ * @brief Request submitted into a connection. Its bytes are the concatenation of the `head`,
+ * stored in the connection framing buffer, the `body` and the optional TCP terminator.
+ * The body is either in caller's memory, or, for batches, in the framing buffer too.
+ */
+struct queued_request_t {
+    std::size_t request_idx{};
+    std::size_t head_offset{};
+    std::size_t head_length{};
+    char const* body{};
+    std::size_t body_offset{};
+    std::size_t body_length{};
+    bool body_is_framed{};
+    bool is_terminated{};
+
+    std::size_t length() const noexcept { return head_length + body_length + is_terminated; }
+};
+
+/**
+ * @brief State shared by all the connections participating in one exchange.
+ */
+struct exchange_t {
+    ucall_str_t const* requests{};
+    std::size_t const* requests_lengths{};
+    std::size_t requests_count{};
+    /// @brief Set for batches, where all requests are joined into a single array.
+    bool is_batch{};
+
+    ucall_client_reply_t callback{};
+    void* user_data{};
+    std::size_t next_request{};
+    std::size_t completed{};
+    std::uint64_t deadline{};
+
+    std::size_t submissions_count() const noexcept { return is_batch ? 1 : requests_count; }
+    void complete(std::size_t request_idx, int error, char const* reply, std::size_t reply_length) noexcept {
+        completed++;
+        callback(user_data, request_idx, error, reply, reply_length);
+    }
+};
+
+struct client_t;
+
+/**
+ * @brief Connection that is reused across exchanges, guarded by its own mutex.
+ * Between exchanges it holds no pending requests and no buffered input, as any
+ * interrupted exchange closes the socket to avoid mixing up the replies.
+ */
+struct client_connection_t {
+    std::mutex mutex;
+    int descriptor = -1;
+
+    /// @brief HTTP headers and joined batches of the queued requests.
+    array_gt<char> framing;
+    /// @brief Requests submitted into this connection, in order. Replies arrive in the same order.
+    array_gt<queued_request_t> queue;
+    std::size_t queue_replied = 0;
+    std::size_t queue_sent = 0;
+    /// @brief Number of bytes of `queue[queue_sent]` already sent, or of `encrypted` with TLS.
+    std::size_t partially_sent = 0;
+
+    /// @brief Received plain-text bytes, that may contain several replies.
+    array_gt<char> input;
+    std::size_t input_consumed = 0;
+
+    ptls_t* tls_context{};
+    /// @brief Encrypted outgoing bytes, that haven't been sent yet.
+    array_gt<char> encrypted;
+
+    std::size_t in_flight() const noexcept { return queue.size() - queue_replied; }
+    void reset_queue() noexcept {
+        queue.pop_back(queue.size());
+        framing.pop_back(framing.size());
+        encrypted.pop_back(encrypted.size());
+        queue_replied = queue_sent = partially_sent = 0;
+    }
+    void close_socket() noexcept {
+        if (descriptor >= 0)
+            ::close(descriptor);
+        descriptor = -1;
+        input.pop_back(input.size());
+        input_consumed = 0;
+        if (tls_context)
+            ptls_free(tls_context);
+        tls_context = nullptr;
+    }
+};
+
+struct client_t {
+    ucall_client_config_t config{};
+    char hostname[max_hostname_length_k]{};
+    sockaddr_storage address{};
+    socklen_t address_length{};
+    buffer_gt<client_connection_t> connections;
+    std::atomic<std::size_t> connections_rotation{};
+
+    bool use_http{};
+    /// @brief The constant part of the HTTP header, up to the "Content-Length" value.
+    char http_head[max_hostname_length_k + 128]{};
+    std::size_t http_head_length{};
+
+    bool ssl{};
+    ptls_context_t ssl_context{};
+    ptls_openssl_verify_certificate_t verify_certificate{};
+    bool verify_certificate_initialized{};
+};
+
+#pragma region Framing
+
+/**
+ * @brief Appends the HTTP header for a body of @p body_length bytes to the framing buffer.
+ * @return Offset of the header in the framing buffer, or `SIZE_MAX` if the allocation failed.
+ */
+static std::size_t print_http_head(client_t& client, client_connection_t& connection,
+                                   std::size_t body_length) noexcept {
+    std::size_t offset = connection.framing.size();
+    char* head = connection.framing.extend(client.http_head_length + max_integer_length_k + 4);
+    if (!head)
+        return SIZE_MAX;
+    std::memcpy(head, client.http_head, client.http_head_length);
+    char* length_end = head + client.http_head_length;
+    length_end = std::to_chars(length_end, length_end + max_integer_length_k, body_length).ptr;
+    std::memcpy(length_end, "\r\n\r\n", 4);
+    connection.framing.pop_back(max_integer_length_k - (length_end - (head + client.http_head_length)));
+    return offset;
+}
+
+/**
+ * @brief Frames the next request of the @p exchange and appends it to the connection queue.
+ */
+static bool enqueue_request(client_t& client, exchange_t& exchange, client_connection_t& connection) noexcept {
+    queued_request_t* queued = connection.queue.extend(1);
+    if (!queued)
+        return false;
+    *queued = queued_request_t{};
+    queued->request_idx = exchange.next_request;
+
+    if (!exchange.is_batch) {
+        queued->body = exchange.requests[exchange.next_request];
+        queued->body_length = string_length(queued->body, exchange.requests_lengths[exchange.next_request]);
+    } else {
+        // Joining the batch is the only copy the client makes.
+        std::size_t batch_length = exchange.requests_count + 1;
+        for (std::size_t i = 0; i != exchange.requests_count; ++i)
+            batch_length += string_length(exchange.requests[i], exchange.requests_lengths[i]);
+        queued->body_offset = connection.framing.size();
+        queued->body_length = batch_length;
+        queued->body_is_framed = true;
+        char* batch = connection.framing.extend(batch_length);
+        if (!batch) {
+            connection.queue.pop_back();
+            return false;
+        }
+        for (std::size_t i = 0; i != exchange.requests_count; ++i) {
+            *batch++ = i ? ',' : '[';
+            std::size_t length = string_length(exchange.requests[i], exchange.requests_lengths[i]);
+            std::memcpy(batch, exchange.requests[i], length);
+            batch += length;
+        }
+        *batch = ']';
+    }
+
+    if (client.use_http) {
+        queued->head_offset = print_http_head(client, connection, queued->body_length);
+        if (queued->head_offset == SIZE_MAX) {
+            connection.queue.pop_back();
+            return false;
+        }
+        queued->head_length = connection.framing.size() - queued->head_offset;
+    } else
+        queued->is_terminated = true;
+    exchange.next_request++;
+    return true;
+}
+
+/**
+ * @brief Exports the unsent bytes of a queued request as up to 3 `iovec`s.
+ */
+static std::size_t export_iovecs(client_connection_t& connection, queued_request_t const& queued,
+                                 std::size_t skipped, iovec* iovecs) noexcept {
+    // Framed parts are addressed by offsets, as the framing buffer may have been reallocated.
+    struct segment_t {
+        char const* data;
+        std::size_t length;
+    } segments[3] = {
+        {connection.framing.data() + queued.head_offset, queued.head_length},
+        {queued.body_is_framed ? connection.framing.data() + queued.body_offset : queued.body, queued.body_length},
+        {&tcp_termination_symbol_k, queued.is_terminated},
+    };
+    std::size_t count = 0;
+    for (segment_t segment : segments) {
+        if (skipped >= segment.length) {
+            skipped -= segment.length;
+            continue;
+        }
+        iovecs[count].iov_base = (void*)(segment.data + skipped);
+        iovecs[count].iov_len = segment.length - skipped;
+        skipped = 0;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Locates the first complete reply in @p input.
+ * @return Length of the whole frame, zero if more bytes are needed, or `SIZE_MAX` if the reply is malformed.
+ */
+static std::size_t find_reply(bool use_http, std::string_view input, std::string_view& body) noexcept {
+    if (!use_http) {
+        std::size_t terminator = input.find(tcp_termination_symbol_k);
+        if (terminator == std::string_view::npos)
+            return 0;
+        body = input.substr(0, terminator);
+        return terminator + 1;
+    }
+
+    int minor_version, status;
+    char const* message;
+    std::size_t message_length;
+    phr_header headers[max_http_headers_k];
+    std::size_t headers_count = max_http_headers_k;
+    int headers_length = phr_parse_response(input.data(), input.size(), &minor_version, &status, &message,
+                                            &message_length, headers, &headers_count, 0);
+    if (headers_length == -2)
+        return 0;
+    if (headers_length < 0)
+        return SIZE_MAX;
+
+    constexpr std::string_view content_length_k = "content-length";
+    std::size_t content_length = SIZE_MAX;
+    for (std::size_t i = 0; i != headers_count; ++i) {
+        std::string_view name{headers[i].name, headers[i].name_len};
+        if (name.size() != content_length_k.size())
+            continue;
+        bool matches = true;
+        for (std::size_t j = 0; j != name.size() && matches; ++j)
+            matches = (name[j] | 0x20) == content_length_k[j];
+        if (matches && std::from_chars(headers[i].value, headers[i].value + headers[i].value_len, content_length).ec !=
+                           std::errc())
+            return SIZE_MAX;
+    }
+    if (content_length == SIZE_MAX)
+        return SIZE_MAX;
+
+    std::size_t frame_length = headers_length + content_length;
+    if (input.size() < frame_length)
+        return 0;
+    body = input.substr(headers_length, content_length);
+    return frame_length;
+}
+
+#pragma endregion Framing
+
+#pragma region Transport
+
+/**
+ * @brief Waits for the socket to become readable or writable until the @p deadline.
+ * @return Zero on success, or `ETIMEDOUT`.
+ */
+static int wait_for(int descriptor, short events, std::uint64_t deadline) noexcept {
+    pollfd polled{descriptor, events, 0};
+    while (true) {
+        std::uint64_t now = monotonic_micro_seconds();
+        if (now >= deadline)
+            return ETIMEDOUT;
+        int ready = poll(&polled, 1, static_cast<int>((deadline - now + 999) / 1000));
+        if (ready > 0)
+            return 0;
+        if (ready < 0 && errno != EINTR)
+            return errno;
+    }
+}
+
+static int send_all(int descriptor, char const* data, std::size_t length, std::uint64_t deadline) noexcept {
+    while (length) {
+        ssize_t sent = send(descriptor, data, length, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent > 0) {
+            data += sent, length -= sent;
+            continue;
+        }
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            return errno;
+        if (int error = wait_for(descriptor, POLLOUT, deadline); error)
+            return error;
+    }
+    return 0;
+}
+
+/**
+ * @brief Decrypts @p length received bytes into the plain-text input of the connection.
+ * @return Zero on success, or `EPROTO`.
+ */
+static int decrypt_input(client_connection_t& connection, char const* data, std::size_t length) noexcept {
+    std::uint8_t small_buffer[ram_page_size_k];
+    ptls_buffer_t decrypted;
+    ptls_buffer_init(&decrypted, small_buffer, sizeof(small_buffer));
+    int result = 0;
+    while (length && result == 0) {
+        std::size_t consumed = length;
+        result = ptls_receive(connection.tls_context, &decrypted, data, &consumed);
+        data += consumed, length -= consumed;
+    }
+    bool appended = result == 0 && connection.input.append_n((char const*)decrypted.base, decrypted.off);
+    ptls_buffer_dispose(&decrypted);
+    return result != 0 ? EPROTO : appended ? 0 : ENOMEM;
+}
+
+/**
+ * @brief Performs a blocking TLS 1.3 handshake on a freshly connected socket.
+ * @return Zero on success, or the `errno` of the failure.
+ */
+static int handshake(client_t& client, client_connection_t& connection, std::uint64_t deadline) noexcept {
+    connection.tls_context = ptls_new(&client.ssl_context, 0);
+    if (!connection.tls_context)
+        return ENOMEM;
+    ptls_set_server_name(connection.tls_context, client.hostname, 0);
+
+    std::uint8_t small_buffer[ram_page_size_k];
+    ptls_buffer_t outgoing;
+    ptls_buffer_init(&outgoing, small_buffer, sizeof(small_buffer));
+    char incoming[read_chunk_k / 4];
+    int error = 0;
+    int result = ptls_handshake(connection.tls_context, &outgoing, nullptr, nullptr, nullptr);
+    while (result == PTLS_ERROR_IN_PROGRESS && !error) {
+        error = send_all(connection.descriptor, (char const*)outgoing.base, outgoing.off, deadline);
+        outgoing.off = 0;
+        if (error || (error = wait_for(connection.descriptor, POLLIN, deadline)))
+            break;
+        ssize_t received = recv(connection.descriptor, incoming, sizeof(incoming), MSG_DONTWAIT);
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            error = received == 0 ? ECONNRESET : errno;
+            break;
+        }
+        std::size_t offset = 0;
+        while (received > 0 && offset != static_cast<std::size_t>(received) && result == PTLS_ERROR_IN_PROGRESS) {
+            std::size_t consumed = received - offset;
+            result = ptls_handshake(connection.tls_context, &outgoing, incoming + offset, &consumed, nullptr);
+            offset += consumed;
+        }
+        // The server may have sent some application data right after the handshake.
+        if (result == 0 && received > 0 && offset != static_cast<std::size_t>(received))
+            error = decrypt_input(connection, incoming + offset, received - offset);
+    }
+    if (!error && result == 0 && outgoing.off)
+        error = send_all(connection.descriptor, (char const*)outgoing.base, outgoing.off, deadline);
+    ptls_buffer_dispose(&outgoing);
+    return error ? error : result == 0 ? 0 : ECONNABORTED;
+}
+
+/**
+ * @brief Makes sure the connection is alive, reconnecting if the server has closed it.
+ * @return Zero on success, or the `errno` of the failed connection attempt.
+ */
+static int prepare_connection(client_t& client, client_connection_t& connection, std::uint64_t deadline) noexcept {
+    connection.reset_queue();
+    if (connection.descriptor >= 0) {
+        char probe;
+        ssize_t peeked = recv(connection.descriptor, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+        // Unsolicited data would be mistaken for the next reply, so we drop such connections too.
+        if (peeked < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 0;
+        connection.close_socket();
+    }
+
+    int descriptor = socket(client.address.ss_family, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
+    if (descriptor < 0)
+        return errno;
+    int no_delay = 1;
+    setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    connection.descriptor = descriptor;
+
+    int error = 0;
+    if (connect(descriptor, (sockaddr const*)&client.address, client.address_length) != 0) {
+        error = errno == EINPROGRESS ? wait_for(descriptor, POLLOUT, deadline) : errno;
+        socklen_t error_length = sizeof(error);
+        if (!error)
+            getsockopt(descriptor, SOL_SOCKET, SO_ERROR, &error, &error_length);
+    }
+    if (!error && client.ssl)
+        error = handshake(client, connection, deadline);
+    if (error)
+        connection.close_socket();
+    return error;
+}
+
+/**
+ * @brief Submits as many queued requests as the socket accepts.
+ * @return Zero on success, or the `errno` of the failure.
+ */
+static int send_queued(client_connection_t& connection) noexcept {
+    if (connection.tls_context) {
+        // Encrypt everything queued so far, and keep sending until the encrypted buffer drains.
+        if (connection.partially_sent == connection.encrypted.size()) {
+            connection.encrypted.pop_back(connection.encrypted.size());
+            connection.partially_sent = 0;
+        }
+        for (; connection.queue_sent != connection.queue.size(); ++connection.queue_sent) {
+            iovec iovecs[3];
+            std::size_t count = export_iovecs(connection, connection.queue[connection.queue_sent], 0, iovecs);
+            std::uint8_t small_buffer[ram_page_size_k];
+            ptls_buffer_t encrypted;
+            ptls_buffer_init(&encrypted, small_buffer, sizeof(small_buffer));
+            int result = 0;
+            for (std::size_t i = 0; i != count && result == 0; ++i)
+                result = ptls_send(connection.tls_context, &encrypted, iovecs[i].iov_base, iovecs[i].iov_len);
+            bool appended = result == 0 && connection.encrypted.append_n((char const*)encrypted.base, encrypted.off);
+            ptls_buffer_dispose(&encrypted);
+            if (!appended)
+                return result ? EPROTO : ENOMEM;
+        }
+        ssize_t sent = send(connection.descriptor, connection.encrypted.data() + connection.partially_sent,
+                            connection.encrypted.size() - connection.partially_sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : errno;
+        connection.partially_sent += sent;
+        return 0;
+    }
+
+    iovec iovecs[max_iovecs_k];
+    std::size_t count = 0;
+    for (std::size_t i = connection.queue_sent; i != connection.queue.size() && count + 3 <= max_iovecs_k; ++i) {
+        std::size_t skipped = i == connection.queue_sent ? connection.partially_sent : 0;
+        count += export_iovecs(connection, connection.queue[i], skipped, iovecs + count);
+    }
+
+    msghdr message{};
+    message.msg_iov = iovecs;
+    message.msg_iovlen = count;
+    ssize_t sent = sendmsg(connection.descriptor, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : errno;
+
+    std::size_t remaining = static_cast<std::size_t>(sent) + connection.partially_sent;
+    while (connection.queue_sent != connection.queue.size()) {
+        std::size_t length = connection.queue[connection.queue_sent].length();
+        if (remaining < length)
+            break;
+        remaining -= length;
+        connection.queue_sent++;
+    }
+    connection.partially_sent = remaining;
+    return 0;
+}
+
+static bool has_unsent(client_connection_t const& connection) noexcept {
+    return connection.queue_sent != connection.queue.size() ||
+           connection.partially_sent != connection.encrypted.size();
+}
+
+/**
+ * @brief Receives the next chunk and passes all the complete replies into the callback.
+ * @return Zero on success, or the `errno` of the failure.
+ */
+static int receive_replies(client_t& client, exchange_t& exchange, client_connection_t& connection) noexcept {
+    ssize_t received;
+    if (connection.tls_context) {
+        char chunk[read_chunk_k / 4];
+        received = recv(connection.descriptor, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (received > 0)
+            if (int error = decrypt_input(connection, chunk, received); error)
+                return error;
+    } else {
+        char* chunk = connection.input.extend(read_chunk_k);
+        if (!chunk)
+            return ENOMEM;
+        received = recv(connection.descriptor, chunk, read_chunk_k, MSG_DONTWAIT);
+        connection.input.pop_back(received > 0 ? read_chunk_k - received : read_chunk_k);
+    }
+    if (received == 0)
+        return ECONNRESET;
+    if (received < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : errno;
+
+    while (connection.queue_replied != connection.queue.size()) {
+        std::string_view input{connection.input.data() + connection.input_consumed,
+                               connection.input.size() - connection.input_consumed};
+        std::string_view body;
+        std::size_t frame_length = find_reply(client.use_http, input, body);
+        if (frame_length == 0)
+            break;
+        if (frame_length == SIZE_MAX)
+            return EPROTO;
+        connection.input_consumed += frame_length;
+        std::size_t request_idx = connection.queue[connection.queue_replied++].request_idx;
+        exchange.complete(request_idx, 0, body.data(), body.size());
+    }
+
+    // Compact the input buffer, once all the received replies are consumed.
+    if (connection.input_consumed == connection.input.size())
+        connection.input.pop_back(connection.input.size()), connection.input_consumed = 0;
+    else if (connection.queue_replied == connection.queue.size())
+        return EPROTO;
+    return 0;
+}
+
+/**
+ * @brief Reports all the requests still pending on @p connection as failed and closes it.
+ */
+static void fail_connection(exchange_t& exchange, client_connection_t& connection, int error) noexcept {
+    for (std::size_t i = connection.queue_replied; i != connection.queue.size(); ++i)
+        exchange.complete(connection.queue[i].request_idx, error, nullptr, 0);
+    connection.queue_replied = connection.queue_sent = connection.queue.size();
+    connection.close_socket();
+}
+
+/**
+ * @brief Distributes the requests of @p exchange across the acquired @p connections, keeping up to
+ * `pipeline_depth` requests in flight on each of them, until every request is replied or fails.
+ */
+static void run_exchange(client_t& client, exchange_t& exchange, client_connection_t** connections,
+                         std::size_t connections_count) noexcept {
+    std::size_t submissions_count = exchange.submissions_count();
+    std::size_t alive = 0;
+    int last_error = ECONNREFUSED;
+    for (std::size_t i = 0; i != connections_count; ++i) {
+        int error = prepare_connection(client, *connections[i], exchange.deadline);
+        if (error)
+            last_error = error;
+        else
+            alive++;
+    }
+
+    pollfd descriptors[max_parallelism_k];
+    std::size_t polled_connections[max_parallelism_k];
+    while (exchange.completed != submissions_count && alive) {
+
+        // Top up the pipelines of all the alive connections.
+        std::size_t polled_count = 0;
+        for (std::size_t i = 0; i != connections_count; ++i) {
+            client_connection_t& connection = *connections[i];
+            if (connection.descriptor < 0)
+                continue;
+            while (connection.in_flight() < client.config.pipeline_depth &&
+                   exchange.next_request != submissions_count)
+                if (!enqueue_request(client, exchange, connection))
+                    break;
+            if (!connection.in_flight())
+                continue;
+            descriptors[polled_count].fd = connection.descriptor;
+            descriptors[polled_count].events = POLLIN | (has_unsent(connection) ? POLLOUT : 0);
+            descriptors[polled_count].revents = 0;
+            polled_connections[polled_count++] = i;
+        }
+
+        std::uint64_t now = monotonic_micro_seconds();
+        int ready = now < exchange.deadline && polled_count
+                        ? poll(descriptors, polled_count, static_cast<int>((exchange.deadline - now + 999) / 1000))
+                        : 0;
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready <= 0) {
+            last_error = ready == 0 ? (polled_count ? ETIMEDOUT : ENOMEM) : errno;
+            for (std::size_t i = 0; i != connections_count; ++i)
+                if (connections[i]->descriptor >= 0 && connections[i]->in_flight())
+                    fail_connection(exchange, *connections[i], last_error);
+            break;
+        }
+
+        for (std::size_t i = 0; i != polled_count; ++i) {
+            client_connection_t& connection = *connections[polled_connections[i]];
+            short events = descriptors[i].revents;
+            int error = 0;
+            if (events & POLLOUT)
+                error = send_queued(connection);
+            if (!error && (events & (POLLIN | POLLHUP | POLLERR)))
+                error = receive_replies(client, exchange, connection);
+            if (error)
+                last_error = error, fail_connection(exchange, connection, error), alive--;
+        }
+    }
+
+    // Requests that never got a connection share the last observed failure.
+    for (; exchange.next_request != submissions_count; ++exchange.next_request)
+        exchange.complete(exchange.next_request, last_error, nullptr, 0);
+}
+
+/**
+ * @brief Locks up to @p wanted connections, skipping the busy ones, but blocking on at least one.
+ */
+static std::size_t acquire_connections(client_t& client, client_connection_t** acquired,
+                                       std::size_t wanted) noexcept {
+    std::size_t pool_size = client.connections.size();
+    wanted = (std::min)((std::max)(wanted, std::size_t(1)), (std::min)(pool_size, max_parallelism_k));
+    std::size_t first = client.connections_rotation.fetch_add(1, std::memory_order_relaxed);
+    std::size_t count = 0;
+    for (std::size_t i = 0; i != pool_size && count != wanted; ++i) {
+        client_connection_t& connection = client.connections[(first + i) % pool_size];
+        if (connection.mutex.try_lock())
+            acquired[count++] = &connection;
+    }
+    if (!count) {
+        client_connection_t& connection = client.connections[first % pool_size];
+        connection.mutex.lock();
+        acquired[count++] = &connection;
+    }
+    return count;
+}
+
+static void exchange(client_t& client, exchange_t& exchange, uint32_t timeout_micro_seconds) noexcept {
+    std::uint32_t timeout = timeout_micro_seconds ? timeout_micro_seconds : client.config.timeout_micro_seconds;
+    exchange.deadline = monotonic_micro_seconds() + timeout;
+    std::size_t submissions = exchange.submissions_count();
+    std::size_t parallelism = (submissions + client.config.pipeline_depth - 1) / client.config.pipeline_depth;
+    client_connection_t* acquired[max_parallelism_k];
+    std::size_t count = acquire_connections(client, acquired, parallelism);
+    run_exchange(client, exchange, acquired, count);
+    for (std::size_t i = 0; i != count; ++i)
+        acquired[i]->mutex.unlock();
+}
+
+#pragma endregion Transport
+
+#pragma region C Interface Implementation
+
+void ucall_client_init(ucall_client_config_t* config_inout, ucall_client_t* client_out) {
+
+    assert(client_out != nullptr);
+    assert(config_inout != nullptr);
+
+    ucall_client_config_t& config = *config_inout;
+    *client_out = nullptr;
+
+    // Specify defaults if they are missing
+    if (!config.hostname)
+        config.hostname = "127.0.0.1";
+    if (config.port == 0)
+        config.port = 8545u;
+    if (config.protocol != jsonrpc_tcp_k)
+        config.protocol = jsonrpc_http_k;
+    if (config.max_connections == 0)
+        config.max_connections = 4u;
+    if (config.pipeline_depth == 0)
+        config.pipeline_depth = 16u;
+    if (config.timeout_micro_seconds == 0)
+        config.timeout_micro_seconds = 10'000'000u;
+    if (std::strlen(config.hostname) >= max_hostname_length_k)
+        return;
+
+    // Allocate the client itself
+    client_t* client_ptr = new (std::nothrow) client_t();
+    if (!client_ptr)
+        return;
+    client_t& client = *client_ptr;
+    client.config = config;
+    std::strcpy(client.hostname, config.hostname);
+    client.config.hostname = client.hostname;
+    client.use_http = config.protocol == jsonrpc_http_k;
+    client.http_head_length = std::snprintf( //
+        client.http_head, sizeof(client.http_head),
+        "POST / HTTP/1.1\r\nHost: %s:%u\r\nContent-Type: application/json\r\nContent-Length: ", client.hostname,
+        config.port);
+
+    // Resolve the address
+    addrinfo hints{};
+    addrinfo* resolved = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    char port[8];
+    std::snprintf(port, sizeof(port), "%u", config.port);
+    if (getaddrinfo(client.hostname, port, &hints, &resolved) != 0 || !resolved)
+        goto cleanup;
+    std::memcpy(&client.address, resolved->ai_addr, resolved->ai_addrlen);
+    client.address_length = resolved->ai_addrlen;
+    freeaddrinfo(resolved);
+
+    if (!client.connections.resize(config.max_connections))
+        goto cleanup;
+
+    if (config.ssl) {
+        client.ssl = true;
+        client.ssl_context.random_bytes = ptls_openssl_random_bytes;
+        client.ssl_context.get_time = &ptls_get_time;
+        client.ssl_context.key_exchanges = ptls_openssl_key_exchanges;
+        client.ssl_context.cipher_suites = ptls_openssl_cipher_suites;
+        if (!config.ssl_allow_self_signed) {
+            X509_STORE* store = nullptr;
+            if (config.ssl_certificate_authorities_path) {
+                store = X509_STORE_new();
+                if (!store || X509_STORE_load_locations(store, config.ssl_certificate_authorities_path, nullptr) != 1) {
+                    X509_STORE_free(store);
+                    goto cleanup;
+                }
+            }
+            // Without a custom store, the default system paths are used.
+            if (ptls_openssl_init_verify_certificate(&client.verify_certificate, store) != 0)
+                goto cleanup;
+            client.verify_certificate_initialized = true;
+            client.ssl_context.verify_certificate = &client.verify_certificate.super;
+        }
+    }
+
+    *client_out = (ucall_client_t)client_ptr;
+    return;
+
+cleanup:
+    ucall_client_free((ucall_client_t)client_ptr);
+}
+
+void ucall_client_free(ucall_client_t client_ptr) {
+    if (!client_ptr)
+        return;
+    client_t& client = *reinterpret_cast<client_t*>(client_ptr);
+    for (client_connection_t& connection : client.connections)
+        connection.close_socket();
+    if (client.verify_certificate_initialized)
+        ptls_openssl_dispose_verify_certificate(&client.verify_certificate);
+    delete &client;
+}
+
+void ucall_client_call(ucall_client_t client, ucall_str_t request, size_t request_length,
+                       uint32_t timeout_micro_seconds, ucall_client_reply_t callback, void* user_data) {
+    ucall_client_call_many(client, &request, &request_length, 1, timeout_micro_seconds, callback, user_data);
+}
+
+void ucall_client_call_many(ucall_client_t client, ucall_str_t const* requests, size_t const* requests_lengths,
+                            size_t requests_count, uint32_t timeout_micro_seconds, ucall_client_reply_t callback,
+                            void* user_data) {
+    if (!requests_count)
+        return;
+    exchange_t state;
+    state.requests = requests;
+    state.requests_lengths = requests_lengths;
+    state.requests_count = requests_count;
+    state.callback = callback;
+    state.user_data = user_data;
+    exchange(*reinterpret_cast<client_t*>(client), state, timeout_micro_seconds);
+}
+
+void ucall_client_batch(ucall_client_t client, ucall_str_t const* requests, size_t const* requests_lengths,
+                        size_t requests_count, uint32_t timeout_micro_seconds, ucall_client_reply_t callback,
+                        void* user_data) {
+    if (!requests_count)
+        return;
+    exchange_t state;
+    state.requests = requests;
+    state.requests_lengths = requests_lengths;
+    state.requests_count = requests_count;
+    state.is_batch = true;
+    state.callback = callback;
+    state.user_data = user_data;
+    exchange(*reinterpret_cast<client_t*>(client), state, timeout_micro_seconds);
+}
+
+#pragma endregion C Interface Implementation
@@ -0,0 +1,132 @@
+#pragma once
+
+// The 128-bit arithmetic for scaling the counter is only available in GCC and Clang.
+#if defined(__x86_64__) && !defined(_MSC_VER)
+#define UCALL_HAS_CYCLE_COUNTER
+#include <cpuid.h>     // `__get_cpuid`
+#include <x86intrin.h> // `__rdtsc`
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+#define UCALL_HAS_CYCLE_COUNTER
+#endif
+
+#include <atomic>  // `std::atomic`
+#include <chrono>  // `std::chrono::steady_clock`, `std::chrono::system_clock`
+#include <cstddef> // `std::size_t`
+#include <cstdint> // `std::uint64_t`
+#include <mutex>   // `std::call_once`
+#include <thread>  // `std::this_thread::sleep_for`
+
+namespace unum::ucall {
+
+#if defined(UCALL_HAS_CYCLE_COUNTER)
+/// @brief The extension keeps `-pedantic` builds warning-free, as ISO C++ has no 128-bit integers.
+__extension__ typedef unsigned __int128 uint128_t;
+#endif
+
+/// @brief How long to compare the cycle counter against the system clock, when calibrating.
+static constexpr std::size_t clock_calibration_ns_k{10'000'000}; // 10 ms
+
+/**
+ * @brief Reads the CPU cycle counter: the TSC on x86 or the virtual counter on Arm.
+ * Costs a few dozen cycles, compared to hundreds for `clock_gettime` without a vDSO.
+ */
+inline std::uint64_t cpu_cycles() noexcept {
+#if defined(UCALL_HAS_CYCLE_COUNTER) && defined(__x86_64__)
+    return __rdtsc();
+#elif defined(UCALL_HAS_CYCLE_COUNTER) && defined(__aarch64__)
+    std::uint64_t cycles;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(cycles));
+    return cycles;
+#else
+    return 0;
+#endif
+}
+
+/// @brief Checks if the cycle counter ticks at a constant rate, synchronized across cores.
+inline bool cpu_cycles_are_invariant() noexcept {
+#if defined(UCALL_HAS_CYCLE_COUNTER) && defined(__x86_64__)
+    unsigned eax, ebx, ecx, edx;
+    return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8));
+#elif defined(UCALL_HAS_CYCLE_COUNTER) && defined(__aarch64__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Monotonic nanosecond clock for the hot path, scaling the CPU cycle counter
+ * with a multiplier calibrated once at startup. Until calibrated, or if the counter isn't
+ * invariant, falls back to `std::chrono::steady_clock`. Either way, timestamps are only
+ * meaningful relative to each other within the same process.
+ */
+class cycle_clock_t {
+    /// @brief Fixed-point nanoseconds per cycle, with `fraction_bits_k` bits after the point.
+    static constexpr unsigned fraction_bits_k = 32;
+
+    inline static std::uint64_t base_cycles_{};
+    inline static std::uint64_t base_ns_{};
+    inline static std::uint64_t ns_per_cycle_{};
+    /// @brief Published after the scaling parameters, so that threads reading it also see them.
+    inline static std::atomic<bool> calibrated_{};
+    inline static std::once_flag calibration_flag_{};
+
+    static std::uint64_t steady_ns() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static void calibrate_once() noexcept {
+#if defined(UCALL_HAS_CYCLE_COUNTER)
+        if (!cpu_cycles_are_invariant())
+            return;
+#if defined(__aarch64__)
+        // The virtual counter reports its own frequency.
+        std::uint64_t frequency;
+        asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+        base_ns_ = steady_ns(), base_cycles_ = cpu_cycles();
+        ns_per_cycle_ = (1'000'000'000ull << fraction_bits_k) / frequency;
+#else
+        std::uint64_t start_ns = steady_ns(), start_cycles = cpu_cycles();
+        std::this_thread::sleep_for(std::chrono::nanoseconds(clock_calibration_ns_k));
+        std::uint64_t end_ns = steady_ns(), end_cycles = cpu_cycles();
+        if (end_cycles <= start_cycles)
+            return;
+        base_ns_ = end_ns, base_cycles_ = end_cycles;
+        ns_per_cycle_ = static_cast<std::uint64_t>((static_cast<uint128_t>(end_ns - start_ns) << fraction_bits_k) /
+                                                   (end_cycles - start_cycles));
+#endif
+        calibrated_.store(ns_per_cycle_ != 0, std::memory_order_release);
+#endif
+    }
+
+  public:
+    /// @brief Measures the frequency of the cycle counter. Blocks for ~10 ms, but only on the first call.
+    static void calibrate() noexcept { std::call_once(calibration_flag_, &calibrate_once); }
+
+    static bool is_calibrated() noexcept { return calibrated_.load(std::memory_order_acquire); }
+
+    static std::uint64_t now_ns() noexcept {
+#if defined(UCALL_HAS_CYCLE_COUNTER)
+        if (calibrated_.load(std::memory_order_acquire)) {
+            // Counters of different cores may be a few cycles apart, so never step back past the base.
+            std::uint64_t cycles = cpu_cycles();
+            cycles = cycles > base_cycles_ ? cycles - base_cycles_ : 0;
+            uint128_t scaled = static_cast<uint128_t>(cycles) * ns_per_cycle_;
+            return base_ns_ + static_cast<std::uint64_t>(scaled >> fraction_bits_k);
+        }
+#endif
+        return steady_ns();
+    }
+
+    /// @brief Difference between the Unix time and `now_ns()`, to print timestamps as the wall-clock time.
+    static std::uint64_t unix_offset_ns() noexcept {
+        auto unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+        return static_cast<std::uint64_t>(unix_ns) - now_ns();
+    }
+};
+
+} // namespace unum::ucall
@@ -8,7 +8,7 @@
 #include <sys/socket.h>
 #endif
 
-#include <chrono>
+#include <atomic>
 
 #include <openssl/engine.h>
 #include <openssl/err.h>
@@ -26,9 +26,12 @@
 #pragma warning(pop)
 #endif
 
+#include "clock.hpp"
 #include "containers.hpp"
+#include "log.hpp"
 #include "protocol.hpp"
 #include "shared.hpp"
+#include "tracing.hpp"
 
 namespace unum::ucall {
 
@@ -47,9 +50,27 @@ struct connection_t {
     socklen_t client_address_len{sizeof(struct sockaddr)};
 
     /// @brief Accumulated duration of sleep cycles.
-    std::size_t last_active_ns{};
+    std::uint64_t last_active_ns{};
     std::size_t exchanges{};
     std::size_t empty_transmits{};
+    /// @brief Unique within the capture log, if the server records one.
+    std::uint32_t capture_id{};
+    /// @brief When the first bytes of the current request have arrived.
+    std::uint64_t request_started_ns{};
+    /// @brief When the current request was complete and dispatched, and when its callback returned.
+    std::uint64_t request_dispatched_ns{};
+    std::uint64_t request_replied_ns{};
+    std::uint32_t request_bytes{};
+    /// @brief Code of the last error replied to the current request, or zero.
+    std::int32_t reply_error_code{};
+    /// @brief Histograms of the method serving the current request, to record its end-to-end latency.
+    method_stats_t* method_stats{};
+    /// @brief Name of the method serving the current request, for the slow requests log.
+    std::string_view method_name{};
+    /// @brief Retransmitted segments at the last transport sample, to count only the new ones.
+    std::uint32_t sampled_retransmits{};
+    /// @brief Trace context of the current request and the timestamps of its stages, if tracing is enabled.
+    traced_call_t trace{};
 
     /// @brief TLS related data
     ptls_t* tls_context{};
@@ -60,18 +81,21 @@ struct connection_t {
     /// @brief Relative time set for the last wake-up call.
     ssize_t next_wakeup = wakeup_initial_frequency_ns_k;
 
+    /// @brief Set by whichever comes first: the callback that deferred the reply, returning,
+    /// or another thread submitting that reply. The second one is responsible for sending it.
+    std::atomic<bool> deferred_handoff{};
+
     void make_tls(ptls_context_t* ssl_ctx) noexcept {
         tls_context = ptls_new(ssl_ctx, true);
         ptls_buffer_init(&work_buffer, ptls_buffer, ram_page_size_k);
     }
 
-    void record_activity() noexcept {
-        last_active_ns = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-    }
+    void record_activity() noexcept { last_active_ns = cycle_clock_t::now_ns(); }
 
     bool expired() const noexcept {
-        return std::chrono::high_resolution_clock::now().time_since_epoch().count() - last_active_ns >
-               max_inactive_duration_ns_k;
+        // After migrating to another core, the clock may read slightly earlier than the last activity.
+        std::uint64_t now = cycle_clock_t::now_ns();
+        return now > last_active_ns && now - last_active_ns > max_inactive_duration_ns_k;
     }
 
     bool is_ready() const noexcept { return tls_context == nullptr || ptls_handshake_is_complete(tls_context); }
@@ -143,8 +167,7 @@ struct connection_t {
         stage = stage_t::unknown_k;
         client_address = {};
 
-        pipes.release_inputs();
-        pipes.release_outputs();
+        pipes.reset();
 
         if (tls_context) {
             ptls_free(tls_context);
@@ -154,6 +177,9 @@ struct connection_t {
 
         exchanges = 0;
         empty_transmits = 0;
+        method_stats = nullptr;
+        method_name = {};
+        sampled_retransmits = 0;
         next_wakeup = wakeup_initial_frequency_ns_k;
     }
 };
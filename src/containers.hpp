@@ -1,12 +1,16 @@
 #pragma once
 #include <stdlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <numeric>
 #include <string_view>
 #include <type_traits>
+#include <utility> // `std::exchange`
 
 #include "globals.hpp"
 
@@ -97,6 +101,7 @@ template <typename element_at> class pool_gt {
     void release(element_at* released) noexcept { free_offsets_[free_count_++] = released - elements_; }
     [[nodiscard]] std::size_t offset_of(element_at& element) const noexcept { return &element - elements_; }
     [[nodiscard]] element_at& at_offset(std::size_t i) const noexcept { return elements_[i]; }
+    [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
 };
 
 template <typename element_at> class span_gt {
@@ -116,10 +121,21 @@ template <typename element_at> class span_gt {
     operator std::basic_string_view<element_at>() const noexcept { return {data(), size()}; }
 };
 
+/// @brief Heap allocations of a growing buffer since they were last taken, to attribute them to a thread.
+struct allocations_t {
+    std::size_t count{};
+    /// @brief Largest capacity requested, in bytes.
+    std::size_t peak_bytes{};
+
+    void record(std::size_t bytes) noexcept { ++count, peak_bytes = (std::max)(peak_bytes, bytes); }
+};
+
 template <typename element_at> class array_gt {
     element_at* elements_{};
     std::size_t count_{};
     std::size_t capacity_{};
+    /// @brief Survives `reset`, so that the buffers released before being accounted for aren't missed.
+    allocations_t allocations_{};
     static_assert(std::is_nothrow_default_constructible<element_at>());
     static_assert(std::is_trivially_copy_constructible<element_at>(), "Can't use realloc and memcpy");
 
@@ -133,6 +149,7 @@ template <typename element_at> class array_gt {
         std::swap(elements_, other.elements_);
         std::swap(count_, other.count_);
         std::swap(capacity_, other.capacity_);
+        std::swap(allocations_, other.allocations_);
         return *this;
     }
     [[nodiscard]] bool reserve(std::size_t n) noexcept {
@@ -151,6 +168,7 @@ template <typename element_at> class array_gt {
         }
         std::uninitialized_default_construct(elements_ + capacity_, elements_ + n);
         capacity_ = n;
+        allocations_.record(sizeof(element_at) * n);
         return true;
     }
     ~array_gt() noexcept { reset(); }
@@ -168,9 +186,16 @@ template <typename element_at> class array_gt {
     [[nodiscard]] std::size_t size() const noexcept { return count_; }
     [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
     [[nodiscard]] element_at& operator[](std::size_t i) noexcept { return elements_[i]; }
+    [[nodiscard]] allocations_t take_allocations() noexcept { return std::exchange(allocations_, {}); }
 
     void push_back_reserved(element_at element) noexcept { new (elements_ + count_++) element_at(std::move(element)); }
     void pop_back(std::size_t n = 1) noexcept { count_ -= n; }
+    /// @brief Forgets the elements, but keeps the memory for later.
+    void clear() noexcept {
+        if constexpr (!std::is_trivially_destructible<element_at>())
+            std::destroy_n(elements_, count_);
+        count_ = 0;
+    }
     [[nodiscard]] bool append_n(element_at const* elements, std::size_t n) noexcept {
         if (!reserve(size() + n))
             return false;
@@ -178,12 +203,62 @@ template <typename element_at> class array_gt {
         count_ += n;
         return true;
     }
+    /// @brief Grows the array by @p n elements, to be written in-place, doubling the capacity if needed.
+    /// @return Pointer to the first appended element, or `nullptr` if the allocation failed.
+    [[nodiscard]] element_at* extend(std::size_t n) noexcept {
+        if (size() + n > capacity() && !reserve((std::max)(size() + n, capacity() * 2)))
+            return nullptr;
+        element_at* tail = end();
+        count_ += n;
+        return tail;
+    }
+};
+
+/**
+ * @brief Fixed-capacity single-producer single-consumer queue, for handing records off a polling thread.
+ * The producer fills the reserved slot in place, and never waits: if the consumer falls behind, it drops.
+ * @tparam capacity_ak Must be a power of two.
+ */
+template <typename element_at, std::size_t capacity_ak> class alignas(64) spsc_ring_gt {
+    static_assert((capacity_ak & (capacity_ak - 1)) == 0, "Capacity must be a power of two");
+
+    alignas(64) std::atomic<std::uint64_t> head_{};
+    alignas(64) std::atomic<std::uint64_t> tail_{};
+    element_at elements_[capacity_ak]{};
+
+  public:
+    /// @brief Returns the next free slot, or `nullptr` if the queue is full. Call only from the producer.
+    [[nodiscard]] element_at* reserve() noexcept {
+        std::uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == capacity_ak)
+            return nullptr;
+        return &elements_[head % capacity_ak];
+    }
+
+    void commit() noexcept { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    bool pop(element_at& element) noexcept {
+        std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire))
+            return false;
+        element = elements_[tail % capacity_ak];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+/// @brief Decaying maximum of the recent message sizes, forgetting an eighth of a spike with every smaller one.
+struct size_history_t {
+    std::size_t recent_peak{};
+
+    void record(std::size_t size) noexcept { recent_peak = (std::max)(size, recent_peak - recent_peak / 8); }
 };
 
 struct exchange_pipe_t {
     char* embedded{};
     std::size_t embedded_used{};
     array_gt<char> dynamic{};
+    size_history_t history{};
 
     span_gt<char> span() noexcept {
         return dynamic.size() ? span_gt<char>{dynamic.begin(), dynamic.end()}
@@ -199,6 +274,35 @@ class exchange_pipes_t {
     /// @brief A combination of a embedded and dynamic memory pools for content reception.
     exchange_pipe_t output_{};
     std::size_t output_submitted_{};
+    /// @brief Pipelined requests, that arrived behind the one being answered.
+    array_gt<char> pipelined_{};
+    /// @brief Size of each of the embedded buffers, and the most bytes received at once.
+    std::size_t embedded_capacity_{ram_page_size_k};
+    /// @brief Keeps the dynamic buffers between messages, as long as the recent ones need them.
+    bool adaptive_{};
+
+    /// @brief Grows the dynamic part of @p pipe to fit @p size bytes, at least doubling it to amortize the
+    /// copies, and in the adaptive mode reserving enough for the largest recent message right away.
+    bool reserve_dynamic(exchange_pipe_t& pipe, std::size_t size) noexcept {
+        if (size <= pipe.dynamic.capacity())
+            return true;
+        std::size_t capacity = (std::max)(size, pipe.dynamic.capacity() * 2);
+        if (adaptive_)
+            capacity = (std::max)(capacity, pipe.history.recent_peak);
+        return pipe.dynamic.reserve(capacity);
+    }
+
+    /// @brief Forgets the message in @p pipe. Its dynamic memory is kept only in the adaptive mode,
+    /// unless it's twice as large as the recent messages have needed.
+    void release(exchange_pipe_t& pipe) noexcept {
+        if (std::size_t used = pipe.span().size())
+            pipe.history.record(used);
+        if (adaptive_ && pipe.dynamic.capacity() <= pipe.history.recent_peak * 2)
+            pipe.dynamic.clear();
+        else
+            pipe.dynamic.reset();
+        pipe.embedded_used = 0;
+    }
 
   public:
     exchange_pipes_t() noexcept = default;
@@ -207,34 +311,43 @@ class exchange_pipes_t {
     exchange_pipes_t& operator=(exchange_pipes_t&&) = delete;
     exchange_pipes_t& operator=(exchange_pipes_t const&) = delete;
 
-    void mount(char* inputs, char* outputs) noexcept {
+    void mount(char* inputs, char* outputs, std::size_t capacity, bool adaptive) noexcept {
         input_.embedded = inputs;
         output_.embedded = outputs;
+        embedded_capacity_ = capacity;
+        adaptive_ = adaptive;
     }
 
 #pragma region Context Switching
 
-    void release_inputs() noexcept {
-        input_.dynamic.reset();
-        input_.embedded_used = 0;
-    }
+    void release_inputs() noexcept { release(input_); }
 
     void release_current_input() noexcept { input_.embedded_used = 0; }
 
     void release_outputs() noexcept {
-        output_.dynamic.reset();
-        output_.embedded_used = 0;
+        release(output_);
         output_submitted_ = 0;
     }
 
+    /// @brief Frees all the memory and forgets the history, before the connection is reused by another client.
+    void reset() noexcept {
+        input_.dynamic.reset(), output_.dynamic.reset(), pipelined_.reset();
+        input_.embedded_used = output_.embedded_used = output_submitted_ = 0;
+        input_.history = output_.history = {};
+    }
+
     span_gt<char> input_span() noexcept { return input_.span(); }
     span_gt<char> output_span() noexcept { return output_.span(); }
 
+    /// @brief Spills out of the embedded pages since the previous call, including the already released ones.
+    allocations_t take_input_allocations() noexcept { return input_.dynamic.take_allocations(); }
+    allocations_t take_output_allocations() noexcept { return output_.dynamic.take_allocations(); }
+
 #pragma endregion
 
 #pragma region Piping Inputs
     char* next_input_address() noexcept { return input_.embedded; }
-    std::size_t next_input_length() const noexcept { return ram_page_size_k; }
+    std::size_t next_input_length() const noexcept { return embedded_capacity_; }
 
     /**
      * @brief Discards the first 'cnt' elements from the embedded buffer.
@@ -254,12 +367,42 @@ class exchange_pipes_t {
     }
 
     bool shift_input_to_dynamic() noexcept {
-        if (!input_.dynamic.append_n(input_.embedded, input_.embedded_used))
+        if (!reserve_dynamic(input_, input_.dynamic.size() + input_.embedded_used) ||
+            !input_.dynamic.append_n(input_.embedded, input_.embedded_used))
             return false;
         input_.embedded_used = 0;
         return true;
     }
 
+    /**
+     * @brief Trims the input to its first @p length bytes, holding back the pipelined requests that follow,
+     * until `restore_pipelined_input` is called once the first one is answered.
+     */
+    bool hold_pipelined_input(std::size_t length) noexcept {
+        span_gt<char> input = input_.span();
+        if (!length || length >= input.size())
+            return true;
+        if (!pipelined_.append_n(input.data() + length, input.size() - length))
+            return false;
+        drop_last_input(input.size() - length);
+        return true;
+    }
+
+    bool has_pipelined_input() const noexcept { return pipelined_.size(); }
+
+    /// @brief Replaces the released input with the held back requests, as if they have just been received.
+    /// If those don't fit into memory, they are dropped.
+    bool restore_pipelined_input() noexcept {
+        std::size_t length = pipelined_.size();
+        bool restored = true;
+        if (length <= embedded_capacity_)
+            std::memcpy(input_.embedded, pipelined_.data(), length), input_.embedded_used = length;
+        else
+            restored = reserve_dynamic(input_, length) && input_.dynamic.append_n(pipelined_.data(), length);
+        pipelined_.clear();
+        return restored;
+    }
+
     bool absorb_input(std::size_t embedded_used) noexcept {
         input_.embedded_used = embedded_used;
         if (!input_.dynamic.size())
@@ -274,7 +417,7 @@ class exchange_pipes_t {
     void prepare_more_outputs() noexcept {
         if (!output_.dynamic.size())
             return;
-        output_.embedded_used = (std::min)(output_.dynamic.size() - output_submitted_, ram_page_size_k);
+        output_.embedded_used = (std::min)(output_.dynamic.size() - output_submitted_, embedded_capacity_);
         std::memcpy(output_.embedded, output_.dynamic.data() + output_submitted_, output_.embedded_used);
     }
     bool has_outputs() const noexcept { return (std::max)(output_.embedded_used, output_.dynamic.size()); }
@@ -320,16 +463,16 @@ class exchange_pipes_t {
 #pragma endregion
 };
 
-bool exchange_pipes_t::append_outputs(std::string_view body) noexcept {
+inline bool exchange_pipes_t::append_outputs(std::string_view body) noexcept {
     bool was_in_embedded = !output_.dynamic.size();
-    bool fit_into_embedded = output_.embedded_used + body.size() < ram_page_size_k;
+    bool fit_into_embedded = output_.embedded_used + body.size() < embedded_capacity_;
 
     if (was_in_embedded && fit_into_embedded) {
         memcpy(output_.embedded + output_.embedded_used, body.data(), body.size());
         output_.embedded_used += body.size();
         return true;
     } else {
-        if (!output_.dynamic.reserve(output_.dynamic.size() + output_.embedded_used + body.size()))
+        if (!reserve_dynamic(output_, output_.dynamic.size() + output_.embedded_used + body.size()))
             return false;
         if (was_in_embedded) {
             if (!output_.dynamic.append_n(output_.embedded, output_.embedded_used))
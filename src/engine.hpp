@@ -1,12 +1,16 @@
 #pragma once
 
 #include <atomic>
+#include <new> // `std::nothrow`
 #include <optional>
 
+#include "clock.hpp"
 #include "connection.hpp"
 #include "containers.hpp"
 #include "log.hpp"
 #include "network.hpp"
+#include "perf.hpp"
+#include "probes.hpp"
 #include "protocol.hpp"
 #include "shared.hpp"
 
@@ -17,6 +21,8 @@ struct named_callback_t {
     ucall_callback_t callback{};
     request_type_t type{};
     ucall_callback_tag_t callback_tag{};
+    /// @brief Latency histograms of this method, one shard per thread, or `nullptr` if not tracked.
+    method_stats_t* stats{};
 
     bool method_matches(std::string_view) const noexcept;
 };
@@ -25,19 +31,57 @@ struct engine_t {
 
     /// @brief An array of function callbacks. Can be in dozens.
     array_gt<named_callback_t> callbacks{};
+    /// @brief Number of polling threads, each getting its own histograms for every callback.
+    std::size_t threads_count{};
+    /// @brief Hardware counters of every polling thread, or `nullptr` if not sampled.
+    std::unique_ptr<perf_group_t[]> perf_groups{};
+    /// @brief Every how many tracked callbacks of a thread to read its hardware counters around.
+    std::uint32_t perf_sampling_rate{};
+    /// @brief Generators of server span IDs of every polling thread, owned by the exporter, or `nullptr`.
+    span_ids_t* span_ids{};
+
+    engine_t() = default;
+    engine_t(engine_t const&) = delete;
+    engine_t& operator=(engine_t const&) = delete;
+    ~engine_t() noexcept {
+        for (named_callback_t& callback : callbacks)
+            delete callback.stats;
+    }
 
-    void raise_request(exchange_pipes_t&, protocol_t&, ucall_call_t) const noexcept;
+    /// @param connection_offset Identifies the connection in the tracepoints.
+    void raise_request(connection_t&, ucall_call_t, std::size_t thread_idx = 0,
+                       std::uint32_t connection_offset = 0) const noexcept;
 
     void try_add_callback(named_callback_t&&) noexcept;
-};
 
-void engine_t::raise_request(exchange_pipes_t& pipes, protocol_t& protocol, ucall_call_t call) const noexcept {
+    /// @brief Prints the latencies of every method called since the previous call, one line or JSON member each.
+    std::size_t log_methods(char* buffer, std::size_t buffer_capacity, bool json) noexcept;
+};
 
-    if (auto error_ptr = protocol.parse_headers(pipes.input_span()); error_ptr)
-        return ucall_call_reply_error(call, error_ptr->code, error_ptr->note.data(), error_ptr->note.size());
+void engine_t::raise_request(connection_t& connection, ucall_call_t call, std::size_t thread_idx,
+                             std::uint32_t connection_offset) const noexcept {
+    exchange_pipes_t& pipes = connection.pipes;
+    protocol_t& protocol = connection.protocol;
+
+    // Errors must still be framed, so that the client can tell where the reply ends.
+    auto reply_error = [&](default_error_t const& error) noexcept {
+        ucall_call_reply_error(call, error.code, error.note.data(), error.note.size());
+        protocol.finalize_response(pipes);
+    };
+
+    UCALL_PROBE2(parse_start, connection_offset, pipes.input_span().size());
+    if (auto error_ptr = protocol.parse_headers(pipes.input_span()); error_ptr) {
+        UCALL_PROBE2(parse_end, connection_offset, error_ptr->code);
+        protocol.prepare_response(pipes);
+        return reply_error(*error_ptr);
+    }
 
-    if (auto error_ptr = protocol.parse_content(); error_ptr)
-        return ucall_call_reply_error(call, error_ptr->code, error_ptr->note.data(), error_ptr->note.size());
+    if (auto error_ptr = protocol.parse_content(); error_ptr) {
+        UCALL_PROBE2(parse_end, connection_offset, error_ptr->code);
+        protocol.prepare_response(pipes);
+        return reply_error(*error_ptr);
+    }
+    UCALL_PROBE2(parse_end, connection_offset, 0);
 
     protocol.prepare_response(pipes);
     auto error_ptr = protocol.populate_response(pipes, [&](std::string_view& method_name, request_type_t req_type) {
@@ -51,21 +95,112 @@ void engine_t::raise_request(exchange_pipes_t& pipes, protocol_t& protocol, ucal
 
         named_callback_t named_callback = *callback_it;
         method_name = named_callback.name;
+        connection.method_name = named_callback.name;
+        UCALL_PROBE3(dispatch, connection_offset, method_name.data(), method_name.size());
+
+        // Unless the caller has sampled the call, tracing costs a single lookup of the "traceparent".
+        // In batches, the span covers the whole request, under the context of the last call carrying one.
+        traced_call_t& trace = connection.trace;
+        if (span_ids && parse_traceparent(protocol.get_traceparent(), trace.context)) {
+            trace.has_context = true;
+            span_ids[thread_idx].next(trace.context.span_id);
+        }
+        bool is_traced = trace.is_sampled();
+        if (!named_callback.stats && !is_traced) {
+            named_callback.callback(call, named_callback.callback_tag);
+            if (connection.stage != stage_t::awaiting_deferred_reply_k) {
+                UCALL_PROBE4(reply, connection_offset, method_name.data(), method_name.size(),
+                             pipes.output_span().size());
+            }
+            return true;
+        }
+
+        // Reading the counters costs a system call, so it's done outside of the timed region and only sometimes.
+        perf_group_t* perf_group = perf_groups && named_callback.stats ? &perf_groups[thread_idx] : nullptr;
+        perf_sample_t perf_before, perf_after;
+        bool perf_sampled =
+            perf_group && perf_group->should_sample(perf_sampling_rate) && perf_group->read(perf_before);
+
+        std::uint64_t started = cycle_clock_t::now_ns();
         named_callback.callback(call, named_callback.callback_tag);
+        std::uint64_t finished = cycle_clock_t::now_ns();
+        // Deferred replies may already be written by another thread, and are probed once submitted.
+        if (connection.stage != stage_t::awaiting_deferred_reply_k) {
+            UCALL_PROBE4(reply, connection_offset, method_name.data(), method_name.size(), pipes.output_span().size());
+        }
+        if (is_traced)
+            trace.called_ns = started, trace.returned_ns = finished;
+        if (!named_callback.stats)
+            return true;
+        method_shard_t& shard = named_callback.stats->shards[thread_idx];
+        shard.callback_ns.record(finished > started ? finished - started : 0);
+        if (perf_sampled && perf_group->read(perf_after))
+            shard.record_perf(perf_before, perf_after);
+        // In batches, the whole request is attributed to the last method.
+        connection.method_stats = named_callback.stats;
         return true;
     });
     if (error_ptr)
-        return ucall_call_reply_error(call, error_ptr->code, error_ptr->note.data(), error_ptr->note.size());
+        return reply_error(*error_ptr);
+    // Deferred replies are finalized once submitted.
+    if (connection.stage == stage_t::awaiting_deferred_reply_k)
+        return;
     protocol.finalize_response(pipes);
+    if (connection.trace.is_sampled())
+        connection.trace.serialized_ns = cycle_clock_t::now_ns();
 }
 
 inline void engine_t::try_add_callback(named_callback_t&& named) noexcept {
     if (callbacks.size() + 1 >= callbacks.capacity())
         return;
 
+    // Methods are still served, if the memory for their statistics can't be found.
+    if (threads_count) {
+        named.stats = new (std::nothrow) method_stats_t();
+        if (named.stats)
+            named.stats->shards.reset(new (std::nothrow) method_shard_t[threads_count]);
+        if (named.stats && named.stats->shards)
+            named.stats->shards_count = threads_count;
+        else
+            delete named.stats, named.stats = nullptr;
+    }
     callbacks.push_back_reserved(named);
 }
 
+std::size_t engine_t::log_methods(char* buffer, std::size_t buffer_capacity, bool json) noexcept {
+    // Leave room for the closing brace and the null-terminator.
+    std::size_t capacity = buffer_capacity - 2;
+    std::size_t length = 0;
+    for (named_callback_t const& named : callbacks) {
+        if (!named.stats)
+            continue;
+        // Collect even if there is no space left, so that the next interval starts from here.
+        method_histogram_t callback, request;
+        perf_sample_t perf;
+        named.stats->collect(callback, request);
+        std::uint64_t perf_samples = named.stats->collect_perf(perf);
+        if ((!callback.count() && !request.count()) || length + 1 >= capacity)
+            continue;
+
+        std::size_t previous_length = length;
+        if (json) {
+            buffer[length] = length ? ',' : '{';
+            ++length;
+        }
+        std::size_t printed =
+            json ? log_method_json(buffer + length, capacity - length, named.name, callback, request, perf,
+                                   perf_samples)
+                 : log_method_human_readable(buffer + length, capacity - length, named.name, callback, request,
+                                             perf, perf_samples);
+        // Drop the methods that don't fit entirely.
+        length = printed < capacity - length ? length + printed : previous_length;
+    }
+    if (json && length)
+        buffer[length++] = '}';
+    buffer[length] = 0;
+    return length;
+}
+
 bool named_callback_t::method_matches(std::string_view dynamic_name) const noexcept {
     auto first1 = dynamic_name.begin();
     auto end1 = dynamic_name.end();
@@ -2,6 +2,7 @@
 #include <fcntl.h>
 #include <netinet/in.h> // `sockaddr_in`
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/timerfd.h>
 #include <sys/types.h>
@@ -33,6 +34,11 @@ struct event_data_t {
 
 struct epoll_ctx_t {
     descriptor_t epoll{};
+    /// @brief Breaks `epoll_wait` when deferred replies are submitted from other threads.
+    descriptor_t wakeup{invalid_descriptor_k};
+    /// @brief One-shot timer, that completes the stats heartbeat.
+    descriptor_t heartbeat{invalid_descriptor_k};
+    connection_t* heartbeat_connection{};
     array_gt<event_data_t> event_log{};
 
     event_data_t& data_at(descriptor_t fd) noexcept { return event_log[fd % event_log.capacity()]; }
@@ -72,9 +78,19 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
         config.max_lifetime_micro_seconds = 100'000u;
     if (!config.max_lifetime_exchanges)
         config.max_lifetime_exchanges = 100u;
+    if (!config.logs_period_milli_seconds)
+        config.logs_period_milli_seconds = 5'000u;
+    if (!config.connection_buffer_bytes)
+        config.connection_buffer_bytes = ram_page_size_k;
+    // Buffers of all connections are carved out of a single memory mapping, so they are kept page-aligned.
+    config.connection_buffer_bytes = static_cast<std::uint32_t>(
+        (config.connection_buffer_bytes + ram_page_size_k - 1) / ram_page_size_k * ram_page_size_k);
     if (!config.hostname)
         config.hostname = "0.0.0.0";
 
+    // Timestamps on the hot path scale the cycle counter, measured once per process.
+    cycle_clock_t::calibrate();
+
     // Allocation
     int socket_descriptor{-1};
     int socket_options{1};
@@ -92,14 +108,18 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
     buffer_gt<struct iovec> registered_buffers{};
     memory_map_t fixed_buffers{};
     std::unique_ptr<ssl_context_t> ssl_ctx{};
+    std::size_t buffer_bytes = config.connection_buffer_bytes;
 
     // Try allocating all the necessary memory.
     server_ptr = (server_t*)std::malloc(sizeof(server_t));
     if (!server_ptr)
         goto cleanup;
+    new (server_ptr) server_t();
+    if (!server_ptr->allocate_features(config))
+        goto cleanup;
     if (!callbacks.reserve(config.max_callbacks))
         goto cleanup;
-    if (!fixed_buffers.reserve(ram_page_size_k * 2u * config.max_concurrent_connections))
+    if (!fixed_buffers.reserve(buffer_bytes * 2u * config.max_concurrent_connections))
         goto cleanup;
     if (!connections.reserve(config.max_concurrent_connections))
         goto cleanup;
@@ -109,14 +129,14 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
         goto cleanup;
     for (std::size_t i = 0; i != config.max_concurrent_connections; ++i) {
         auto& connection = connections.at_offset(i);
-        auto inputs = fixed_buffers.ptr + ram_page_size_k * 2u * i;
-        auto outputs = inputs + ram_page_size_k;
-        connection.pipes.mount(inputs, outputs);
+        auto inputs = fixed_buffers.ptr + buffer_bytes * 2u * i;
+        auto outputs = inputs + buffer_bytes;
+        connection.pipes.mount(inputs, outputs, buffer_bytes, config.adaptive_connection_buffers);
 
         registered_buffers[i * 2u].iov_base = inputs;
-        registered_buffers[i * 2u].iov_len = ram_page_size_k;
+        registered_buffers[i * 2u].iov_len = buffer_bytes;
         registered_buffers[i * 2u + 1u].iov_base = outputs;
-        registered_buffers[i * 2u + 1u].iov_len = ram_page_size_k;
+        registered_buffers[i * 2u + 1u].iov_len = buffer_bytes;
     }
 
     socket_descriptor = socket(AF_INET, SOCK_STREAM, 0);
@@ -134,6 +154,16 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
     ectx->epoll = epoll_create(1);
     if (ectx->epoll < 0)
         goto cleanup;
+    ectx->wakeup = eventfd(0, EFD_NONBLOCK);
+    if (ectx->wakeup < 0)
+        goto cleanup;
+    if (epoll_ctl_add(ectx->epoll, EPOLLIN | EPOLLET, ectx->wakeup) < 0)
+        goto cleanup;
+    ectx->heartbeat = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (ectx->heartbeat < 0)
+        goto cleanup;
+    if (epoll_ctl_add(ectx->epoll, EPOLLIN, ectx->heartbeat) < 0)
+        goto cleanup;
     if (config.ssl_certificates_count != 0) {
         ssl_ctx = std::make_unique<ssl_context_t>();
         if (ssl_ctx->init(config.ssl_private_key_path, config.ssl_certificates_paths, config.ssl_certificates_count) !=
@@ -142,17 +172,18 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
     }
 
     // Initialize all the members.
-    new (server_ptr) server_t();
     server_ptr->network_engine.network_data = ectx;
     server_ptr->socket = descriptor_t{socket_descriptor};
     server_ptr->ssl_ctx = std::move(ssl_ctx);
     server_ptr->protocol_type = config.protocol;
     server_ptr->max_lifetime_micro_seconds = config.max_lifetime_micro_seconds;
     server_ptr->max_lifetime_exchanges = config.max_lifetime_exchanges;
+    server_ptr->connection_buffer_bytes = buffer_bytes;
     server_ptr->engine.callbacks = std::move(callbacks);
     server_ptr->connections = std::move(connections);
     server_ptr->logs_file_descriptor = config.logs_file_descriptor;
     server_ptr->logs_format = config.logs_format ? std::string_view(config.logs_format) : std::string_view();
+    server_ptr->start_features(config);
     *server_out = (ucall_server_t)server_ptr;
     return;
 
@@ -160,6 +191,12 @@ cleanup:
     errno;
     if (socket_descriptor >= 0)
         close(socket_descriptor);
+    if (ectx->wakeup >= 0)
+        close(ectx->wakeup);
+    if (ectx->heartbeat >= 0)
+        close(ectx->heartbeat);
+    if (server_ptr)
+        server_ptr->~server_t();
     std::free(server_ptr);
     delete ectx;
     *server_out = nullptr;
@@ -172,6 +209,8 @@ void ucall_free(ucall_server_t punned_server) {
     server_t& server = *reinterpret_cast<server_t*>(punned_server);
     epoll_ctx_t* ctx = reinterpret_cast<epoll_ctx_t*>(server.network_engine.network_data);
     close(server.socket);
+    close(ctx->wakeup);
+    close(ctx->heartbeat);
     server.~server_t();
     std::free(punned_server);
     delete ctx;
@@ -192,7 +231,14 @@ int network_engine_t::try_accept(descriptor_t socket, connection_t& connection)
     return 0;
 }
 
-void network_engine_t::set_stats_heartbeat(connection_t& connection) noexcept {}
+void network_engine_t::set_stats_heartbeat(connection_t& connection) noexcept {
+    epoll_ctx_t* ctx = reinterpret_cast<epoll_ctx_t*>(network_data);
+    itimerspec timer_spec{};
+    timer_spec.it_value.tv_sec = connection.next_wakeup / 1'000'000'000;
+    timer_spec.it_value.tv_nsec = connection.next_wakeup % 1'000'000'000;
+    ctx->heartbeat_connection = &connection;
+    timerfd_settime(ctx->heartbeat, 0, &timer_spec, NULL);
+}
 
 bool network_engine_t::is_canceled(ssize_t res, connection_t const& connection) noexcept { return res == -ECANCELED; }
 
@@ -216,6 +262,11 @@ void network_engine_t::close_connection_gracefully(connection_t& connection) noe
     epoll_ctl_add(ctx->epoll, EPOLLIN | EPOLLONESHOT, timer_fd, connection.descriptor);
 }
 
+void network_engine_t::interrupt() noexcept {
+    epoll_ctx_t* ctx = reinterpret_cast<epoll_ctx_t*>(network_data);
+    eventfd_write(ctx->wakeup, 1);
+}
+
 void network_engine_t::send_packet(connection_t& connection, void* buffer, size_t buffer_length,
                                    size_t buf_index) noexcept {
     epoll_ctx_t* ctx = reinterpret_cast<epoll_ctx_t*>(network_data);
@@ -247,6 +298,22 @@ template <size_t max_count_ak> std::size_t network_engine_t::pop_completed_event
 
     for (int i = 0; i < num_events; ++i) {
         descriptor_t fd = ep_events[i].data.fd;
+        if (fd == ctx->wakeup) {
+            eventfd_t ignored;
+            eventfd_read(ctx->wakeup, &ignored);
+            continue;
+        }
+        // Every thread may be woken up by the timer, but only one reads the expiration.
+        if (fd == ctx->heartbeat) {
+            std::uint64_t expirations;
+            if (read(ctx->heartbeat, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                events[completed].connection_ptr = ctx->heartbeat_connection;
+                events[completed].result = 0;
+                ++completed;
+            }
+            continue;
+        }
+
         event_data_t& data = ctx->data_at(fd);
         connection_t* connection = data.connection;
 
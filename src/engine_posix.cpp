@@ -51,6 +51,9 @@ struct posix_ctx_t {
     std::queue<conn_ctx_t> res_queue; // TODO replace with custom
     mutex_t queue_mutex;
     memory_map_t fixed_buffers{};
+    /// @brief The pending stats heartbeat, completed once polled after its deadline. Guarded by `queue_mutex`.
+    connection_t* heartbeat{};
+    std::uint64_t heartbeat_deadline_ns{};
 };
 
 void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
@@ -75,9 +78,19 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
         config.max_lifetime_micro_seconds = 100'000u;
     if (!config.max_lifetime_exchanges)
         config.max_lifetime_exchanges = 100u;
+    if (!config.logs_period_milli_seconds)
+        config.logs_period_milli_seconds = 5'000u;
+    if (!config.connection_buffer_bytes)
+        config.connection_buffer_bytes = ram_page_size_k;
+    // Buffers of all connections are carved out of a single memory mapping, so they are kept page-aligned.
+    config.connection_buffer_bytes = static_cast<std::uint32_t>(
+        (config.connection_buffer_bytes + ram_page_size_k - 1) / ram_page_size_k * ram_page_size_k);
     if (!config.hostname)
         config.hostname = "0.0.0.0";
 
+    // Timestamps on the hot path scale the cycle counter, measured once per process.
+    cycle_clock_t::calibrate();
+
     // Allocate
     int socket_options{1};
     int socket_descriptor{-1};
@@ -87,6 +100,7 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
     pool_gt<connection_t> connections{};
     array_gt<named_callback_t> callbacks{};
     std::unique_ptr<ssl_context_t> ssl_ctx{};
+    std::size_t buffer_bytes = config.connection_buffer_bytes;
 
     // By default, let's open TCP port for IPv4.
     struct sockaddr_in address {};
@@ -98,18 +112,21 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
     server_ptr = (server_t*)std::malloc(sizeof(server_t));
     if (!server_ptr)
         goto cleanup;
+    new (server_ptr) server_t();
+    if (!server_ptr->allocate_features(config))
+        goto cleanup;
     if (!callbacks.reserve(config.max_callbacks))
         goto cleanup;
-    if (!uctx->fixed_buffers.reserve(ram_page_size_k * 2u * config.max_concurrent_connections))
+    if (!uctx->fixed_buffers.reserve(buffer_bytes * 2u * config.max_concurrent_connections))
         goto cleanup;
     if (!connections.reserve(config.max_concurrent_connections))
         goto cleanup;
 
     for (std::size_t i = 0; i != config.max_concurrent_connections; ++i) {
         auto& connection = connections.at_offset(i);
-        auto inputs = uctx->fixed_buffers.ptr + ram_page_size_k * 2u * i;
-        auto outputs = inputs + ram_page_size_k;
-        connection.pipes.mount(inputs, outputs);
+        auto inputs = uctx->fixed_buffers.ptr + buffer_bytes * 2u * i;
+        auto outputs = inputs + buffer_bytes;
+        connection.pipes.mount(inputs, outputs, buffer_bytes, config.adaptive_connection_buffers);
     }
 
     // Configure the socket.
@@ -141,17 +158,18 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
     }
 
     // Initialize all the members.
-    new (server_ptr) server_t();
     server_ptr->network_engine.network_data = uctx;
     server_ptr->socket = descriptor_t{socket_descriptor};
     server_ptr->ssl_ctx = std::move(ssl_ctx);
     server_ptr->protocol_type = config.protocol;
     server_ptr->max_lifetime_micro_seconds = config.max_lifetime_micro_seconds;
     server_ptr->max_lifetime_exchanges = config.max_lifetime_exchanges;
+    server_ptr->connection_buffer_bytes = buffer_bytes;
     server_ptr->engine.callbacks = std::move(callbacks);
     server_ptr->connections = std::move(connections);
     server_ptr->logs_file_descriptor = config.logs_file_descriptor;
     server_ptr->logs_format = config.logs_format ? std::string_view(config.logs_format) : std::string_view();
+    server_ptr->start_features(config);
     *server_out = (ucall_server_t)server_ptr;
     return;
 
@@ -159,6 +177,8 @@ cleanup:
     errno;
     if (socket_descriptor >= 0)
         close(socket_descriptor);
+    if (server_ptr)
+        server_ptr->~server_t();
     std::free(server_ptr);
     delete uctx;
     *server_out = nullptr;
@@ -204,14 +224,15 @@ int network_engine_t::try_accept(descriptor_t socket, connection_t& connection)
 void network_engine_t::set_stats_heartbeat(connection_t& connection) noexcept {
     posix_ctx_t* ctx = reinterpret_cast<posix_ctx_t*>(network_data);
 
-    conn_ctx_t coctx{&connection, 0};
-    // TODO what?
-
     ctx->queue_mutex.lock();
-    ctx->res_queue.push(coctx);
+    ctx->heartbeat = &connection;
+    ctx->heartbeat_deadline_ns = cycle_clock_t::now_ns() + connection.next_wakeup;
     ctx->queue_mutex.unlock();
 }
 
+// Completions are polled without blocking, so there is no one to wake up.
+void network_engine_t::interrupt() noexcept {}
+
 void network_engine_t::close_connection_gracefully(connection_t& connection) noexcept {
     posix_ctx_t* ctx = reinterpret_cast<posix_ctx_t*>(network_data);
 
@@ -266,6 +287,13 @@ template <size_t max_count_ak> std::size_t network_engine_t::pop_completed_event
 
     ctx->queue_mutex.lock();
 
+    if (ctx->heartbeat && cycle_clock_t::now_ns() >= ctx->heartbeat_deadline_ns) {
+        events[completed].connection_ptr = ctx->heartbeat;
+        events[completed].result = 0;
+        ++completed;
+        ctx->heartbeat = nullptr;
+    }
+
     while (!ctx->res_queue.empty() && completed < max_count_ak) {
         auto& ev = ctx->res_queue.front();
 
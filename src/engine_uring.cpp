@@ -65,6 +65,8 @@ struct uring_ctx_t {
     mutex_t submission_mutex{};
     memory_map_t fixed_buffers{};
     io_uring uring{};
+    /// @brief Must outlive the submission, as with `IORING_SETUP_SQPOLL` the kernel reads it asynchronously.
+    __kernel_timespec heartbeat_timeout{};
 };
 
 void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
@@ -89,9 +91,19 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
         config.max_lifetime_micro_seconds = 100'000u;
     if (!config.max_lifetime_exchanges)
         config.max_lifetime_exchanges = 100u;
+    if (!config.logs_period_milli_seconds)
+        config.logs_period_milli_seconds = 5'000u;
+    if (!config.connection_buffer_bytes)
+        config.connection_buffer_bytes = ram_page_size_k;
+    // Buffers of all connections are carved out of a single memory mapping, so they are kept page-aligned.
+    config.connection_buffer_bytes = static_cast<std::uint32_t>(
+        (config.connection_buffer_bytes + ram_page_size_k - 1) / ram_page_size_k * ram_page_size_k);
     if (!config.hostname)
         config.hostname = "0.0.0.0";
 
+    // Timestamps on the hot path scale the cycle counter, measured once per process.
+    cycle_clock_t::calibrate();
+
     // Allocate
     int socket_options{1};
     int socket_descriptor{-1};
@@ -112,6 +124,7 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
     array_gt<named_callback_t> callbacks{};
     buffer_gt<struct iovec> registered_buffers{};
     std::unique_ptr<ssl_context_t> ssl_ctx{};
+    std::size_t buffer_bytes = config.connection_buffer_bytes;
 
     // By default, let's open TCP port for IPv4.
     struct sockaddr_in address {};
@@ -128,9 +141,12 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
     server_ptr = (server_t*)std::malloc(sizeof(server_t));
     if (!server_ptr)
         goto cleanup;
+    new (server_ptr) server_t();
+    if (!server_ptr->allocate_features(config))
+        goto cleanup;
     if (!callbacks.reserve(config.max_callbacks))
         goto cleanup;
-    if (!uctx->fixed_buffers.reserve(ram_page_size_k * 2u * config.max_concurrent_connections))
+    if (!uctx->fixed_buffers.reserve(buffer_bytes * 2u * config.max_concurrent_connections))
         goto cleanup;
     if (!connections.reserve(config.max_concurrent_connections))
         goto cleanup;
@@ -140,14 +156,14 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
         goto cleanup;
     for (std::size_t i = 0; i != config.max_concurrent_connections; ++i) {
         auto& connection = connections.at_offset(i);
-        auto inputs = uctx->fixed_buffers.ptr + ram_page_size_k * 2u * i;
-        auto outputs = inputs + ram_page_size_k;
-        connection.pipes.mount(inputs, outputs);
+        auto inputs = uctx->fixed_buffers.ptr + buffer_bytes * 2u * i;
+        auto outputs = inputs + buffer_bytes;
+        connection.pipes.mount(inputs, outputs, buffer_bytes, config.adaptive_connection_buffers);
 
         registered_buffers[i * 2u].iov_base = inputs;
-        registered_buffers[i * 2u].iov_len = ram_page_size_k;
+        registered_buffers[i * 2u].iov_len = buffer_bytes;
         registered_buffers[i * 2u + 1u].iov_base = outputs;
-        registered_buffers[i * 2u + 1u].iov_len = ram_page_size_k;
+        registered_buffers[i * 2u + 1u].iov_len = buffer_bytes;
     }
     uring_result = io_uring_register_files_sparse(uring, config.max_concurrent_connections);
     if (uring_result != 0)
@@ -184,17 +200,18 @@ void ucall_init(ucall_config_t* config_inout, ucall_server_t* server_out) {
     }
 
     // Initialize all the members.
-    new (server_ptr) server_t();
     server_ptr->network_engine.network_data = uctx;
     server_ptr->socket = descriptor_t{socket_descriptor};
     server_ptr->ssl_ctx = std::move(ssl_ctx);
     server_ptr->protocol_type = config.protocol;
     server_ptr->max_lifetime_micro_seconds = config.max_lifetime_micro_seconds;
     server_ptr->max_lifetime_exchanges = config.max_lifetime_exchanges;
+    server_ptr->connection_buffer_bytes = buffer_bytes;
     server_ptr->engine.callbacks = std::move(callbacks);
     server_ptr->connections = std::move(connections);
     server_ptr->logs_file_descriptor = config.logs_file_descriptor;
     server_ptr->logs_format = config.logs_format ? std::string_view(config.logs_format) : std::string_view();
+    server_ptr->start_features(config);
     *server_out = (ucall_server_t)server_ptr;
     return;
 
@@ -204,6 +221,8 @@ cleanup:
         io_uring_queue_exit(uring);
     if (socket_descriptor >= 0)
         close(socket_descriptor);
+    if (server_ptr)
+        server_ptr->~server_t();
     std::free(server_ptr);
     delete uctx;
     *server_out = nullptr;
@@ -257,16 +276,20 @@ int network_engine_t::try_accept(descriptor_t socket, connection_t& connection)
 
 void network_engine_t::set_stats_heartbeat(connection_t& connection) noexcept {
     uring_ctx_t* ctx = reinterpret_cast<uring_ctx_t*>(network_data);
-    __kernel_timespec wakeup{0, connection.next_wakeup};
     io_uring* uring = &ctx->uring;
     ctx->submission_mutex.lock();
+    ctx->heartbeat_timeout.tv_sec = connection.next_wakeup / 1'000'000'000;
+    ctx->heartbeat_timeout.tv_nsec = connection.next_wakeup % 1'000'000'000;
     io_uring_sqe* uring_sqe = io_uring_get_sqe(uring);
-    io_uring_prep_timeout(uring_sqe, &wakeup, 0, 0);
+    io_uring_prep_timeout(uring_sqe, &ctx->heartbeat_timeout, 0, 0);
     io_uring_sqe_set_data(uring_sqe, &connection);
     io_uring_submit(uring);
     ctx->submission_mutex.unlock();
 }
 
+// Completions are polled without blocking, so there is no one to wake up.
+void network_engine_t::interrupt() noexcept {}
+
 void network_engine_t::close_connection_gracefully(connection_t& connection) noexcept {
     uring_ctx_t* ctx = reinterpret_cast<uring_ctx_t*>(network_data);
     // The operations are not expected to complete in exactly the same order
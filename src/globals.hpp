@@ -32,9 +32,6 @@ static constexpr std::size_t json_pointer_capacity_k = 256;
 static constexpr std::size_t max_integer_length_k = 32;
 /// @brief Needed for largest-register-aligned memory addressing.
 static constexpr std::size_t align_k = 64;
-/// @brief Accessing real time from user-space is very expensive.
-/// To approximate we can use CPU cycle counters.
-constexpr std::size_t cpu_cycles_per_micro_second_k = 3'000;
 
 // /// @brief As we use SIMDJSON, we don't want to fill our message buffers entirely.
 // /// If there is a @b padding at the end, matching the size of the largest CPU register
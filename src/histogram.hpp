@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>  // `std::atomic`
+#include <cstdint> // `std::uint64_t`
+#include <cstring> // `std::memset`
+
+namespace unum::ucall {
+
+/**
+ * @brief Log-linear histogram of 64-bit values, like latencies in nanoseconds, in the spirit of HDR Histogram.
+ *
+ * Values below `sub_buckets_k` are counted exactly. Larger values share a bucket with
+ * others of the same magnitude, keeping the relative error under 1 / `half_buckets_k`,
+ * that is under 1%. Recording is a couple of shifts and a single increment, with no allocations.
+ * Fewer @p sub_buckets_bits_ak trade precision for a smaller footprint.
+ */
+template <std::size_t sub_buckets_bits_ak = 8> class histogram_gt {
+  public:
+    static constexpr std::size_t sub_buckets_bits_k = sub_buckets_bits_ak;
+    static constexpr std::size_t sub_buckets_k = 1ull << sub_buckets_bits_k;
+    static constexpr std::size_t half_buckets_k = sub_buckets_k / 2;
+    static constexpr std::size_t buckets_k = (64 - sub_buckets_bits_k + 2) * half_buckets_k;
+
+  private:
+    std::uint64_t counts_[buckets_k];
+    std::uint64_t total_count_;
+    std::uint64_t total_sum_;
+    std::uint64_t min_;
+    std::uint64_t max_;
+
+  public:
+    static std::size_t index_of(std::uint64_t value) noexcept {
+        if (value < sub_buckets_k)
+            return static_cast<std::size_t>(value);
+        std::size_t shift = 63 - __builtin_clzll(value) - (sub_buckets_bits_k - 1);
+        return shift * half_buckets_k + static_cast<std::size_t>(value >> shift);
+    }
+
+    /// @brief Largest value, that would land in the same bucket as @p index.
+    static std::uint64_t highest_equivalent(std::size_t index) noexcept {
+        if (index < sub_buckets_k)
+            return index;
+        std::size_t shift = index / half_buckets_k - 1;
+        std::uint64_t sub_bucket = index % half_buckets_k + half_buckets_k;
+        return ((sub_bucket + 1) << shift) - 1;
+    }
+
+    histogram_gt() noexcept { reset(); }
+
+    void reset() noexcept {
+        std::memset(counts_, 0, sizeof(counts_));
+        total_count_ = total_sum_ = max_ = 0;
+        min_ = UINT64_MAX;
+    }
+
+    void record(std::uint64_t value, std::uint64_t count = 1) noexcept {
+        counts_[index_of(value)] += count;
+        total_count_ += count;
+        total_sum_ += value * count;
+        min_ = value < min_ ? value : min_;
+        max_ = value > max_ ? value : max_;
+    }
+
+    /// @brief Adds @p count values to a bucket at once, as if they were all its highest equivalent.
+    void record_bucket(std::size_t index, std::uint64_t count) noexcept {
+        if (count)
+            record(highest_equivalent(index), count);
+    }
+
+    void merge(histogram_gt const& other) noexcept {
+        for (std::size_t i = 0; i != buckets_k; ++i)
+            counts_[i] += other.counts_[i];
+        total_count_ += other.total_count_;
+        total_sum_ += other.total_sum_;
+        min_ = other.min_ < min_ ? other.min_ : min_;
+        max_ = other.max_ > max_ ? other.max_ : max_;
+    }
+
+    std::uint64_t count() const noexcept { return total_count_; }
+    std::uint64_t min() const noexcept { return total_count_ ? min_ : 0; }
+    std::uint64_t max() const noexcept { return max_; }
+    double mean() const noexcept { return total_count_ ? double(total_sum_) / total_count_ : 0; }
+
+    /**
+     * @param percentile In the [0, 100] range, like 99.9.
+     * @return The highest value equivalent to the one at the given percentile, but never above `max()`.
+     */
+    std::uint64_t percentile(double percentile) const noexcept {
+        if (!total_count_)
+            return 0;
+        std::uint64_t rank = static_cast<std::uint64_t>(percentile / 100 * total_count_ + 0.5);
+        rank = rank ? rank : 1;
+        std::uint64_t passed = 0;
+        for (std::size_t i = 0; i != buckets_k; ++i)
+            if ((passed += counts_[i]) >= rank) {
+                std::uint64_t value = highest_equivalent(i);
+                return value < max_ ? value : max_;
+            }
+        return max_;
+    }
+};
+
+using histogram_t = histogram_gt<>;
+
+/**
+ * @brief Histogram written by a single thread, that any other thread can read at any time.
+ * Buckets are relaxed atomics, incremented without locked instructions. They are never reset,
+ * so readers get the counts for an interval by subtracting their previous snapshot.
+ */
+template <std::size_t sub_buckets_bits_ak> class owned_histogram_gt {
+  public:
+    using layout_t = histogram_gt<sub_buckets_bits_ak>;
+    static constexpr std::size_t buckets_k = layout_t::buckets_k;
+
+  private:
+    std::atomic<std::uint64_t> counts_[buckets_k]{};
+    std::atomic<std::uint64_t> sum_{};
+
+  public:
+    void record(std::uint64_t value) noexcept {
+        std::atomic<std::uint64_t>& count = counts_[layout_t::index_of(value)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+    std::uint64_t bucket(std::size_t index) const noexcept { return counts_[index].load(std::memory_order_relaxed); }
+    /// @brief Exact sum of all the recorded values, unlike the one reconstructed from buckets.
+    std::uint64_t sum() const noexcept { return sum_.load(std::memory_order_relaxed); }
+};
+
+} // namespace unum::ucall
@@ -1,6 +1,11 @@
 #pragma once
 #include <atomic>
-#include <stdio.h> // `std::snprintf`
+#include <memory>      // `std::unique_ptr`
+#include <stdio.h>     // `std::snprintf`
+#include <string_view> // `std::string_view`
+
+#include "histogram.hpp"
+#include "perf.hpp"
 
 namespace unum::ucall {
 
@@ -19,22 +24,247 @@ inline number_and_suffix_t printable(std::size_t n) noexcept {
     return {n + 0.0f, ' '};
 }
 
+/**
+ * @brief Counter incremented by a single thread and read by any other.
+ * Unlike `fetch_add`, the increment needs no locked instruction, as there is no other writer.
+ */
+class owned_counter_t {
+    std::atomic<std::size_t> value_{};
+
+  public:
+    void add(std::size_t n) noexcept {
+        value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    std::size_t load() const noexcept { return value_.load(std::memory_order_relaxed); }
+};
+
+/**
+ * @brief Counters of a single polling thread, occupying their own cache line,
+ * so that threads reporting their traffic don't invalidate each other's caches.
+ */
+struct alignas(64) stats_shard_t {
+    owned_counter_t added_connections{};
+    owned_counter_t closed_connections{};
+    owned_counter_t bytes_received{};
+    owned_counter_t bytes_sent{};
+    owned_counter_t packets_received{};
+    owned_counter_t packets_sent{};
+};
+
+/// @brief Per-method histograms keep ~3% precision, to stay small with many threads and methods.
+using method_histogram_t = histogram_gt<6>;
+using owned_method_histogram_t = owned_histogram_gt<6>;
+
+/**
+ * @brief Latencies of a single method, recorded by a single polling thread, in nanoseconds.
+ */
+struct alignas(64) method_shard_t {
+    /// @brief Time spent in the user callback.
+    owned_method_histogram_t callback_ns{};
+    /// @brief Time from the arrival of the request, to the last byte of its reply being sent.
+    owned_method_histogram_t request_ns{};
+    /// @brief Hardware counters summed over the sampled calls, if sampling is enabled.
+    owned_counter_t perf_samples{};
+    owned_counter_t perf_totals[perf_counters_k]{};
+
+    void record_perf(perf_sample_t const& before, perf_sample_t const& after) noexcept {
+        perf_samples.add(1);
+        for (std::size_t i = 0; i != perf_counters_k; ++i)
+            perf_totals[i].add(after.values[i] - before.values[i]);
+    }
+};
+
+/**
+ * @brief Latencies of a single registered method across all polling threads.
+ * Allocated once when the method is registered, and only read when logging.
+ */
+struct method_stats_t {
+    std::unique_ptr<method_shard_t[]> shards{};
+    std::size_t shards_count{};
+    /// @brief Bucket totals at the time of the last log.
+    std::uint64_t logged_callback[method_histogram_t::buckets_k]{};
+    std::uint64_t logged_request[method_histogram_t::buckets_k]{};
+    std::uint64_t logged_perf_samples{};
+    std::uint64_t logged_perf[perf_counters_k]{};
+
+    /// @brief Merges the shards into histograms of the values recorded since the previous call.
+    void collect(method_histogram_t& callback, method_histogram_t& request) noexcept {
+        for (std::size_t i = 0; i != method_histogram_t::buckets_k; ++i) {
+            std::uint64_t callback_total = 0, request_total = 0;
+            for (std::size_t j = 0; j != shards_count; ++j)
+                callback_total += shards[j].callback_ns.bucket(i), request_total += shards[j].request_ns.bucket(i);
+            callback.record_bucket(i, callback_total - logged_callback[i]);
+            request.record_bucket(i, request_total - logged_request[i]);
+            logged_callback[i] = callback_total;
+            logged_request[i] = request_total;
+        }
+    }
+
+    /**
+     * @brief Merges the shards into histograms of all the values recorded since the server has started,
+     * without affecting the logs. Reports the exact sums of the latencies, rather than the bucketed ones.
+     */
+    void snapshot(method_histogram_t& callback, method_histogram_t& request, std::uint64_t& callback_sum,
+                  std::uint64_t& request_sum) const noexcept {
+        for (std::size_t i = 0; i != method_histogram_t::buckets_k; ++i) {
+            std::uint64_t callback_total = 0, request_total = 0;
+            for (std::size_t j = 0; j != shards_count; ++j)
+                callback_total += shards[j].callback_ns.bucket(i), request_total += shards[j].request_ns.bucket(i);
+            callback.record_bucket(i, callback_total);
+            request.record_bucket(i, request_total);
+        }
+        callback_sum = request_sum = 0;
+        for (std::size_t j = 0; j != shards_count; ++j)
+            callback_sum += shards[j].callback_ns.sum(), request_sum += shards[j].request_ns.sum();
+    }
+
+    /// @brief Sums the hardware counters of all shards, returning the number of calls sampled since the previous call.
+    std::uint64_t collect_perf(perf_sample_t& growth) noexcept {
+        std::uint64_t samples = 0;
+        perf_sample_t totals{};
+        for (std::size_t j = 0; j != shards_count; ++j) {
+            samples += shards[j].perf_samples.load();
+            for (std::size_t i = 0; i != perf_counters_k; ++i)
+                totals.values[i] += shards[j].perf_totals[i].load();
+        }
+        for (std::size_t i = 0; i != perf_counters_k; ++i)
+            growth.values[i] = totals.values[i] - logged_perf[i], logged_perf[i] = totals.values[i];
+        std::uint64_t growth_samples = samples - logged_perf_samples;
+        logged_perf_samples = samples;
+        return growth_samples;
+    }
+};
+
+/// @brief Hardware counters averaged over the sampled calls, or zeros if none were sampled.
+struct perf_averages_t {
+    double cycles{}, instructions_per_cycle{}, l1d_misses{}, llc_misses{}, branch_misses{};
+
+    perf_averages_t(perf_sample_t const& totals, std::uint64_t samples) noexcept {
+        if (!samples)
+            return;
+        auto per_call = [=](perf_counter_t counter) noexcept { return totals.values[counter] * 1.0 / samples; };
+        cycles = per_call(perf_cycles_k);
+        instructions_per_cycle = cycles ? per_call(perf_instructions_k) / cycles : 0;
+        l1d_misses = per_call(perf_l1d_misses_k);
+        llc_misses = per_call(perf_llc_misses_k);
+        branch_misses = per_call(perf_branch_misses_k);
+    }
+};
+
+inline std::size_t log_method_human_readable(char* buffer, std::size_t buffer_capacity, std::string_view name,
+                                             method_histogram_t const& callback, method_histogram_t const& request,
+                                             perf_sample_t const& perf, std::uint64_t perf_samples) noexcept {
+    auto us = [](std::uint64_t ns) noexcept { return ns / 1e3; };
+    auto len = snprintf( //
+        buffer, buffer_capacity,
+        "- %.*s: %zu calls, "
+        "callback p50 %.1f, p90 %.1f, p99 %.1f, p999 %.1f, max %.1f us, "
+        "request p50 %.1f, p90 %.1f, p99 %.1f, p999 %.1f, max %.1f us",
+        static_cast<int>(name.size()), name.data(), static_cast<std::size_t>(callback.count()),     //
+        us(callback.percentile(50)), us(callback.percentile(90)), us(callback.percentile(99)),     //
+        us(callback.percentile(99.9)), us(callback.max()),                                           //
+        us(request.percentile(50)), us(request.percentile(90)), us(request.percentile(99)),        //
+        us(request.percentile(99.9)), us(request.max())                                              //
+    );
+    if (len < 0 || static_cast<std::size_t>(len) >= buffer_capacity)
+        return static_cast<std::size_t>(len);
+
+    perf_averages_t averages{perf, perf_samples};
+    auto perf_len = perf_samples //
+                        ? snprintf(buffer + len, buffer_capacity - len,
+                                   ", %zu sampled: %.0f cycles, %.2f IPC, "
+                                   "%.1f L1d, %.1f LLC, %.1f branch misses per call. \n",
+                                   static_cast<std::size_t>(perf_samples), averages.cycles,  //
+                                   averages.instructions_per_cycle, averages.l1d_misses,     //
+                                   averages.llc_misses, averages.branch_misses)              //
+                        : snprintf(buffer + len, buffer_capacity - len, ". \n");
+    return static_cast<std::size_t>(len + perf_len);
+}
+
+inline std::size_t log_method_json(char* buffer, std::size_t buffer_capacity, std::string_view name,
+                                   method_histogram_t const& callback, method_histogram_t const& request,
+                                   perf_sample_t const& perf, std::uint64_t perf_samples) noexcept {
+    auto format = R"("%.*s":{"calls":%zu,)"
+                  R"("callback_ns":{"p50":%zu,"p90":%zu,"p99":%zu,"p999":%zu,"max":%zu},)"
+                  R"("request_ns":{"p50":%zu,"p90":%zu,"p99":%zu,"p999":%zu,"max":%zu})";
+    auto ns = [](std::uint64_t ns) noexcept { return static_cast<std::size_t>(ns); };
+    auto len = snprintf( //
+        buffer, buffer_capacity, format,
+        static_cast<int>(name.size()), name.data(), static_cast<std::size_t>(callback.count()),     //
+        ns(callback.percentile(50)), ns(callback.percentile(90)), ns(callback.percentile(99)),     //
+        ns(callback.percentile(99.9)), ns(callback.max()),                                           //
+        ns(request.percentile(50)), ns(request.percentile(90)), ns(request.percentile(99)),        //
+        ns(request.percentile(99.9)), ns(request.max())                                              //
+    );
+    if (len < 0 || static_cast<std::size_t>(len) >= buffer_capacity)
+        return static_cast<std::size_t>(len);
+
+    perf_averages_t averages{perf, perf_samples};
+    auto perf_len = perf_samples //
+                        ? snprintf(buffer + len, buffer_capacity - len,
+                                   R"(,"perf":{"samples":%zu,"cycles":%.0f,"ipc":%.3f,)"
+                                   R"("l1d_misses":%.2f,"llc_misses":%.2f,"branch_misses":%.2f}})",
+                                   static_cast<std::size_t>(perf_samples), averages.cycles, //
+                                   averages.instructions_per_cycle, averages.l1d_misses,    //
+                                   averages.llc_misses, averages.branch_misses)             //
+                        : snprintf(buffer + len, buffer_capacity - len, "}");
+    return static_cast<std::size_t>(len + perf_len);
+}
+
+struct stats_totals_t {
+    std::size_t added_connections{};
+    std::size_t closed_connections{};
+    std::size_t bytes_received{};
+    std::size_t bytes_sent{};
+    std::size_t packets_received{};
+    std::size_t packets_sent{};
+};
+
 struct stats_t {
 
-    static constexpr std::size_t default_frequency_secs_k{5};
+    /// @brief One per thread, indexed by the `thread_idx` passed to `ucall_take_call`.
+    std::unique_ptr<stats_shard_t[]> shards{};
+    std::size_t shards_count{};
+    /// @brief Totals at the time of the last log, as shards are never reset by anyone but their owners.
+    stats_totals_t logged{};
+    /// @brief When the last log was printed, to normalize the rates by the actual interval.
+    std::uint64_t logged_ns{};
 
-    std::atomic<std::size_t> added_connections{};
-    std::atomic<std::size_t> closed_connections{};
-    std::atomic<std::size_t> bytes_received{};
-    std::atomic<std::size_t> bytes_sent{};
-    std::atomic<std::size_t> packets_received{};
-    std::atomic<std::size_t> packets_sent{};
+    stats_shard_t& shard(std::size_t thread_idx) noexcept { return shards[thread_idx]; }
 
-    inline std::size_t log_human_readable(char* buffer, std::size_t buffer_capacity, std::size_t seconds) noexcept {
-        auto& s = *this;
-        auto printable_normalized = [=](std::atomic<std::size_t>& i) noexcept {
-            return printable(double(i.exchange(0, std::memory_order_relaxed)) / seconds);
+    /// @brief Sums up all the shards, counting since the server has started.
+    stats_totals_t total() const noexcept {
+        stats_totals_t totals{};
+        for (std::size_t i = 0; i != shards_count; ++i) {
+            stats_shard_t const& shard = shards[i];
+            totals.added_connections += shard.added_connections.load();
+            totals.closed_connections += shard.closed_connections.load();
+            totals.bytes_received += shard.bytes_received.load();
+            totals.bytes_sent += shard.bytes_sent.load();
+            totals.packets_received += shard.packets_received.load();
+            totals.packets_sent += shard.packets_sent.load();
+        }
+        return totals;
+    }
+
+    /// @brief Sums up all the shards, returning the growth since the previous call.
+    stats_totals_t collect() noexcept {
+        stats_totals_t totals = total();
+        stats_totals_t growth{
+            totals.added_connections - logged.added_connections,
+            totals.closed_connections - logged.closed_connections,
+            totals.bytes_received - logged.bytes_received,
+            totals.bytes_sent - logged.bytes_sent,
+            totals.packets_received - logged.packets_received,
+            totals.packets_sent - logged.packets_sent,
         };
+        logged = totals;
+        return growth;
+    }
+
+    inline std::size_t log_human_readable(char* buffer, std::size_t buffer_capacity, double seconds) noexcept {
+        stats_totals_t s = collect();
+        auto printable_normalized = [=](std::size_t i) noexcept { return printable(i / seconds); };
         auto added_connections = printable_normalized(s.added_connections);
         auto closed_connections = printable_normalized(s.closed_connections);
         auto bytes_received = printable_normalized(s.bytes_received);
@@ -59,25 +289,25 @@ struct stats_t {
         return static_cast<std::size_t>(len);
     }
 
-    inline std::size_t log_json(char* buffer, std::size_t buffer_capacity) noexcept {
-        auto& s = *this;
-        auto added_connections = s.added_connections.exchange(0, std::memory_order_relaxed);
-        auto closed_connections = s.closed_connections.exchange(0, std::memory_order_relaxed);
-        auto bytes_received = s.bytes_received.exchange(0, std::memory_order_relaxed);
-        auto bytes_sent = s.bytes_sent.exchange(0, std::memory_order_relaxed);
-        auto packets_received = s.packets_received.exchange(0, std::memory_order_relaxed);
-        auto packets_sent = s.packets_sent.exchange(0, std::memory_order_relaxed);
-        auto format =
-            R"( {"add":%zu,"close":%zu,"recv_bytes":%zu,"sent_bytes":%zu,"recv_packs":%zu,"sent_packs":%zu} \n )";
-        auto len = snprintf(         //
-            buffer, buffer_capacity, //
-            format,                  //
-            added_connections,       //
-            closed_connections,      //
-            bytes_received,          //
-            bytes_sent,              //
-            packets_received,        //
-            packets_sent             //
+    /// @param methods, extras Optional JSON members appended to the object, like `,"methods":{...}`.
+    inline std::size_t log_json(char* buffer, std::size_t buffer_capacity, std::string_view methods = "",
+                                std::string_view extras = "") noexcept {
+        stats_totals_t s = collect();
+        auto format = R"( {"add":%zu,"close":%zu,"recv_bytes":%zu,"sent_bytes":%zu,"recv_packs":%zu,"sent_packs":%zu)"
+                      R"(%.*s%.*s} \n )";
+        auto len = snprintf(                    //
+            buffer, buffer_capacity,            //
+            format,                             //
+            s.added_connections,                //
+            s.closed_connections,               //
+            s.bytes_received,                   //
+            s.bytes_sent,                       //
+            s.packets_received,                 //
+            s.packets_sent,                     //
+            static_cast<int>(extras.size()),    //
+            extras.data(),                      //
+            static_cast<int>(methods.size()),   //
+            methods.data()                      //
         );
         return static_cast<std::size_t>(len);
     }
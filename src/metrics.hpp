@@ -0,0 +1,209 @@
+#pragma once
+
+#include <charconv>    // `std::to_chars`
+#include <cstdarg>     // `va_list`
+#include <stdio.h>     // `std::vsnprintf`
+#include <string_view> // `std::string_view`
+
+#include "server.hpp"
+
+namespace unum::ucall {
+
+static constexpr char const* metrics_header_k =
+    "HTTP/1.1 200 OK\r\nContent-Length:          \r\n"
+    "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n\r\n";
+static constexpr std::size_t metrics_header_length_offset_k = 33;
+static constexpr std::size_t metrics_header_length_capacity_k = 9;
+static constexpr std::string_view metrics_unavailable_k =
+    "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n";
+
+/**
+ * @brief Upper bound of a bucket in the exported latency histograms.
+ * Values are attributed to bounds with the precision of `method_histogram_t`, so within ~3%.
+ */
+struct metrics_bound_t {
+    std::uint64_t nanoseconds;
+    char const* seconds;
+};
+
+static constexpr metrics_bound_t metrics_latency_bounds_k[] = {
+    {1'000, "0.000001"},  {5'000, "0.000005"},  {10'000, "0.00001"},     {50'000, "0.00005"},
+    {100'000, "0.0001"},  {500'000, "0.0005"},  {1'000'000, "0.001"},    {5'000'000, "0.005"},
+    {10'000'000, "0.01"}, {50'000'000, "0.05"}, {100'000'000, "0.1"},    {500'000'000, "0.5"},
+    {1'000'000'000, "1"}, {5'000'000'000, "5"}, {10'000'000'000, "10"},
+};
+static constexpr std::size_t metrics_latency_bounds_count_k =
+    sizeof(metrics_latency_bounds_k) / sizeof(metrics_latency_bounds_k[0]);
+
+/**
+ * @brief Checks if @p input starts with a complete HTTP `GET` request for @p path, with an optional query string.
+ * Nothing past the method is looked at, until the request line has fully arrived. Incomplete requests
+ * are left to the protocol, and are checked again once more data arrives.
+ * @return The length of the request, or zero if it isn't a complete scrape.
+ */
+inline std::size_t metrics_request_length(std::string_view input, std::string_view path) noexcept {
+    constexpr std::string_view method_k = "GET ";
+    if (path.empty() || input.substr(0, method_k.size()) != method_k)
+        return 0;
+    std::size_t line_length = input.find("\r\n");
+    if (line_length == std::string_view::npos || line_length <= method_k.size() + path.size())
+        return 0;
+    if (input.substr(method_k.size(), path.size()) != path)
+        return 0;
+    char next = input[method_k.size() + path.size()];
+    std::size_t headers_end = input.find("\r\n\r\n", line_length);
+    if ((next != ' ' && next != '?') || headers_end == std::string_view::npos)
+        return 0;
+    return headers_end + 4;
+}
+
+/// @brief Appends a formatted line to the outputs, truncating it, if it's longer than a page.
+inline bool append_metric(exchange_pipes_t& pipes, char const* format, ...) noexcept {
+    char line[ram_page_size_k];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (len < 0)
+        return false;
+    return pipes.append_outputs({line, (std::min)(static_cast<std::size_t>(len), sizeof(line) - 1)});
+}
+
+/// @brief Escapes a method name to be used as a label value, truncating it if it doesn't fit.
+inline std::string_view escape_metric_label(std::string_view name, char* buffer, std::size_t capacity) noexcept {
+    std::size_t length = 0;
+    for (char c : name) {
+        bool is_special = c == '\\' || c == '"' || c == '\n';
+        if (length + is_special + 1 > capacity)
+            break;
+        if (is_special)
+            buffer[length++] = '\\';
+        buffer[length++] = c == '\n' ? 'n' : c;
+    }
+    return {buffer, length};
+}
+
+/**
+ * @brief Prints one histogram sample per method, with cumulative counts for every bound.
+ * Shards are only read, so the polling threads keep recording while the scrape is rendered.
+ */
+inline bool append_method_histograms(exchange_pipes_t& pipes, engine_t& engine, char const* name,
+                                     char const* help, owned_method_histogram_t method_shard_t::*member) noexcept {
+    using layout_t = owned_method_histogram_t::layout_t;
+    bool ok = append_metric(pipes, "# TYPE %s histogram\n# UNIT %s seconds\n# HELP %s %s\n", name, name, name, help);
+    for (named_callback_t const& named : engine.callbacks) {
+        if (!named.stats)
+            continue;
+
+        std::uint64_t counts[metrics_latency_bounds_count_k + 1]{};
+        std::uint64_t sum = 0;
+        for (std::size_t j = 0; j != named.stats->shards_count; ++j) {
+            owned_method_histogram_t const& histogram = named.stats->shards[j].*member;
+            sum += histogram.sum();
+            for (std::size_t i = 0; i != layout_t::buckets_k; ++i) {
+                std::uint64_t count = histogram.bucket(i);
+                if (!count)
+                    continue;
+                std::size_t bound = 0;
+                while (bound != metrics_latency_bounds_count_k &&
+                       i > layout_t::index_of(metrics_latency_bounds_k[bound].nanoseconds))
+                    ++bound;
+                counts[bound] += count;
+            }
+        }
+
+        char label_buffer[256];
+        std::string_view label = escape_metric_label(named.name, label_buffer, sizeof(label_buffer));
+        int label_len = static_cast<int>(label.size());
+        std::uint64_t cumulative = 0;
+        for (std::size_t bound = 0; bound != metrics_latency_bounds_count_k; ++bound) {
+            cumulative += counts[bound];
+            ok &= append_metric(pipes, "%s_bucket{method=\"%.*s\",le=\"%s\"} %zu\n", name, label_len, label.data(),
+                                metrics_latency_bounds_k[bound].seconds, static_cast<std::size_t>(cumulative));
+        }
+        cumulative += counts[metrics_latency_bounds_count_k];
+        ok &= append_metric(pipes,
+                            "%s_bucket{method=\"%.*s\",le=\"+Inf\"} %zu\n"
+                            "%s_count{method=\"%.*s\"} %zu\n"
+                            "%s_sum{method=\"%.*s\"} %.9f\n",
+                            name, label_len, label.data(), static_cast<std::size_t>(cumulative), //
+                            name, label_len, label.data(), static_cast<std::size_t>(cumulative), //
+                            name, label_len, label.data(), sum / 1e9);
+    }
+    return ok;
+}
+
+/**
+ * @brief Renders the counters, gauges and latency histograms of the server in the OpenMetrics text format,
+ * as a complete HTTP response. Counters are never reset, unlike the ones printed into the logs,
+ * so any number of scrapers can poll independently.
+ */
+inline bool append_metrics(exchange_pipes_t& pipes, server_t& server) noexcept {
+    stats_totals_t totals = server.stats.total();
+    std::size_t active = server.active_connections.load(std::memory_order_relaxed);
+    std::size_t capacity = server.connections.capacity();
+    std::size_t buffer_bytes = server.connection_buffer_bytes;
+
+    bool ok = pipes.append_outputs(metrics_header_k);
+    std::size_t body_offset = pipes.output_span().size();
+    ok &= append_metric( //
+        pipes,
+        "# TYPE ucall_connections_accepted counter\n"
+        "# HELP ucall_connections_accepted Connections accepted since the start.\n"
+        "ucall_connections_accepted_total %zu\n"
+        "# TYPE ucall_connections_closed counter\n"
+        "# HELP ucall_connections_closed Connections closed since the start.\n"
+        "ucall_connections_closed_total %zu\n"
+        "# TYPE ucall_received_bytes counter\n"
+        "# UNIT ucall_received_bytes bytes\n"
+        "# HELP ucall_received_bytes Bytes received, before decryption.\n"
+        "ucall_received_bytes_total %zu\n"
+        "# TYPE ucall_sent_bytes counter\n"
+        "# UNIT ucall_sent_bytes bytes\n"
+        "# HELP ucall_sent_bytes Bytes sent, after encryption.\n"
+        "ucall_sent_bytes_total %zu\n"
+        "# TYPE ucall_received_packets counter\n"
+        "# HELP ucall_received_packets Completed receive operations.\n"
+        "ucall_received_packets_total %zu\n"
+        "# TYPE ucall_sent_packets counter\n"
+        "# HELP ucall_sent_packets Completed send operations.\n"
+        "ucall_sent_packets_total %zu\n"
+        "# TYPE ucall_connections_active gauge\n"
+        "# HELP ucall_connections_active Connections currently open.\n"
+        "ucall_connections_active %zu\n"
+        "# TYPE ucall_connections_capacity gauge\n"
+        "# HELP ucall_connections_capacity Size of the connections pool.\n"
+        "ucall_connections_capacity %zu\n"
+        "# TYPE ucall_fixed_buffers_bytes gauge\n"
+        "# UNIT ucall_fixed_buffers_bytes bytes\n"
+        "# HELP ucall_fixed_buffers_bytes Pre-allocated input and output buffers of all connections.\n"
+        "ucall_fixed_buffers_bytes %zu\n"
+        "# TYPE ucall_fixed_buffers_used_bytes gauge\n"
+        "# UNIT ucall_fixed_buffers_used_bytes bytes\n"
+        "# HELP ucall_fixed_buffers_used_bytes Pre-allocated buffers of open connections.\n"
+        "ucall_fixed_buffers_used_bytes %zu\n"
+        "# TYPE ucall_deferred_replies_pending gauge\n"
+        "# HELP ucall_deferred_replies_pending Deferred replies submitted, but not yet sent.\n"
+        "ucall_deferred_replies_pending %zu\n",
+        totals.added_connections, totals.closed_connections,                               //
+        totals.bytes_received, totals.bytes_sent, totals.packets_received, totals.packets_sent, //
+        active, capacity, capacity * buffer_bytes * 2u, active * buffer_bytes * 2u,         //
+        server.deferred_replies_count.load(std::memory_order_relaxed)                       //
+    );
+    ok &= append_method_histograms(pipes, server.engine, "ucall_method_callback_seconds",
+                                   "Time spent in the callback of every method.", &method_shard_t::callback_ns);
+    ok &= append_method_histograms(pipes, server.engine, "ucall_method_request_seconds",
+                                   "Time from the arrival of a request to its reply being sent.",
+                                   &method_shard_t::request_ns);
+    ok &= pipes.append_outputs("# EOF\n");
+    if (!ok)
+        return false;
+
+    auto output = pipes.output_span();
+    auto res = std::to_chars(output.data() + metrics_header_length_offset_k,
+                             output.data() + metrics_header_length_offset_k + metrics_header_length_capacity_k,
+                             output.size() - body_offset);
+    return res.ec == std::errc();
+}
+
+} // namespace unum::ucall
@@ -14,6 +14,8 @@ struct network_engine_t {
     void send_packet(connection_t&, void*, std::size_t, std::size_t) noexcept;
     void recv_packet(connection_t&, void*, std::size_t, std::size_t) noexcept;
     void close_connection_gracefully(connection_t&) noexcept;
+    /// @brief Wakes up threads blocked in `pop_completed_events`, if the backend ever blocks.
+    void interrupt() noexcept;
 
     bool is_canceled(ssize_t, connection_t const&) noexcept;
     bool is_corrupted(ssize_t, connection_t const&) noexcept;
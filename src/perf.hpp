@@ -0,0 +1,128 @@
+#pragma once
+
+#include "globals.hpp"
+
+#if defined(UCALL_IS_LINUX)
+#include <linux/perf_event.h> // `perf_event_attr`
+#include <sys/ioctl.h>        // `ioctl`
+#include <sys/syscall.h>      // `SYS_perf_event_open`
+#include <unistd.h>           // `syscall`, `read`, `close`
+#endif
+
+#include <cstdint> // `std::uint64_t`
+
+namespace unum::ucall {
+
+/// @brief Hardware events counted around sampled callbacks, in the order they are stored.
+enum perf_counter_t : std::size_t {
+    perf_cycles_k = 0,
+    perf_instructions_k,
+    perf_l1d_misses_k,
+    perf_llc_misses_k,
+    perf_branch_misses_k,
+    perf_counters_k,
+};
+
+struct perf_sample_t {
+    std::uint64_t values[perf_counters_k]{};
+};
+
+/**
+ * @brief Group of hardware counters of the polling thread, that has opened it, read with a single `read`.
+ * Counts only the user-space part of the thread, which is enough for callbacks, and is allowed
+ * with the default `perf_event_paranoid`. Events that the CPU or the hypervisor don't support
+ * are left out, and always read as zeros.
+ */
+class perf_group_t {
+    int descriptors_[perf_counters_k]{-1, -1, -1, -1, -1};
+    /// @brief The first event that could be opened, reading the whole group.
+    int leader_{-1};
+    /// @brief Position of every counter in the group, or `perf_counters_k` if it's missing.
+    std::size_t positions_[perf_counters_k]{};
+    std::size_t opened_count_{};
+    std::uint32_t calls_until_sample_{};
+    bool tried_{};
+
+#if defined(UCALL_IS_LINUX)
+    static int open_event(std::uint32_t type, std::uint64_t config, int group_descriptor) noexcept {
+        perf_event_attr attributes{};
+        attributes.size = sizeof(attributes);
+        attributes.type = type;
+        attributes.config = config;
+        attributes.disabled = group_descriptor < 0;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, group_descriptor, 0));
+    }
+#endif
+
+  public:
+    perf_group_t() = default;
+    perf_group_t(perf_group_t const&) = delete;
+    perf_group_t& operator=(perf_group_t const&) = delete;
+    ~perf_group_t() noexcept {
+#if defined(UCALL_IS_LINUX)
+        for (int descriptor : descriptors_)
+            if (descriptor >= 0)
+                close(descriptor);
+#endif
+    }
+
+    /**
+     * @brief Counts down the calls of this thread, returning true for every @p rate -th one.
+     * The group is opened on the first sampled call, so that it measures the calling thread.
+     */
+    bool should_sample(std::uint32_t rate) noexcept {
+        if (calls_until_sample_) {
+            --calls_until_sample_;
+            return false;
+        }
+        calls_until_sample_ = rate - 1;
+        if (!tried_)
+            open();
+        return opened_count_ != 0;
+    }
+
+    void open() noexcept {
+        tried_ = true;
+#if defined(UCALL_IS_LINUX)
+        static constexpr std::uint64_t l1d_read_miss_k = PERF_COUNT_HW_CACHE_L1D |
+                                                         (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        struct {
+            std::uint32_t type;
+            std::uint64_t config;
+        } const events[perf_counters_k] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},   {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, l1d_read_miss_k},           {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        };
+        for (std::size_t i = 0; i != perf_counters_k; ++i) {
+            descriptors_[i] = open_event(events[i].type, events[i].config, leader_);
+            positions_[i] = descriptors_[i] >= 0 ? opened_count_++ : perf_counters_k;
+            if (leader_ < 0)
+                leader_ = descriptors_[i];
+        }
+        if (leader_ >= 0)
+            ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    bool read(perf_sample_t& sample) noexcept {
+#if defined(UCALL_IS_LINUX)
+        // With `PERF_FORMAT_GROUP`, the leader reports the number of events, followed by their values.
+        std::uint64_t buffer[1 + perf_counters_k];
+        if (leader_ < 0 || ::read(leader_, buffer, sizeof(buffer)) <= 0)
+            return false;
+        for (std::size_t i = 0; i != perf_counters_k; ++i)
+            sample.values[i] = positions_[i] < buffer[0] ? buffer[1 + positions_[i]] : 0;
+        return true;
+#else
+        (void)sample;
+        return false;
+#endif
+    }
+};
+
+} // namespace unum::ucall
@@ -0,0 +1,38 @@
+#pragma once
+
+/**
+ * Statically defined tracepoints of the request lifecycle, under the "ucall" provider.
+ * With SystemTap headers installed, every probe compiles into a single `nop`, with its
+ * arguments described in an ELF note, so `bpftrace` or `perf` can attach without rebuilding.
+ * Without them, or with `UCALL_DISABLE_PROBES`, probes compile into nothing.
+ *
+ *  - `accept(connection, descriptor)`
+ *  - `receive(connection, bytes)`
+ *  - `parse_start(connection, bytes)`
+ *  - `parse_end(connection, error_code)`, where zero means the request is well-formed.
+ *  - `dispatch(connection, method, method_length)`
+ *  - `reply(connection, method, method_length, bytes)`, once the callback has appended its reply,
+ *    or on the submitting thread, once a deferred reply is submitted.
+ *  - `send(connection, bytes)`
+ *  - `close(connection)`
+ *
+ * The connection is its offset in the pool, which is reused once the connection is closed.
+ */
+#if !defined(UCALL_DISABLE_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define UCALL_HAS_PROBES
+#endif
+#endif
+
+#if defined(UCALL_HAS_PROBES)
+#define UCALL_PROBE1(name, a) DTRACE_PROBE1(ucall, name, a)
+#define UCALL_PROBE2(name, a, b) DTRACE_PROBE2(ucall, name, a, b)
+#define UCALL_PROBE3(name, a, b, c) DTRACE_PROBE3(ucall, name, a, b, c)
+#define UCALL_PROBE4(name, a, b, c, d) DTRACE_PROBE4(ucall, name, a, b, c, d)
+#else
+#define UCALL_PROBE1(name, a)
+#define UCALL_PROBE2(name, a, b)
+#define UCALL_PROBE3(name, a, b, c)
+#define UCALL_PROBE4(name, a, b, c, d)
+#endif
@@ -32,6 +32,9 @@ class protocol_t {
     any_param_t get_param(size_t) const noexcept;
     any_param_t get_param(std::string_view) const noexcept;
     std::string_view get_header(std::string_view) const noexcept;
+    std::string_view get_traceparent() const noexcept;
+    bool is_batch() const noexcept;
+    allocations_t take_parser_allocations() noexcept;
 
     void prepare_response(exchange_pipes_t&) noexcept;
     bool append_response(exchange_pipes_t&, std::string_view) noexcept;
@@ -39,6 +42,8 @@ class protocol_t {
     void finalize_response(exchange_pipes_t&) noexcept;
 
     bool is_input_complete(span_gt<char>) noexcept;
+    /// @brief Length of the first request in the input, once `is_input_complete` has found it.
+    std::size_t request_length() const noexcept;
 
     std::optional<default_error_t> parse_headers(std::string_view) noexcept;
     std::optional<default_error_t> parse_content() noexcept;
@@ -172,6 +177,54 @@ inline std::string_view protocol_t::get_header(std::string_view header_name) con
     return std::string_view();
 }
 
+/**
+ * @brief W3C trace context of the current call, from the "traceparent" member of a JSON-RPC call,
+ * which is the only option over raw TCP, or from the HTTP header of the same name.
+ */
+inline std::string_view protocol_t::get_traceparent() const noexcept {
+    switch (protocol_type_) {
+    case protocol_type_t::jsonrpc_tcp_k:
+        return std::get<protocol_jsonrpc_t<protocol_tcp_t>>(protocol_variant_).get_traceparent();
+    case protocol_type_t::jsonrpc_http_k:
+        return std::get<protocol_jsonrpc_t<http_protocol_t>>(protocol_variant_).get_traceparent();
+    default: {
+        // Header names are case-insensitive, and some clients capitalize them.
+        std::string_view traceparent = get_header("traceparent");
+        return traceparent.size() ? traceparent : get_header("Traceparent");
+    }
+    }
+}
+
+/**
+ * @brief Checks if several calls arrived in one request, which is only possible with JSON-RPC.
+ */
+inline bool protocol_t::is_batch() const noexcept {
+    switch (protocol_type_) {
+    case protocol_type_t::jsonrpc_tcp_k:
+        return std::get<protocol_jsonrpc_t<protocol_tcp_t>>(protocol_variant_).is_batch();
+    case protocol_type_t::jsonrpc_http_k:
+        return std::get<protocol_jsonrpc_t<http_protocol_t>>(protocol_variant_).is_batch();
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Growths of the JSON parser since the previous call, which only the JSON-based protocols have.
+ */
+inline allocations_t protocol_t::take_parser_allocations() noexcept {
+    switch (protocol_type_) {
+    case protocol_type_t::jsonrpc_tcp_k:
+        return std::exchange(std::get<protocol_jsonrpc_t<protocol_tcp_t>>(protocol_variant_).parser_allocations, {});
+    case protocol_type_t::jsonrpc_http_k:
+        return std::exchange(std::get<protocol_jsonrpc_t<http_protocol_t>>(protocol_variant_).parser_allocations, {});
+    case protocol_type_t::rest_k:
+        return std::exchange(std::get<protocol_rest_t>(protocol_variant_).parser_allocations, {});
+    default:
+        return {};
+    }
+}
+
 void protocol_t::prepare_response(exchange_pipes_t& pipes) noexcept {
     switch (protocol_type_) {
     case protocol_type_t::tcp_k:
@@ -253,6 +306,22 @@ bool protocol_t::is_input_complete(span_gt<char> input) noexcept {
     return true;
 }
 
+std::size_t protocol_t::request_length() const noexcept {
+    switch (protocol_type_) {
+    case protocol_type_t::tcp_k:
+        return std::get<protocol_tcp_t>(protocol_variant_).request_length();
+    case protocol_type_t::http_k:
+        return std::get<http_protocol_t>(protocol_variant_).request_length();
+    case protocol_type_t::jsonrpc_tcp_k:
+        return std::get<protocol_jsonrpc_t<protocol_tcp_t>>(protocol_variant_).request_length();
+    case protocol_type_t::jsonrpc_http_k:
+        return std::get<protocol_jsonrpc_t<http_protocol_t>>(protocol_variant_).request_length();
+    case protocol_type_t::rest_k:
+        return std::get<protocol_rest_t>(protocol_variant_).request_length();
+    }
+    return 0;
+}
+
 std::optional<default_error_t> protocol_t::parse_headers(std::string_view body) noexcept {
     switch (protocol_type_) {
     case protocol_type_t::tcp_k:
@@ -28,6 +28,9 @@ struct http_protocol_t {
     phr_header headers[http_max_headers_k]{};
     size_t count_headers = http_max_headers_k;
 
+    /// @brief Length of the first complete request, including its headers. Valid after `is_input_complete`.
+    std::size_t request_length() const noexcept { return content_length.value_or(0); }
+
     std::string_view get_content() const noexcept;
     request_type_t get_request_type() const noexcept;
     any_param_t get_param(size_t) const noexcept;
@@ -158,6 +161,8 @@ inline std::optional<default_error_t> http_protocol_t::parse_headers(std::string
     else
         return default_error_t{405, "Unsupported request type"};
 
+    // Pipelined requests reuse the protocol, and may omit the headers of the previous one.
+    parsed.content_type = {}, parsed.content_length = {};
     for (std::size_t i = 0; i < count_headers; ++i) {
         if (headers[i].name_len == 0)
             continue;
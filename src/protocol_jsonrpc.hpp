@@ -24,6 +24,8 @@ template <typename base_protocol_t> struct protocol_jsonrpc_t {
     base_protocol_t base_protocol{};
     jsonrpc_object_t active_request{};
     sjd::parser parser{};
+    /// @brief Growths of the `parser`, measured in the bytes of documents it can fit.
+    allocations_t parser_allocations{};
     std::variant<sjd::element, sjd::array> elements{};
 
     inline any_param_t as_variant(sj::simdjson_result<sjd::element> const& elm) const noexcept;
@@ -37,8 +39,12 @@ template <typename base_protocol_t> struct protocol_jsonrpc_t {
 
     std::string_view get_header(std::string_view) const noexcept;
 
+    std::string_view get_traceparent() const noexcept;
+
     std::optional<default_error_t> set_to(sjd::element const&) noexcept;
 
+    bool is_batch() const noexcept { return std::holds_alternative<sjd::array>(elements); }
+
     inline void prepare_response(exchange_pipes_t& pipes) noexcept;
 
     bool append_response(exchange_pipes_t&, std::string_view) noexcept;
@@ -47,6 +53,7 @@ template <typename base_protocol_t> struct protocol_jsonrpc_t {
     inline void finalize_response(exchange_pipes_t& pipes) noexcept;
 
     bool is_input_complete(span_gt<char> input) noexcept;
+    std::size_t request_length() const noexcept { return base_protocol.request_length(); }
 
     inline void reset() noexcept;
 
@@ -127,6 +134,8 @@ bool protocol_jsonrpc_t<base_protocol_t>::is_input_complete(span_gt<char> input)
 
 template <typename base_protocol_t> void protocol_jsonrpc_t<base_protocol_t>::reset() noexcept {
     base_protocol.reset();
+    // Forget the previous batch, in case the next request fails before it's parsed.
+    elements.template emplace<sjd::element>();
 }
 
 template <typename base_protocol_t>
@@ -143,6 +152,7 @@ inline std::optional<default_error_t> protocol_jsonrpc_t<base_protocol_t>::parse
         if (parser.allocate(json_doc.size(), json_doc.size() / 2) != sj::SUCCESS)
             return default_error_t{-32000, "Out of memory"};
         parser.set_max_capacity(json_doc.size());
+        parser_allocations.record(json_doc.size());
     }
 
     auto one_or_many = parser.parse(json_doc.data(), json_doc.size(), false);
@@ -213,6 +223,16 @@ inline std::string_view protocol_jsonrpc_t<base_protocol_t>::get_header(std::str
     return base_protocol.get_header(header_name);
 }
 
+template <typename base_protocol_t>
+inline std::string_view protocol_jsonrpc_t<base_protocol_t>::get_traceparent() const noexcept {
+    // Every call of a batch may belong to a different trace, so the member of the call comes first.
+    sj::simdjson_result<sjd::element> member = active_request.element["traceparent"];
+    if (member.is_string())
+        return member.get_string().value_unsafe();
+    std::string_view traceparent = base_protocol.get_header("traceparent");
+    return traceparent.size() ? traceparent : base_protocol.get_header("Traceparent");
+}
+
 template <typename base_protocol_t>
 std::optional<default_error_t> protocol_jsonrpc_t<base_protocol_t>::set_to(sjd::element const& doc) noexcept {
     if (!doc.is_object())
@@ -25,6 +25,8 @@ struct protocol_rest_t {
     http_protocol_t base_protocol{};
     request_rest_t active_request{};
     sjd::parser parser{};
+    /// @brief Growths of the `parser`, measured in the bytes of documents it can fit.
+    allocations_t parser_allocations{};
     std::variant<std::nullptr_t, sjd::element, sjd::array> elements{};
 
     inline any_param_t as_variant(sj::simdjson_result<sjd::element> const& elm) const noexcept;
@@ -46,6 +48,7 @@ struct protocol_rest_t {
     inline void finalize_response(exchange_pipes_t& pipes) noexcept;
 
     bool is_input_complete(span_gt<char> input) noexcept;
+    std::size_t request_length() const noexcept { return base_protocol.request_length(); }
 
     inline void reset() noexcept;
 
@@ -109,6 +112,7 @@ inline std::optional<default_error_t> protocol_rest_t::parse_content() noexcept
         if (parser.allocate(json_doc.size(), json_doc.size() / 2) != sj::SUCCESS)
             return default_error_t{500, "Out of memory"};
         parser.set_max_capacity(json_doc.size());
+        parser_allocations.record(json_doc.size());
     }
 
     auto one_or_many = parser.parse(json_doc.data(), json_doc.size(), false);
@@ -11,6 +11,10 @@ struct protocol_tcp_t {
     static constexpr char tcp_termination_symbol_k = '\0';
     /// @brief Active parsed request
     parsed_request_t parsed{};
+    /// @brief Length of the first complete request, including its terminator.
+    std::size_t complete_length{};
+
+    std::size_t request_length() const noexcept { return complete_length; }
 
     std::string_view get_content() const noexcept;
     request_type_t get_request_type() const noexcept;
@@ -64,10 +68,13 @@ inline void protocol_tcp_t::finalize_response(exchange_pipes_t& pipes) noexcept
 }
 
 bool protocol_tcp_t::is_input_complete(span_gt<char> input) noexcept {
-    return input[input.size() - 1] == tcp_termination_symbol_k;
+    // Pipelined requests may follow the first one, so the last symbol isn't enough.
+    auto end = static_cast<char const*>(std::memchr(input.data(), tcp_termination_symbol_k, input.size()));
+    complete_length = end ? end - input.data() + 1 : 0;
+    return end;
 }
 
-void protocol_tcp_t::reset() noexcept {}
+void protocol_tcp_t::reset() noexcept { complete_length = 0; }
 
 std::optional<default_error_t> protocol_tcp_t::parse_headers(std::string_view body) noexcept {
     parsed.body = body;
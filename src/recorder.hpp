@@ -0,0 +1,181 @@
+#pragma once
+
+#include <unistd.h> // `write`
+
+#include <atomic>  // `std::atomic`
+#include <cstdint> // `std::uint64_t`
+#include <cstring> // `std::memmove`
+#include <memory>  // `std::unique_ptr`
+#include <new>     // `std::nothrow`
+#include <stdio.h> // `std::snprintf`
+
+#include "globals.hpp"
+
+namespace unum::ucall {
+
+/// @brief Events remembered by every polling thread. Must be a power of two.
+static constexpr std::size_t flight_ring_capacity_k = 1024;
+/// @brief Longest printed event.
+static constexpr std::size_t flight_line_capacity_k = 256;
+
+/**
+ * @brief Steps of the connection state machine, worth remembering when debugging tail latencies.
+ * Most match the stage entered by `automata_t`, while handshakes and dispatches happen within one.
+ */
+enum class flight_step_t : std::uint8_t {
+    accept_k,
+    receive_k,
+    handshake_k,
+    dispatch_k,
+    respond_k,
+    deferred_reply_k,
+    close_k,
+};
+
+inline char const* flight_step_name(flight_step_t step) noexcept {
+    switch (step) {
+    case flight_step_t::accept_k: return "accept";
+    case flight_step_t::receive_k: return "receive";
+    case flight_step_t::handshake_k: return "handshake";
+    case flight_step_t::dispatch_k: return "dispatch";
+    case flight_step_t::respond_k: return "respond";
+    case flight_step_t::deferred_reply_k: return "deferred_reply";
+    case flight_step_t::close_k: return "close";
+    }
+    return "unknown";
+}
+
+struct flight_event_t {
+    std::uint64_t timestamp_ns;
+    /// @brief Offset of the connection in the pool, reused once the connection is released.
+    std::uint32_t connection;
+    /// @brief The completion result, that triggered the step, like the number of bytes received.
+    std::int32_t result;
+    flight_step_t step;
+};
+
+/**
+ * @brief Last events of a single polling thread, overwritten in a circle.
+ * Recording is a plain store and a release of the head, with no locks or locked instructions.
+ * Readers may race with the writer, so they discard the events that were overwritten while copied.
+ */
+class alignas(64) flight_ring_t {
+    std::atomic<std::uint64_t> head_{};
+    flight_event_t events_[flight_ring_capacity_k]{};
+
+  public:
+    void record(flight_event_t const& event) noexcept {
+        std::uint64_t head = head_.load(std::memory_order_relaxed);
+        events_[head % flight_ring_capacity_k] = event;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copies the retained events into @p output in chronological order.
+     * @return The number of events copied, at most `flight_ring_capacity_k`.
+     */
+    std::size_t snapshot(flight_event_t* output) const noexcept {
+        std::uint64_t head = head_.load(std::memory_order_acquire);
+        std::uint64_t first = head > flight_ring_capacity_k ? head - flight_ring_capacity_k : 0;
+        for (std::uint64_t i = first; i != head; ++i)
+            output[i - first] = events_[i % flight_ring_capacity_k];
+        // Anything the writer has reached in the meantime may be torn.
+        std::uint64_t head_after = head_.load(std::memory_order_acquire);
+        std::uint64_t overwritten = head_after > flight_ring_capacity_k ? head_after - flight_ring_capacity_k : 0;
+        if (overwritten <= first)
+            return head - first;
+        if (overwritten >= head)
+            return 0;
+        std::size_t skipped = overwritten - first;
+        std::memmove(output, output + skipped, (head - overwritten) * sizeof(flight_event_t));
+        return head - overwritten;
+    }
+};
+
+/**
+ * @brief Always-on recorder of connection state transitions, one ring per polling thread.
+ * Dumped on demand with `ucall_dump_flight_recorder()`, on a signal, or for every request slower
+ * than a threshold, with only the events of its connection since the request has arrived.
+ */
+struct flight_recorder_t {
+    std::unique_ptr<flight_ring_t[]> rings{};
+    std::size_t rings_count{};
+
+    /// @brief Set from a signal handler, and served by the first polling thread.
+    inline static std::atomic<bool> dump_requested{};
+    static void request_dump(int) noexcept { dump_requested.store(true, std::memory_order_relaxed); }
+
+    void record(std::size_t thread_idx, flight_step_t step, std::uint32_t connection, ssize_t result,
+                std::uint64_t timestamp_ns) noexcept {
+        rings[thread_idx].record({timestamp_ns, connection, static_cast<std::int32_t>(result), step});
+    }
+
+    /**
+     * @brief Prints the events of every thread into @p file_descriptor, one per line.
+     * @param connection If not `UINT32_MAX`, only the events of this connection are printed.
+     * @param since_ns Events before this time are skipped.
+     * @param until_ns Events after this time are skipped.
+     */
+    void dump(int file_descriptor, bool json, std::uint32_t connection = UINT32_MAX, std::uint64_t since_ns = 0,
+              std::uint64_t until_ns = UINT64_MAX) const noexcept {
+        char buffer[ram_page_size_k];
+        std::size_t length = 0;
+        for_each_event(connection, since_ns, until_ns, [&](std::size_t thread_idx, flight_event_t const& event) {
+            if (length + flight_line_capacity_k > sizeof(buffer)) {
+                [[maybe_unused]] ssize_t written = write(file_descriptor, buffer, length);
+                length = 0;
+            }
+            length += print_event(buffer + length, sizeof(buffer) - length, json, thread_idx, event);
+        });
+        if (length) {
+            [[maybe_unused]] ssize_t written = write(file_descriptor, buffer, length);
+        }
+    }
+
+    /**
+     * @brief Prints the events of every thread into @p buffer, one per line, as many as fit its @p capacity.
+     * Takes the same filters, as `dump`. @return The number of bytes printed.
+     */
+    std::size_t print(char* buffer, std::size_t capacity, bool json, std::uint32_t connection = UINT32_MAX,
+                      std::uint64_t since_ns = 0, std::uint64_t until_ns = UINT64_MAX) const noexcept {
+        std::size_t length = 0;
+        for_each_event(connection, since_ns, until_ns, [&](std::size_t thread_idx, flight_event_t const& event) {
+            length += print_event(buffer + length, capacity - length, json, thread_idx, event);
+        });
+        return length;
+    }
+
+  private:
+    template <typename callback_at>
+    void for_each_event(std::uint32_t connection, std::uint64_t since_ns, std::uint64_t until_ns,
+                        callback_at&& callback) const noexcept {
+        std::unique_ptr<flight_event_t[]> events{new (std::nothrow) flight_event_t[flight_ring_capacity_k]};
+        if (!events)
+            return;
+
+        for (std::size_t thread_idx = 0; thread_idx != rings_count; ++thread_idx) {
+            std::size_t count = rings[thread_idx].snapshot(events.get());
+            for (std::size_t i = 0; i != count; ++i) {
+                flight_event_t const& event = events[i];
+                if (event.timestamp_ns < since_ns || event.timestamp_ns > until_ns ||
+                    (connection != UINT32_MAX && event.connection != connection))
+                    continue;
+                callback(thread_idx, event);
+            }
+        }
+    }
+
+    /// @brief Prints a single line, or nothing, if it doesn't fit into @p capacity.
+    static std::size_t print_event(char* buffer, std::size_t capacity, bool json, std::size_t thread_idx,
+                                   flight_event_t const& event) noexcept {
+        auto format = json ? R"({"flight":{"thread":%zu,"connection":%u,"ns":%llu,"step":"%s","result":%d}})"
+                             "\n"
+                           : "flight: thread %zu, connection %u, at %llu ns, %s, result %d \n";
+        auto printed = snprintf(buffer, capacity, format, thread_idx, event.connection,
+                                static_cast<unsigned long long>(event.timestamp_ns), flight_step_name(event.step),
+                                event.result);
+        return printed < 0 || static_cast<std::size_t>(printed) >= capacity ? 0 : static_cast<std::size_t>(printed);
+    }
+};
+
+} // namespace unum::ucall
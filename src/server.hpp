@@ -1,10 +1,18 @@
 #pragma once
 
+#include <csignal> // `sigaction`
+
+#include "access.hpp"
+#include "allocations.hpp"
+#include "capture.hpp"
 #include "connection.hpp"
 #include "containers.hpp"
 #include "engine.hpp"
 #include "network.hpp"
+#include "recorder.hpp"
 #include "shared.hpp"
+#include "slowlog.hpp"
+#include "transport.hpp"
 
 namespace unum::ucall {
 
@@ -14,16 +22,36 @@ struct server_t {
     engine_t engine{};
     protocol_type_t protocol_type{};
     std::unique_ptr<ssl_context_t> ssl_ctx{};
+    std::unique_ptr<capture_log_t> capture{};
 
     std::atomic<std::size_t> active_connections{};
     std::uint32_t max_lifetime_micro_seconds{};
     std::uint32_t max_lifetime_exchanges{};
+    /// @brief Size of each of the two pre-allocated buffers of every connection.
+    std::size_t connection_buffer_bytes{ram_page_size_k};
 
     stats_t stats{};
+    transport_stats_t transport{};
+    allocation_stats_t allocations{};
     connection_t stats_pseudo_connection{};
+    flight_recorder_t recorder{};
+    /// @brief Requests slower than this are logged with their flight recorder events, unless zero.
+    std::uint64_t slow_request_ns{};
+    /// @brief Declared after the `recorder`, so that its writer thread is stopped first.
+    slow_request_log_t slow_requests{};
+    access_log_t access_log{};
+    span_exporter_t spans{};
 
     std::int32_t logs_file_descriptor{};
     std::string_view logs_format{};
+    std::uint64_t logs_period_ns{};
+    /// @brief Path of the OpenMetrics endpoint, like "/metrics", or empty if disabled.
+    std::string_view metrics_path{};
+    /// @brief Signal dumping the flight recorder, if its handler was installed, and the one it replaced.
+    int flight_dump_signal{};
+#if !defined(UCALL_IS_WINDOWS)
+    struct sigaction previous_flight_dump_action {};
+#endif
 
     /// @brief A circular container of reusable connections. Can be in millions.
     pool_gt<connection_t> connections{};
@@ -32,36 +60,292 @@ struct server_t {
     /// @brief Pre-allocated buffered to be submitted for shared use.
     memory_map_t fixed_buffers{};
 
+    /// @brief Connections with deferred replies, submitted from foreign threads and ready to be sent.
+    /// Every connection can have at most one, so it's pre-allocated for all of them.
+    array_gt<connection_t*> deferred_replies{};
+    mutex_t deferred_replies_mutex{};
+    std::atomic<std::size_t> deferred_replies_count{};
+
+    ~server_t() noexcept;
+    bool allocate_features(ucall_config_t const&) noexcept;
+    void start_features(ucall_config_t const&) noexcept;
     void submit_stats_heartbeat() noexcept;
-    void release_connection(connection_t&) noexcept;
+    void release_connection(connection_t&, std::uint16_t thread_idx) noexcept;
     void log_and_reset_stats() noexcept;
+    void log_slow_request(connection_t&, std::uint16_t thread_idx, std::uint64_t now_ns) noexcept;
+    void record_transport(connection_t&, std::uint16_t thread_idx) noexcept;
+    void record_allocations(connection_t&, std::uint16_t thread_idx) noexcept;
+    void log_access(connection_t&, std::uint16_t thread_idx, std::uint64_t now_ns, std::uint64_t latency_ns) noexcept;
+    void export_span(connection_t&, std::uint16_t thread_idx, std::uint64_t now_ns) noexcept;
+    int flight_dump_descriptor() const noexcept;
     bool consider_accepting_new_connection() noexcept;
+    void submit_deferred_reply(connection_t&) noexcept;
+    template <std::size_t max_count_ak> std::size_t pop_deferred_replies(connection_t**) noexcept;
 };
 
+/**
+ * @brief Allocates the per-thread state of the optional features in @p config, shared by all the backends.
+ * Only the enabled features get their shards, and the disabled ones are left with none.
+ * @return False if memory or the capture file couldn't be obtained, leaving the cleanup to the destructor.
+ */
+bool server_t::allocate_features(ucall_config_t const& config) noexcept {
+    std::size_t threads = config.max_threads;
+    engine.threads_count = threads;
+    if (!deferred_replies.reserve(config.max_concurrent_connections))
+        return false;
+
+    stats.shards.reset(new (std::nothrow) stats_shard_t[threads]);
+    allocations.shards.reset(new (std::nothrow) allocation_shard_t[threads]);
+    recorder.rings.reset(new (std::nothrow) flight_ring_t[threads]);
+    if (!stats.shards || !allocations.shards || !recorder.rings)
+        return false;
+    stats.shards_count = allocations.shards_count = recorder.rings_count = threads;
+
+    if (config.slow_request_micro_seconds) {
+        std::size_t prefix_bytes =
+            (std::min<std::size_t>)(config.slow_request_prefix_bytes, slow_request_prefix_capacity_k);
+        slow_requests.rings.reset(new (std::nothrow) slow_request_ring_t[threads]);
+        slow_requests.prefixes.reset(new (std::nothrow) char[prefix_bytes * config.max_concurrent_connections]);
+        if (!slow_requests.rings || (prefix_bytes && !slow_requests.prefixes))
+            return false;
+        slow_requests.rings_count = threads;
+        slow_requests.prefix_bytes = prefix_bytes;
+        slow_request_ns = config.slow_request_micro_seconds * 1'000ull;
+    }
+    if (config.access_log_file_descriptor > 0) {
+        access_log.rings.reset(new (std::nothrow) access_ring_t[threads]);
+        if (!access_log.rings)
+            return false;
+        access_log.rings_count = threads;
+    }
+    if (config.trace_export_file_descriptor > 0) {
+        spans.rings.reset(new (std::nothrow) span_ring_t[threads]);
+        spans.ids.reset(new (std::nothrow) span_ids_t[threads]);
+        if (!spans.rings || !spans.ids)
+            return false;
+        spans.rings_count = threads;
+        engine.span_ids = spans.ids.get();
+    }
+    if (config.perf_sampling_rate) {
+        engine.perf_groups.reset(new (std::nothrow) perf_group_t[threads]);
+        if (!engine.perf_groups)
+            return false;
+        engine.perf_sampling_rate = config.perf_sampling_rate;
+    }
+    if (config.tcp_info_period_micro_seconds) {
+        transport.shards.reset(new (std::nothrow) transport_shard_t[threads]);
+        if (!transport.shards)
+            return false;
+        transport.shards_count = threads;
+        transport.period_ns = config.tcp_info_period_micro_seconds * 1'000ull;
+    }
+    if (config.capture_path) {
+        capture = std::make_unique<capture_log_t>();
+        if (capture->open(config.capture_path, config.protocol, threads) != 0)
+            return false;
+    }
+
+    logs_period_ns = config.logs_period_milli_seconds * 1'000'000ull;
+    metrics_path = config.metrics_path ? std::string_view(config.metrics_path) : std::string_view();
+    return true;
+}
+
+/// @brief Restores the signal handler, which belongs to the whole process, before the writers are stopped.
+server_t::~server_t() noexcept {
+#if !defined(UCALL_IS_WINDOWS)
+    if (flight_dump_signal)
+        sigaction(flight_dump_signal, &previous_flight_dump_action, nullptr);
+#endif
+}
+
+/// @brief Starts the writer threads of the enabled features, once the server is fully initialized.
+void server_t::start_features(ucall_config_t const& config) noexcept {
+#if !defined(UCALL_IS_WINDOWS)
+    if (config.flight_dump_signal) {
+        struct sigaction action {};
+        action.sa_handler = &flight_recorder_t::request_dump;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        if (sigaction(config.flight_dump_signal, &action, &previous_flight_dump_action) == 0)
+            flight_dump_signal = config.flight_dump_signal;
+    }
+#endif
+    if (slow_request_ns)
+        slow_requests.start(flight_dump_descriptor(), logs_format == "json", &recorder);
+    if (access_log.rings_count)
+        access_log.start(config.access_log_file_descriptor);
+    if (spans.rings_count)
+        spans.start(config.trace_export_file_descriptor);
+}
+
 void server_t::submit_stats_heartbeat() noexcept {
     connection_t& connection = stats_pseudo_connection;
     connection.stage = stage_t::log_stats_k;
-    connection.next_wakeup = stats_t::default_frequency_secs_k;
+    connection.next_wakeup = static_cast<ssize_t>(logs_period_ns);
 
     network_engine.set_stats_heartbeat(connection);
 }
 
 void server_t::log_and_reset_stats() noexcept {
-    static char printed_message_k[ram_page_size_k]{};
-    auto len = logs_format == "json" //
-                   ? stats.log_json(printed_message_k, ram_page_size_k)
-                   : stats.log_human_readable(printed_message_k, ram_page_size_k, stats_t::default_frequency_secs_k);
+    // Per-method lines are printed separately, so that the JSON object can wrap them.
+    static char printed_methods_k[ram_page_size_k * 4]{};
+    static char printed_extras_k[ram_page_size_k]{};
+    static char printed_message_k[sizeof(printed_methods_k) + sizeof(printed_extras_k) + ram_page_size_k]{};
+    static constexpr std::string_view methods_key_k = R"(,"methods":)";
+    bool is_json = logs_format == "json";
+    // Heartbeats can be late on a busy thread, so rates are normalized by the actual interval.
+    std::uint64_t now = cycle_clock_t::now_ns();
+    double seconds = (stats.logged_ns ? now - stats.logged_ns : logs_period_ns) / 1e9;
+    stats.logged_ns = now;
+    std::size_t methods_len = engine.log_methods(printed_methods_k + methods_key_k.size(),
+                                                 sizeof(printed_methods_k) - methods_key_k.size(), is_json);
+    if (is_json) {
+        std::string_view methods{};
+        if (methods_len) {
+            std::memcpy(printed_methods_k, methods_key_k.data(), methods_key_k.size());
+            methods = {printed_methods_k, methods_key_k.size() + methods_len};
+        }
+        std::size_t extras_len = transport.log_json(printed_extras_k, sizeof(printed_extras_k));
+        extras_len += allocations.log_json(printed_extras_k + extras_len, sizeof(printed_extras_k) - extras_len);
+        if (capture)
+            extras_len += capture->log_json(printed_extras_k + extras_len, sizeof(printed_extras_k) - extras_len);
+        auto len = stats.log_json(printed_message_k, sizeof(printed_message_k), methods,
+                                  {printed_extras_k, extras_len});
+        len = write(logs_file_descriptor, printed_message_k, len);
+        return;
+    }
+    auto len = stats.log_human_readable(printed_message_k, sizeof(printed_message_k), seconds);
+    len += transport.log_human_readable(printed_message_k + len, sizeof(printed_message_k) - len);
+    len += allocations.log_human_readable(printed_message_k + len, sizeof(printed_message_k) - len);
+    if (capture)
+        len += capture->log_human_readable(printed_message_k + len, sizeof(printed_message_k) - len);
     len = write(logs_file_descriptor, printed_message_k, len);
+    len = write(logs_file_descriptor, printed_methods_k + methods_key_k.size(), methods_len);
 }
 
-void server_t::release_connection(connection_t& connection) noexcept {
+int server_t::flight_dump_descriptor() const noexcept {
+    return logs_file_descriptor > 0 ? logs_file_descriptor : STDERR_FILENO;
+}
+
+void server_t::log_slow_request(connection_t& connection, std::uint16_t thread_idx, std::uint64_t now_ns) noexcept {
+    slow_request_t* request = slow_requests.reserve(thread_idx);
+    if (!request)
+        return;
+
+    std::uint32_t connection_offset = static_cast<std::uint32_t>(connections.offset_of(connection));
+    request->received_ns = connection.request_started_ns;
+    request->dispatched_ns = connection.request_dispatched_ns;
+    request->replied_ns = connection.request_replied_ns;
+    request->sent_ns = now_ns;
+    request->method = connection.method_name;
+    request->client_address = connection.client_address;
+    request->connection = connection_offset;
+    request->request_bytes = connection.request_bytes;
+    request->reply_bytes = static_cast<std::uint32_t>(connection.pipes.output_span().size());
+    request->prefix_length =
+        static_cast<std::uint32_t>((std::min<std::size_t>)(slow_requests.prefix_bytes, connection.request_bytes));
+    if (request->prefix_length)
+        std::memcpy(request->prefix, slow_requests.prefixes.get() + connection_offset * slow_requests.prefix_bytes,
+                    request->prefix_length);
+    // Slow requests are already rate-limited by their queues, and always carry the state of their connections.
+    request->has_transport = sample_transport(connection.descriptor, request->transport);
+    slow_requests.commit(thread_idx);
+}
+
+void server_t::record_transport(connection_t& connection, std::uint16_t thread_idx) noexcept {
+    transport_sample_t sample;
+    if (!sample_transport(connection.descriptor, sample))
+        return;
+    std::uint32_t new_retransmits =
+        sample.retransmits > connection.sampled_retransmits ? sample.retransmits - connection.sampled_retransmits : 0;
+    connection.sampled_retransmits = sample.retransmits;
+    transport.record(thread_idx, sample, new_retransmits);
+}
+
+void server_t::log_access(connection_t& connection, std::uint16_t thread_idx, std::uint64_t now_ns,
+                          std::uint64_t latency_ns) noexcept {
+    access_record_t* record = access_log.reserve(thread_idx);
+    if (!record)
+        return;
+
+    record->finished_ns = now_ns;
+    record->latency_ns = latency_ns;
+    record->method = connection.method_name;
+    record->client_address = connection.client_address;
+    record->request_bytes = connection.request_bytes;
+    record->reply_bytes = static_cast<std::uint32_t>(connection.pipes.output_span().size());
+    record->status = connection.reply_error_code;
+    record->thread_idx = thread_idx;
+    access_log.commit(thread_idx);
+}
+
+void server_t::export_span(connection_t& connection, std::uint16_t thread_idx, std::uint64_t now_ns) noexcept {
+    span_t* span = spans.reserve(thread_idx);
+    if (!span)
+        return;
+
+    traced_call_t const& trace = connection.trace;
+    span->context = trace.context;
+    span->method = connection.method_name;
+    span->received_ns = connection.request_started_ns;
+    span->dispatched_ns = connection.request_dispatched_ns;
+    span->called_ns = trace.called_ns;
+    span->returned_ns = trace.returned_ns;
+    // Deferred replies are serialized by whichever thread submits them, and that time is attributed to sending.
+    span->serialized_ns = trace.serialized_ns ? trace.serialized_ns : trace.returned_ns;
+    span->sent_ns = now_ns;
+    span->request_bytes = connection.request_bytes;
+    span->reply_bytes = static_cast<std::uint32_t>(connection.pipes.output_span().size());
+    span->status = connection.reply_error_code;
+    spans.commit(thread_idx);
+}
+
+void server_t::record_allocations(connection_t& connection, std::uint16_t thread_idx) noexcept {
+    allocations.record(thread_idx, allocation_site_t::input_k, connection.pipes.take_input_allocations());
+    allocations.record(thread_idx, allocation_site_t::output_k, connection.pipes.take_output_allocations());
+    allocations.record(thread_idx, allocation_site_t::parser_k, connection.protocol.take_parser_allocations());
+}
+
+void server_t::release_connection(connection_t& connection, std::uint16_t thread_idx) noexcept {
     auto is_active = connection.stage != stage_t::waiting_to_accept_k;
+    // Requests that never completed may still have allocated.
+    record_allocations(connection, thread_idx);
     connection.reset();
     connections_mutex.lock();
     connections.release(&connection);
     connections_mutex.unlock();
     active_connections -= is_active;
-    stats.closed_connections.fetch_add(is_active, std::memory_order_relaxed);
+    stats.shard(thread_idx).closed_connections.add(is_active);
+}
+
+void server_t::submit_deferred_reply(connection_t& connection) noexcept {
+    UCALL_PROBE4(reply, static_cast<std::uint32_t>(connections.offset_of(connection)), connection.method_name.data(),
+                 connection.method_name.size(), connection.pipes.output_span().size());
+    connection.protocol.finalize_response(connection.pipes);
+    if (slow_request_ns)
+        connection.request_replied_ns = cycle_clock_t::now_ns();
+    // The callback that deferred the reply may still be returning on the polling thread.
+    if (!connection.deferred_handoff.exchange(true, std::memory_order_acq_rel))
+        return;
+
+    deferred_replies_mutex.lock();
+    deferred_replies.push_back_reserved(&connection);
+    deferred_replies_count.store(deferred_replies.size(), std::memory_order_release);
+    deferred_replies_mutex.unlock();
+    network_engine.interrupt();
+}
+
+template <std::size_t max_count_ak> std::size_t server_t::pop_deferred_replies(connection_t** connections) noexcept {
+    if (!deferred_replies_count.load(std::memory_order_acquire))
+        return 0;
+
+    deferred_replies_mutex.lock();
+    std::size_t count = (std::min)(deferred_replies.size(), max_count_ak);
+    std::memcpy(connections, deferred_replies.end() - count, count * sizeof(connection_t*));
+    deferred_replies.pop_back(count);
+    deferred_replies_count.store(deferred_replies.size(), std::memory_order_release);
+    deferred_replies_mutex.unlock();
+    return count;
 }
 
 bool server_t::consider_accepting_new_connection() noexcept {
@@ -15,6 +15,7 @@
 #include <cstring>
 #include <memory>
 #include <string_view> // `std::string_view`
+#include <variant>     // `std::variant`
 
 #if defined(__x86_64__)
 #ifdef _MSC_VER
@@ -39,6 +40,32 @@ inline std::size_t string_length(char const* c_str, std::size_t optional_length)
     return c_str && !optional_length ? std::strlen(c_str) : optional_length;
 }
 
+/**
+ * @brief Escapes arbitrary bytes into the body of a JSON string, replacing binary and control ones with `\u00XX`.
+ * @return The number of bytes written, stopping before the first character that doesn't fit.
+ */
+inline std::size_t escape_json_string(char const* input, std::size_t length, char* buffer,
+                                      std::size_t capacity) noexcept {
+    constexpr char hex_k[] = "0123456789abcdef";
+    std::size_t escaped = 0;
+    for (std::size_t i = 0; i != length; ++i) {
+        unsigned char c = static_cast<unsigned char>(input[i]);
+        char sequence[6] = {static_cast<char>(c)};
+        std::size_t sequence_length = 1;
+        if (c == '"' || c == '\\') {
+            sequence[0] = '\\', sequence[1] = static_cast<char>(c), sequence_length = 2;
+        } else if (c < 0x20 || c >= 0x7F) {
+            std::memcpy(sequence, "\\u00", 4);
+            sequence[4] = hex_k[c >> 4], sequence[5] = hex_k[c & 15], sequence_length = 6;
+        }
+        if (escaped + sequence_length > capacity)
+            break;
+        std::memcpy(buffer + escaped, sequence, sequence_length);
+        escaped += sequence_length;
+    }
+    return escaped;
+}
+
 /**
  * @brief Rounds integer to the next multiple of a given number. Is needed for aligned memory allocations.
  */
@@ -58,6 +85,7 @@ enum class stage_t {
     waiting_to_accept_k = 0,
     expecting_reception_k,
     responding_in_progress_k,
+    awaiting_deferred_reply_k,
     waiting_to_close_k,
     log_stats_k,
     unknown_k,
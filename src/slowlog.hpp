@@ -0,0 +1,136 @@
+#pragma once
+
+#include <arpa/inet.h>  // `inet_ntop`
+#include <netinet/in.h> // `sockaddr_in`
+
+#include <cstdint>     // `std::uint64_t`
+#include <cstring>     // `std::memcpy`
+#include <memory>      // `std::unique_ptr`
+#include <stdio.h>     // `std::snprintf`
+#include <string_view> // `std::string_view`
+
+#include "recorder.hpp"
+#include "shared.hpp"
+#include "transport.hpp"
+#include "writer.hpp"
+
+namespace unum::ucall {
+
+/// @brief Slow requests, that every polling thread can queue before the writer catches up. Must be a power of two.
+static constexpr std::size_t slow_request_ring_capacity_k = 256;
+/// @brief Longest prefix of a request, that can be remembered for the log.
+static constexpr std::size_t slow_request_prefix_capacity_k = 256;
+/// @brief Slow requests printed with a single `writev`.
+static constexpr std::size_t slow_request_batch_k = 4;
+/// @brief Longest printed entry, fitting any escaped prefix and dozens of flight recorder events.
+static constexpr std::size_t slow_request_line_capacity_k = ram_page_size_k * 4;
+
+struct slow_request_t {
+    std::uint64_t received_ns;
+    std::uint64_t dispatched_ns;
+    std::uint64_t replied_ns;
+    std::uint64_t sent_ns;
+    /// @brief Name of the last method called, pointing into the callbacks of the server, or empty.
+    std::string_view method;
+    struct sockaddr client_address;
+    std::uint32_t connection;
+    std::uint32_t request_bytes;
+    std::uint32_t reply_bytes;
+    std::uint32_t prefix_length;
+    char prefix[slow_request_prefix_capacity_k];
+    /// @brief State of the TCP connection once the reply was sent, unless it couldn't be read.
+    transport_sample_t transport;
+    bool has_transport;
+};
+
+/**
+ * @brief Prints a slow request with its timings per stage and its prefix, followed by the flight recorder
+ * events of the same request, as many as fit the line.
+ */
+struct slow_request_printer_t {
+    bool json{};
+    flight_recorder_t const* recorder{};
+
+    std::size_t print(slow_request_t const& request, char* line) const noexcept {
+        char client[INET_ADDRSTRLEN]{};
+        unsigned port = 0;
+        if (request.client_address.sa_family == AF_INET) {
+            auto const& address = reinterpret_cast<sockaddr_in const&>(request.client_address);
+            inet_ntop(AF_INET, &address.sin_addr, client, sizeof(client));
+            port = ntohs(address.sin_port);
+        }
+
+        char prefix[slow_request_prefix_capacity_k * 6];
+        std::size_t prefix_len = escape_json_string(request.prefix, request.prefix_length, prefix, sizeof(prefix));
+        char method[ram_page_size_k / 2];
+        std::size_t method_len =
+            escape_json_string(request.method.data(), request.method.size(), method, sizeof(method));
+        auto ns = [](std::uint64_t from, std::uint64_t to) noexcept {
+            return static_cast<unsigned long long>(to > from ? to - from : 0);
+        };
+        auto format = json ? R"({"slow_request":{"connection":%u,"method":"%.*s","client":"%s:%u",)"
+                             R"("request_bytes":%u,"reply_bytes":%u,"total_ns":%llu,)"
+                             R"("receive_ns":%llu,"callback_ns":%llu,"send_ns":%llu,%s"prefix":"%.*s"}})"
+                             "\n"
+                           : "slow request: connection %u, method %.*s, client %s:%u, "
+                             "%u bytes in, %u bytes out, %llu ns total, "
+                             "receive %llu ns, callback %llu ns, send %llu ns, %sprefix \"%.*s\" \n";
+        char transport[ram_page_size_k / 4]{};
+        transport_sample_t const& tcp = request.transport;
+        if (request.has_transport)
+            snprintf(transport, sizeof(transport),
+                     json ? R"("rtt_us":%u,"rtt_var_us":%u,"cwnd":%u,"retransmits":%u,"send_backlog_bytes":%u,)"
+                          : "RTT %u us, RTT variance %u us, cwnd %u, %u retransmits, %u bytes unacknowledged, ",
+                     tcp.rtt_us, tcp.rtt_variance_us, tcp.congestion_window, tcp.retransmits, tcp.send_backlog_bytes);
+        auto len = snprintf( //
+            line, slow_request_line_capacity_k, format, request.connection,
+            static_cast<int>(method_len), method, client, port,                                            //
+            request.request_bytes, request.reply_bytes, ns(request.received_ns, request.sent_ns),          //
+            ns(request.received_ns, request.dispatched_ns), ns(request.dispatched_ns, request.replied_ns), //
+            ns(request.replied_ns, request.sent_ns), transport, static_cast<int>(prefix_len), prefix       //
+        );
+        if (len < 0)
+            return 0;
+        std::size_t length = (std::min)(static_cast<std::size_t>(len), slow_request_line_capacity_k - 1);
+        return length + recorder->print(line + length, slow_request_line_capacity_k - length, json,
+                                        request.connection, request.received_ns, request.sent_ns);
+    }
+
+    std::size_t print_dropped(std::size_t dropped, char* line) const noexcept {
+        auto len = snprintf(line, slow_request_line_capacity_k,
+                            json ? R"({"slow_requests_dropped":%zu})"
+                                   "\n"
+                                 : "slow requests: %zu dropped \n",
+                            dropped);
+        return len < 0 ? 0 : static_cast<std::size_t>(len);
+    }
+};
+
+using slow_request_writer_t = batched_writer_gt<slow_request_t, slow_request_printer_t, slow_request_ring_capacity_k,
+                                                slow_request_batch_k, slow_request_line_capacity_k>;
+using slow_request_ring_t = slow_request_writer_t::ring_t;
+
+/**
+ * @brief Opt-in log of the requests slower than a threshold, with their timings per stage and prefixes.
+ * Polling threads only copy the request into their own queue, and a separate writer thread formats
+ * and prints them, followed by the flight recorder events of the same request.
+ */
+struct slow_request_log_t : public slow_request_writer_t {
+    /// @brief Prefixes of the requests being served, `prefix_bytes` for every connection in the pool.
+    std::unique_ptr<char[]> prefixes{};
+    std::size_t prefix_bytes{};
+
+    /// @brief Copies the beginning of the request, before its inputs are released.
+    void remember_prefix(std::uint32_t connection, std::string_view input) noexcept {
+        if (prefix_bytes)
+            std::memcpy(prefixes.get() + connection * prefix_bytes, input.data(),
+                        (std::min)(input.size(), prefix_bytes));
+    }
+
+    void start(int file_descriptor, bool json, flight_recorder_t const* recorder) noexcept {
+        printer.json = json, printer.recorder = recorder;
+        slow_request_writer_t::start(file_descriptor);
+    }
+};
+
+} // namespace unum::ucall
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <sys/socket.h> // `getsockopt`
+
+#include <cstdint>     // `std::uint64_t`
+#include <cstring>     // `std::memcpy`
+#include <memory>      // `std::unique_ptr`
+#include <stdio.h>     // `std::snprintf`
+#include <string_view> // `std::string_view`
+
+#include "clock.hpp"
+#include "shared.hpp"
+#include "writer.hpp"
+
+namespace unum::ucall {
+
+/// @brief Spans, that every polling thread can queue before the exporter catches up. Must be a power of two.
+static constexpr std::size_t span_ring_capacity_k = 1024;
+/// @brief Spans exported with a single `writev`, or a single datagram.
+static constexpr std::size_t span_batch_k = 32;
+/// @brief Longest method name exported, before escaping.
+static constexpr std::size_t span_method_capacity_k = 128;
+/// @brief Longest exported line, fitting any escaped method name.
+static constexpr std::size_t span_line_capacity_k = span_method_capacity_k * 6 + 512;
+/// @brief Largest UDP payload, to split batches exported into datagram sockets.
+static constexpr std::size_t span_datagram_capacity_k = 65'507;
+
+/// @brief W3C trace context of a call, with the ID of the server span, that it has started.
+struct trace_context_t {
+    std::uint8_t trace_id[16]{};
+    std::uint8_t parent_span_id[8]{};
+    std::uint8_t span_id[8]{};
+    std::uint8_t flags{};
+
+    bool is_sampled() const noexcept { return flags & 1; }
+};
+
+inline bool parse_hex(char const* hex, std::size_t bytes, std::uint8_t* output) noexcept {
+    auto nibble = [](char c) noexcept -> int {
+        return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+    };
+    std::uint8_t any_bits = 0;
+    for (std::size_t i = 0; i != bytes; ++i) {
+        int high = nibble(hex[i * 2]), low = nibble(hex[i * 2 + 1]);
+        if (high < 0 || low < 0)
+            return false;
+        output[i] = static_cast<std::uint8_t>(high << 4 | low);
+        any_bits |= output[i];
+    }
+    // All-zero IDs are invalid.
+    return any_bits != 0;
+}
+
+/**
+ * @brief Parses a "traceparent" like "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01".
+ * Future versions may append fields, which are ignored, as the specification suggests.
+ */
+inline bool parse_traceparent(std::string_view text, trace_context_t& context) noexcept {
+    constexpr std::size_t length_k = 55;
+    if (text.size() < length_k || text[2] != '-' || text[35] != '-' || text[52] != '-')
+        return false;
+    // Unlike the IDs, the version and the flags may be zeros.
+    auto parse_byte = [](char const* hex, std::uint8_t& output) noexcept {
+        output = 0;
+        return (hex[0] == '0' && hex[1] == '0') || parse_hex(hex, 1, &output);
+    };
+    std::uint8_t version, flags;
+    if (!parse_byte(text.data(), version) || !parse_byte(text.data() + 53, flags))
+        return false;
+    // Version 255 is forbidden, and only the future ones may append fields.
+    bool is_extended = text.size() > length_k;
+    if (version == 0xFF || (is_extended && (version == 0 || text[length_k] != '-')))
+        return false;
+    trace_context_t parsed{};
+    if (!parse_hex(text.data() + 3, 16, parsed.trace_id) || !parse_hex(text.data() + 36, 8, parsed.parent_span_id))
+        return false;
+    parsed.flags = flags;
+    context = parsed;
+    return true;
+}
+
+/**
+ * @brief Generator of span IDs for a single polling thread, occupying its own cache line.
+ * A SplitMix64 sequence, seeded from the clock and the thread, is unique enough for tracing.
+ */
+struct alignas(64) span_ids_t {
+    std::uint64_t state{};
+
+    void next(std::uint8_t* span_id) noexcept {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        // Zero is reserved for invalid IDs.
+        z |= !z;
+        std::memcpy(span_id, &z, sizeof(z));
+    }
+};
+
+/// @brief A call being traced, and the timestamps of its stages, on the `cycle_clock_t` scale.
+struct traced_call_t {
+    trace_context_t context{};
+    /// @brief Set once a valid "traceparent" is found, even if the caller hasn't sampled it.
+    bool has_context{};
+
+    bool is_sampled() const noexcept { return has_context && context.is_sampled(); }
+    std::uint64_t called_ns{};
+    std::uint64_t returned_ns{};
+    std::uint64_t serialized_ns{};
+};
+
+struct span_t {
+    trace_context_t context;
+    /// @brief Name of the method, pointing into the callbacks of the server, or empty.
+    std::string_view method;
+    std::uint64_t received_ns;
+    std::uint64_t dispatched_ns;
+    std::uint64_t called_ns;
+    std::uint64_t returned_ns;
+    std::uint64_t serialized_ns;
+    std::uint64_t sent_ns;
+    std::uint32_t request_bytes;
+    std::uint32_t reply_bytes;
+    /// @brief Code of the last error replied, or zero if the request succeeded.
+    std::int32_t status;
+};
+
+/**
+ * @brief Prints a span as a single NDJSON line, timestamped in the Unix time.
+ */
+struct span_printer_t {
+    /// @brief Spans are timestamped with the cycle counter, and exported in the Unix time.
+    std::uint64_t unix_offset_ns{};
+
+    std::size_t print(span_t const& span, char* line) const noexcept {
+        auto hex = [](std::uint8_t const* bytes, std::size_t count, char* output) noexcept {
+            constexpr char digits_k[] = "0123456789abcdef";
+            for (std::size_t i = 0; i != count; ++i)
+                output[i * 2] = digits_k[bytes[i] >> 4], output[i * 2 + 1] = digits_k[bytes[i] & 15];
+            output[count * 2] = 0;
+        };
+        char trace_id[33], span_id[17], parent_span_id[17];
+        hex(span.context.trace_id, 16, trace_id);
+        hex(span.context.span_id, 8, span_id);
+        hex(span.context.parent_span_id, 8, parent_span_id);
+        char method[span_method_capacity_k * 6];
+        std::size_t method_len = escape_json_string(
+            span.method.data(), (std::min)(span.method.size(), span_method_capacity_k), method, sizeof(method));
+        auto ns = [](std::uint64_t from, std::uint64_t to) noexcept {
+            return static_cast<unsigned long long>(to > from ? to - from : 0);
+        };
+        auto unix_ns = [&](std::uint64_t ns) noexcept { return static_cast<unsigned long long>(ns + unix_offset_ns); };
+        auto len = snprintf( //
+            line, span_line_capacity_k,
+            R"({"trace_id":"%s","span_id":"%s","parent_span_id":"%s","name":"%.*s","kind":"server",)"
+            R"("start_unix_ns":%llu,"end_unix_ns":%llu,"status":%d,"request_bytes":%u,"reply_bytes":%u,)"
+            R"("stages_ns":{"receive":%llu,"parse":%llu,"dispatch":%llu,"serialize":%llu,"send":%llu}})"
+            "\n",
+            trace_id, span_id, parent_span_id, static_cast<int>(method_len), method,          //
+            unix_ns(span.received_ns), unix_ns(span.sent_ns), span.status,                    //
+            span.request_bytes, span.reply_bytes,                                             //
+            ns(span.received_ns, span.dispatched_ns), ns(span.dispatched_ns, span.called_ns), //
+            ns(span.called_ns, span.returned_ns), ns(span.returned_ns, span.serialized_ns),   //
+            ns(span.serialized_ns, span.sent_ns)                                              //
+        );
+        return len < 0 ? 0 : (std::min)(static_cast<std::size_t>(len), span_line_capacity_k - 1);
+    }
+
+    std::size_t print_dropped(std::size_t dropped, char* line) const noexcept {
+        auto len = snprintf(line, span_line_capacity_k, "{\"dropped_spans\":%zu}\n", dropped);
+        return len < 0 ? 0 : static_cast<std::size_t>(len);
+    }
+};
+
+using span_writer_t =
+    batched_writer_gt<span_t, span_printer_t, span_ring_capacity_k, span_batch_k, span_line_capacity_k>;
+using span_ring_t = span_writer_t::ring_t;
+
+/**
+ * @brief Opt-in exporter of the server spans of sampled calls, as NDJSON lines, into a file or a UDP socket.
+ * With a connected datagram socket, every batch is a single datagram.
+ */
+struct span_exporter_t : public span_writer_t {
+    std::unique_ptr<span_ids_t[]> ids{};
+
+    void start(int file_descriptor) noexcept {
+        int type = 0;
+        socklen_t type_length = sizeof(type);
+        bool is_datagram =
+            getsockopt(file_descriptor, SOL_SOCKET, SO_TYPE, &type, &type_length) == 0 && type == SOCK_DGRAM;
+        printer.unix_offset_ns = cycle_clock_t::unix_offset_ns();
+        std::uint64_t seed = cycle_clock_t::now_ns() + printer.unix_offset_ns;
+        for (std::size_t i = 0; i != rings_count; ++i)
+            ids[i].state = seed ^ (i << 48);
+        span_writer_t::start(file_descriptor, is_datagram ? span_datagram_capacity_k : SIZE_MAX);
+    }
+};
+
+} // namespace unum::ucall
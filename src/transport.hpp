@@ -0,0 +1,183 @@
+#pragma once
+
+#include "globals.hpp"
+
+#if defined(UCALL_IS_LINUX)
+#include <linux/sockios.h> // `SIOCOUTQ`
+#include <netinet/in.h>    // `IPPROTO_TCP`
+#include <netinet/tcp.h>   // `TCP_INFO`
+#include <sys/ioctl.h>     // `ioctl`
+#include <sys/socket.h>    // `getsockopt`
+#endif
+
+#include <cstdint>     // `std::uint64_t`
+#include <memory>      // `std::unique_ptr`
+#include <stdio.h>     // `std::snprintf`
+#include <string_view> // `std::string_view`
+
+#include "histogram.hpp"
+#include "log.hpp"
+
+namespace unum::ucall {
+
+/// @brief State of the TCP connection of a client, as seen by the kernel.
+struct transport_sample_t {
+    /// @brief Smoothed round-trip time and its variance, estimated by the kernel.
+    std::uint32_t rtt_us{};
+    std::uint32_t rtt_variance_us{};
+    /// @brief Congestion window, in segments.
+    std::uint32_t congestion_window{};
+    /// @brief Segments retransmitted since the connection was opened.
+    std::uint32_t retransmits{};
+    /// @brief Bytes written into the socket, but not yet acknowledged by the client.
+    std::uint32_t send_backlog_bytes{};
+};
+
+/// @brief Reads the state of a TCP socket with a `getsockopt` and an `ioctl`, a couple of microseconds at most.
+inline bool sample_transport(descriptor_t descriptor, transport_sample_t& sample) noexcept {
+#if defined(UCALL_IS_LINUX)
+    struct tcp_info info {};
+    socklen_t info_length = sizeof(info);
+    if (getsockopt(static_cast<int>(descriptor), IPPROTO_TCP, TCP_INFO, &info, &info_length) != 0)
+        return false;
+    int backlog = 0;
+    if (ioctl(static_cast<int>(descriptor), SIOCOUTQ, &backlog) != 0)
+        backlog = 0;
+    sample.rtt_us = info.tcpi_rtt;
+    sample.rtt_variance_us = info.tcpi_rttvar;
+    sample.congestion_window = info.tcpi_snd_cwnd;
+    sample.retransmits = info.tcpi_total_retrans;
+    sample.send_backlog_bytes = static_cast<std::uint32_t>(backlog);
+    return true;
+#else
+    (void)descriptor, (void)sample;
+    return false;
+#endif
+}
+
+/// @brief Transport histograms keep ~3% precision, like the per-method ones.
+using transport_histogram_t = histogram_gt<6>;
+using owned_transport_histogram_t = owned_histogram_gt<6>;
+
+/**
+ * @brief Transport states sampled by a single polling thread, occupying their own cache lines.
+ */
+struct alignas(64) transport_shard_t {
+    owned_transport_histogram_t rtt_us{};
+    owned_transport_histogram_t congestion_window{};
+    owned_transport_histogram_t send_backlog_bytes{};
+    owned_counter_t samples{};
+    /// @brief Growth of the retransmitted segments of the sampled connections, between their samples.
+    owned_counter_t retransmits{};
+    /// @brief When this thread may sample again, only accessed by its owner.
+    std::uint64_t next_sample_ns{};
+};
+
+/**
+ * @brief Opt-in sampling of the TCP state of the clients, to tell network problems apart from slow callbacks.
+ * Every thread samples at most one connection per period, whichever finishes a request first,
+ * so the cost is bounded regardless of the load, and busier connections are sampled more often.
+ */
+struct transport_stats_t {
+    std::unique_ptr<transport_shard_t[]> shards{};
+    std::size_t shards_count{};
+    /// @brief Minimal interval between the samples of every thread, or zero if disabled.
+    std::uint64_t period_ns{};
+    /// @brief Totals at the time of the last log.
+    std::uint64_t logged_rtt[transport_histogram_t::buckets_k]{};
+    std::uint64_t logged_congestion_window[transport_histogram_t::buckets_k]{};
+    std::uint64_t logged_send_backlog[transport_histogram_t::buckets_k]{};
+    std::uint64_t logged_samples{};
+    std::uint64_t logged_retransmits{};
+
+    bool is_enabled() const noexcept { return period_ns != 0; }
+
+    bool should_sample(std::size_t thread_idx, std::uint64_t now_ns) noexcept {
+        if (!period_ns)
+            return false;
+        transport_shard_t& shard = shards[thread_idx];
+        if (now_ns < shard.next_sample_ns)
+            return false;
+        shard.next_sample_ns = now_ns + period_ns;
+        return true;
+    }
+
+    void record(std::size_t thread_idx, transport_sample_t const& sample, std::uint32_t new_retransmits) noexcept {
+        transport_shard_t& shard = shards[thread_idx];
+        shard.rtt_us.record(sample.rtt_us);
+        shard.congestion_window.record(sample.congestion_window);
+        shard.send_backlog_bytes.record(sample.send_backlog_bytes);
+        shard.samples.add(1);
+        shard.retransmits.add(new_retransmits);
+    }
+
+    /// @brief Prints the samples since the previous call, or nothing if there were none.
+    std::size_t log_human_readable(char* buffer, std::size_t buffer_capacity) noexcept {
+        transport_histogram_t rtt, congestion_window, send_backlog;
+        std::uint64_t retransmits = 0;
+        if (!collect(rtt, congestion_window, send_backlog, retransmits))
+            return 0;
+        auto n = [](std::uint64_t value) noexcept { return static_cast<std::size_t>(value); };
+        auto len = snprintf( //
+            buffer, buffer_capacity,
+            "transport: %zu sampled, RTT p50 %zu, p99 %zu, max %zu us, cwnd p50 %zu, p1 %zu segments, "
+            "send backlog p50 %zu, p99 %zu bytes, %zu retransmits. \n",
+            n(rtt.count()), n(rtt.percentile(50)), n(rtt.percentile(99)), n(rtt.max()),    //
+            n(congestion_window.percentile(50)), n(congestion_window.percentile(1)),       //
+            n(send_backlog.percentile(50)), n(send_backlog.percentile(99)), n(retransmits) //
+        );
+        return len < 0 ? 0 : (std::min)(static_cast<std::size_t>(len), buffer_capacity - 1);
+    }
+
+    /// @brief Prints the samples since the previous call as a `,"transport":{...}` member, or nothing.
+    std::size_t log_json(char* buffer, std::size_t buffer_capacity) noexcept {
+        transport_histogram_t rtt, congestion_window, send_backlog;
+        std::uint64_t retransmits = 0;
+        if (!collect(rtt, congestion_window, send_backlog, retransmits))
+            return 0;
+        auto format = R"(,"transport":{"samples":%zu,"retransmits":%zu,)"
+                      R"("rtt_us":{"p50":%zu,"p90":%zu,"p99":%zu,"max":%zu},)"
+                      R"("cwnd":{"p1":%zu,"p10":%zu,"p50":%zu,"max":%zu},)"
+                      R"("send_backlog_bytes":{"p50":%zu,"p90":%zu,"p99":%zu,"max":%zu}})";
+        auto n = [](std::uint64_t value) noexcept { return static_cast<std::size_t>(value); };
+        auto len = snprintf( //
+            buffer, buffer_capacity, format, n(rtt.count()), n(retransmits),
+            n(rtt.percentile(50)), n(rtt.percentile(90)), n(rtt.percentile(99)), n(rtt.max()), //
+            n(congestion_window.percentile(1)), n(congestion_window.percentile(10)),           //
+            n(congestion_window.percentile(50)), n(congestion_window.max()),                   //
+            n(send_backlog.percentile(50)), n(send_backlog.percentile(90)),                    //
+            n(send_backlog.percentile(99)), n(send_backlog.max())                              //
+        );
+        return len < 0 ? 0 : (std::min)(static_cast<std::size_t>(len), buffer_capacity - 1);
+    }
+
+  private:
+    /// @brief Merges the shards into histograms of the samples since the previous call, returning false if none.
+    bool collect(transport_histogram_t& rtt, transport_histogram_t& congestion_window,
+                 transport_histogram_t& send_backlog, std::uint64_t& retransmits) noexcept {
+        std::uint64_t samples = 0, retransmits_total = 0;
+        for (std::size_t j = 0; j != shards_count; ++j)
+            samples += shards[j].samples.load(), retransmits_total += shards[j].retransmits.load();
+        if (samples == logged_samples)
+            return false;
+        retransmits = retransmits_total - logged_retransmits;
+        logged_samples = samples, logged_retransmits = retransmits_total;
+
+        auto merge = [&](owned_transport_histogram_t transport_shard_t::*member, std::uint64_t* logged,
+                         transport_histogram_t& merged) noexcept {
+            for (std::size_t i = 0; i != transport_histogram_t::buckets_k; ++i) {
+                std::uint64_t total = 0;
+                for (std::size_t j = 0; j != shards_count; ++j)
+                    total += (shards[j].*member).bucket(i);
+                merged.record_bucket(i, total - logged[i]);
+                logged[i] = total;
+            }
+        };
+        merge(&transport_shard_t::rtt_us, logged_rtt, rtt);
+        merge(&transport_shard_t::congestion_window, logged_congestion_window, congestion_window);
+        merge(&transport_shard_t::send_backlog_bytes, logged_send_backlog, send_backlog);
+        return true;
+    }
+};
+
+} // namespace unum::ucall
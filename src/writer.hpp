@@ -0,0 +1,139 @@
+#pragma once
+
+#include <sys/uio.h> // `writev`
+
+#include <atomic>  // `std::atomic`
+#include <chrono>  // `std::chrono::nanoseconds`
+#include <cstdint> // `SIZE_MAX`
+#include <cstring> // `std::memmove`
+#include <memory>  // `std::unique_ptr`
+#include <thread>  // `std::thread`
+
+#include "containers.hpp"
+
+namespace unum::ucall {
+
+/// @brief How long a background writer sleeps, once it finds all queues empty.
+static constexpr std::size_t writer_poll_ns_k{10'000'000}; // 10 ms
+
+/**
+ * @brief Thread draining the queues of a log in the background, sleeping while they are empty.
+ * Whatever was queued before stopping is still drained.
+ */
+class background_writer_t {
+    std::thread thread_{};
+    std::atomic<bool> stopping_{};
+
+  public:
+    background_writer_t() = default;
+    background_writer_t(background_writer_t const&) = delete;
+    background_writer_t& operator=(background_writer_t const&) = delete;
+    ~background_writer_t() noexcept { stop(); }
+
+    /// @param drain Called repeatedly, returning false if there was nothing to write.
+    template <typename drain_at> void start(drain_at drain) noexcept {
+        thread_ = std::thread([this, drain]() mutable {
+            while (true) {
+                bool stopping = stopping_.load(std::memory_order_relaxed);
+                if (!drain() && !stopping)
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(writer_poll_ns_k));
+                if (stopping)
+                    return;
+            }
+        });
+    }
+
+    void stop() noexcept {
+        if (!thread_.joinable())
+            return;
+        stopping_.store(true, std::memory_order_relaxed);
+        thread_.join();
+    }
+};
+
+/**
+ * @brief Opt-in log of fixed-size records, like served requests, printed into a file descriptor in batches.
+ * Polling threads only copy a record into their own queue, and a background thread prints them, issuing
+ * a single `writev` per batch. If it falls behind, records are dropped and counted, but never waited for.
+ *
+ * @tparam printer_at Prints a record with `print(record, line)`, and the number of records dropped since
+ * the previous batch with `print_dropped(count, line)`, into `line_capacity_ak` bytes, returning the length.
+ */
+template <typename record_at, typename printer_at, std::size_t ring_capacity_ak, std::size_t batch_ak,
+          std::size_t line_capacity_ak>
+class batched_writer_gt {
+  public:
+    using ring_t = spsc_ring_gt<record_at, ring_capacity_ak>;
+
+    std::unique_ptr<ring_t[]> rings{};
+    std::size_t rings_count{};
+    /// @brief Only accessed by the background thread, once started.
+    printer_at printer{};
+
+    batched_writer_gt() = default;
+    batched_writer_gt(batched_writer_gt const&) = delete;
+    batched_writer_gt& operator=(batched_writer_gt const&) = delete;
+    ~batched_writer_gt() noexcept { stop(); }
+
+    bool is_enabled() const noexcept { return rings_count != 0; }
+
+    /// @brief Returns the slot to fill for a record of @p thread_idx, or `nullptr` if it must be dropped.
+    record_at* reserve(std::size_t thread_idx) noexcept {
+        record_at* record = rings[thread_idx].reserve();
+        if (!record)
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        return record;
+    }
+
+    void commit(std::size_t thread_idx) noexcept { rings[thread_idx].commit(); }
+
+    /// @param batch_bytes Most bytes in a single `writev`, like the largest datagram of a socket.
+    void start(int file_descriptor, std::size_t batch_bytes = SIZE_MAX) noexcept {
+        file_descriptor_ = file_descriptor, batch_bytes_ = batch_bytes;
+        writer_.start([this] { return drain(); });
+    }
+
+    void stop() noexcept { writer_.stop(); }
+
+  private:
+    background_writer_t writer_{};
+    std::atomic<std::size_t> dropped_{};
+    int file_descriptor_{};
+    std::size_t batch_bytes_{SIZE_MAX};
+    char lines_[batch_ak][line_capacity_ak]{};
+
+    bool drain() noexcept {
+        iovec parts[batch_ak];
+        std::size_t parts_count = 0, parts_bytes = 0;
+        // Every line is printed into the slot of the next part, so it's moved if it has to start a new batch.
+        auto append = [&](std::size_t length) noexcept {
+            if (parts_bytes + length > batch_bytes_) {
+                flush(parts, parts_count);
+                std::memmove(lines_[0], lines_[parts_count], length);
+                parts_count = 0, parts_bytes = 0;
+            }
+            parts[parts_count] = {lines_[parts_count], length};
+            parts_bytes += length;
+            if (++parts_count == batch_ak)
+                flush(parts, parts_count), parts_count = 0, parts_bytes = 0;
+        };
+
+        bool found = false;
+        record_at record;
+        for (std::size_t thread_idx = 0; thread_idx != rings_count; ++thread_idx)
+            while (rings[thread_idx].pop(record))
+                append(printer.print(record, lines_[parts_count])), found = true;
+        if (std::size_t dropped = dropped_.exchange(0, std::memory_order_relaxed); dropped)
+            append(printer.print_dropped(dropped, lines_[parts_count]));
+        flush(parts, parts_count);
+        return found;
+    }
+
+    void flush(iovec const* parts, std::size_t count) noexcept {
+        if (count) {
+            [[maybe_unused]] ssize_t written = writev(file_descriptor_, parts, static_cast<int>(count));
+        }
+    }
+};
+
+} // namespace unum::ucall